@@ -1,7 +1,12 @@
 #include <algorithm>
+#include <atomic>
 #include <cfloat>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
 #include <sys/stat.h>
 #include <unordered_set>
 
@@ -12,8 +17,22 @@
 #include "pruners/pruner_cutoff.hpp"
 #include "pruners/pruner_epspruning.hpp"
 #include "pruners/pruner_topk.hpp"
+#include "utils/assessment_aggregation.hpp"
+#include "utils/capture.hpp"
+#include "utils/benchmark_schedule.hpp"
 #include "utils/composition.hpp"
 #include "utils/cxxopts.hpp"
+#include "utils/list_log.hpp"
+#ifdef FILTERING_MEMORY_HOOKS
+#include "utils/memory_hooks.hpp"
+#endif
+#include "utils/opt_cache.hpp"
+#include "utils/perf_counters.hpp"
+#include "utils/sampling.hpp"
+#include "utils/strategies.hpp"
+#include "utils/synthetic.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/trace.hpp"
 #include "utils/utils.hpp"
 
 
@@ -31,7 +50,24 @@ assessment(
     const int   param_num_runs = arguments["num-runs"].as<int>();
     const bool  param_check_solutions = arguments["check-solutions"].as<bool>();
     const int   param_show_progress = arguments["show-progress"].as<bool>();
+    const int   param_num_threads = arguments["threads"].as<int>();
+    const bool  param_parallel_tests = arguments["parallel-tests"].as<bool>();
+    const unsigned param_seed = arguments["seed"].as<unsigned>();
+    BenchmarkSchedule param_schedule;
+    const bool  param_scaling = arguments["scaling"].as<bool>();
+    const bool  param_synthetic = arguments.count("synthetic");
+    SyntheticListConfig param_synthetic_config;
+    std::size_t param_synthetic_lists = 0;
+    const bool  param_sample = arguments["sample"].as<bool>();
+    std::size_t param_strata = 0;
+    std::size_t param_sample_batch = 0;
+    const double param_confidence = arguments["confidence"].as<double>();
+    SamplingTargets param_targets;
+    std::vector<int> param_cpu_list;
+    std::size_t param_shard_id = 0;
+    std::size_t param_num_shards = 1;
     std::ofstream * param_ofstream = nullptr;
+    std::ofstream * param_trace_ofstream = nullptr;
 
     // check the command line parameters
     try {
@@ -97,31 +133,124 @@ assessment(
             }
         }
 
+        // param synthetic lists, as long as the longest cut if not given
+        if (param_synthetic) {
+            if (!param_file_path_list.empty()) {
+                throw std::runtime_error("The parameter synthetic cannot be used with input files");
+            }
+            index_type length = arguments["synthetic-length"].as<index_type>();
+            if (length == 0) {
+                length = *std::max_element(param_n_cut_list.begin(), param_n_cut_list.end());
+                if (length == 0) {
+                    throw std::runtime_error("The parameter synthetic requires either synthetic-length or a positive n in n_cut_list");
+                }
+            }
+            param_synthetic_config.distribution = arguments["synthetic"].as<std::string>();
+            param_synthetic_config.length = length;
+            param_synthetic_config.max_relevance = arguments["max-relevance"].as<double>();
+            param_synthetic_config.zipf_exponent = arguments["zipf-exponent"].as<double>();
+            param_synthetic_config.grades = arguments["grades"].as<int>();
+            param_synthetic_config.sortedness = arguments["sortedness"].as<double>();
+            check_synthetic_list_config(param_synthetic_config);
+            const int synthetic_lists = arguments["synthetic-lists"].as<int>();
+            if (synthetic_lists <= 0) {
+                throw std::runtime_error("The parameter synthetic-lists must be a number strictly greater than 0");
+            }
+            param_synthetic_lists = static_cast<std::size_t>(synthetic_lists);
+        }
+
+        // param sample
+        if (param_sample) {
+            if (arguments.count("shard")) {
+                throw std::runtime_error("The parameter sample cannot be used with shard");
+            }
+            const int strata = arguments["strata"].as<int>();
+            if (strata <= 0) {
+                throw std::runtime_error("The parameter strata must be a number strictly greater than 0");
+            }
+            param_strata = static_cast<std::size_t>(strata);
+            const int sample_batch = arguments["sample-batch"].as<int>();
+            if (sample_batch <= 0) {
+                throw std::runtime_error("The parameter sample-batch must be a number strictly greater than 0");
+            }
+            param_sample_batch = static_cast<std::size_t>(sample_batch);
+            if (param_confidence <= 0 || param_confidence >= 1) {
+                throw std::runtime_error("The parameter confidence must be a number between zero and one");
+            }
+            param_targets.score = arguments["target-ci-score"].as<double>();
+            param_targets.approximation_error = arguments["target-ci-error"].as<double>();
+            param_targets.total_time = arguments["target-ci-time"].as<double>();
+            if (param_targets.score < 0 || param_targets.approximation_error < 0 || param_targets.total_time < 0) {
+                throw std::runtime_error("The targets of the confidence intervals must be numbers greater or equal than 0");
+            }
+        }
+
         // param num runs
         if (arguments.count("num-runs") && param_num_runs <= 0) {
             throw std::runtime_error("The parameter runs must be a number strictly greater than 0");
         }
 
+        // param schedule
+        param_schedule.warmup_runs = arguments["warmup-runs"].as<int>();
+        if (param_schedule.warmup_runs < 0) {
+            throw std::runtime_error("The parameter warmup-runs must be a number greater or equal than 0");
+        }
+        param_schedule.cold_cache = arguments["cold-cache"].as<bool>();
+        const int flush_size = arguments["flush-size"].as<int>();
+        if (flush_size <= 0) {
+            throw std::runtime_error("The parameter flush-size must be a number strictly greater than 0");
+        }
+        param_schedule.flush_size = static_cast<std::size_t>(flush_size) * 1024 * 1024;
+        param_schedule.interleave = arguments["interleave"].as<bool>();
+        param_schedule.outlier_threshold = arguments["outlier-threshold"].as<double>();
+        if (param_schedule.outlier_threshold < 0) {
+            throw std::runtime_error("The parameter outlier-threshold must be a number greater or equal than 0");
+        }
+
+        // param threads
+        if (param_num_threads <= 0) {
+            throw std::runtime_error("The parameter threads must be a number strictly greater than 0");
+        }
+
         // set the cpu-affinity, if required
         if (arguments.count("cpu-affinity")) {
             int cpu_affinity = arguments["cpu-affinity"].as<int>();
             if (cpu_affinity > -1) {
-#ifdef __linux__
-                cpu_set_t mask;
-                int status;
-
-                CPU_ZERO(&mask);
-                CPU_SET(cpu_affinity, &mask);
-                status = sched_setaffinity(0, sizeof(mask), &mask);
-                if (status != 0) {
-                    throw std::runtime_error(std::string("Unable to set the cpu affinity: ") + std::strerror(errno));
+                if (param_num_threads > 1) {
+                    throw std::runtime_error("The parameter cpu-affinity cannot be used with more than one thread, use cpu-list instead");
                 }
-#else
-                throw std::runtime_error("The cpu affinity can be set only on linux");
-#endif
+                set_cpu_affinity(cpu_affinity);
             }
         }
 
+        // param cpu list
+        if (arguments.count("cpu-list")) {
+            param_cpu_list = read_parameter_list<int>(arguments["cpu-list"].as<std::string>());
+            if (!param_cpu_list.empty() && param_cpu_list.size() < static_cast<std::size_t>(param_num_threads)) {
+                throw std::runtime_error("The parameter cpu-list must contain at least one cpu per thread");
+            }
+            if (param_num_threads == 1 && !param_cpu_list.empty()) {
+                set_cpu_affinity(param_cpu_list[0]);
+            }
+        }
+
+        // param shard
+        if (arguments.count("shard")) {
+            std::string shard = arguments["shard"].as<std::string>();
+            std::size_t slash = shard.find('/');
+            std::istringstream shard_id_stream(shard.substr(0, slash));
+            std::istringstream num_shards_stream((slash != std::string::npos) ? shard.substr(slash + 1) : std::string());
+            long shard_id, num_shards;
+            if (!(shard_id_stream >> shard_id) || !shard_id_stream.eof() || !(num_shards_stream >> num_shards) || !num_shards_stream.eof()) {
+                throw std::runtime_error("The parameter shard must be in the format i/N");
+            }
+            if (num_shards <= 0 || shard_id < 0 || shard_id >= num_shards) {
+                throw std::runtime_error("The parameter shard must satisfy 0 <= i < N");
+            }
+            param_shard_id = static_cast<std::size_t>(shard_id);
+            param_num_shards = static_cast<std::size_t>(num_shards);
+        }
+
         // param output
         if (arguments.count("output")) {
             std::string output_file_path = arguments["output"].as<std::string>();
@@ -130,6 +259,16 @@ assessment(
                 throw std::runtime_error(std::string("Unable to open the output file ") + output_file_path);
             }
         }
+
+        // param trace
+        if (arguments.count("trace")) {
+            std::string trace_file_path = arguments["trace"].as<std::string>();
+            param_trace_ofstream = new std::ofstream(trace_file_path);
+            if (!param_trace_ofstream->is_open()) {
+                throw std::runtime_error(std::string("Unable to open the trace file ") + trace_file_path);
+            }
+            TraceRecorder::enable();
+        }
     } catch (std::runtime_error & e) {
         std::cerr << e.what() << "." << std::endl;
         return -1;
@@ -148,43 +287,117 @@ assessment(
     typedef PrunerFilterCompositionTest<ScoreFun> composition_test;
     typedef std::shared_ptr<composition_test> sh_composition_test;
 
-    sh_composition_test tests_opt[k_list_size];
-    std::vector<sh_composition_test> tests_list[k_list_size];
+    std::vector<sh_composition_test> tests_opt(k_list_size);
+    std::vector<std::vector<sh_composition_test>> tests_list(k_list_size);
 
     // loop over the different values of k
     for (std::size_t ki=0; ki < k_list_size; ++ki) {
-        k_type k = param_k_list[ki];
-
-        tests_opt[ki] = sh_composition_test(
-                new composition_test("OPT", nullptr, filters_list[ki], param_num_runs)
-        );
+        tests_opt[ki] = make_strategy_test<ScoreFun>("opt", score_fun, filters_list[ki], 0, param_num_runs);
 
         if (arguments["test-cutoff"].as<bool>()) {
-            tests_list[ki].emplace_back(sh_composition_test(
-                    new composition_test("Cutoff-OPT", std::make_shared<PrunerCutoff<ScoreFun>>(score_fun), filters_list[ki], param_num_runs, 1.0)
-            ));
+            tests_list[ki].push_back(make_strategy_test<ScoreFun>("cutoff", score_fun, filters_list[ki], 0, param_num_runs));
         }
 
         if (arguments["test-topk"].as<bool>()) {
-            tests_list[ki].emplace_back(sh_composition_test(
-                    new composition_test("Topk-OPT", std::make_shared<PrunerTopk<ScoreFun>>(score_fun, k), filters_list[ki], param_num_runs, 0.5)
-            ));
+            tests_list[ki].push_back(make_strategy_test<ScoreFun>("topk", score_fun, filters_list[ki], 0, param_num_runs));
         }
 
         if (arguments["test-epsfiltering"].as<bool>()) {
             for (auto epsilon: param_epsilon_list) {
-                std::ostringstream name; name << "EpsFiltering (epsilon=" << epsilon << ")";
-                tests_list[ki].emplace_back(sh_composition_test(
-                        new composition_test(name.str(), std::make_shared<PrunerEpsPruning<ScoreFun>>(score_fun, k, epsilon), filters_list[ki], param_num_runs, epsilon)
-                ));
+                tests_list[ki].push_back(make_strategy_test<ScoreFun>("epsfiltering", score_fun, filters_list[ki], epsilon, param_num_runs));
+            }
+        }
+    }
+
+    // collect the hardware performance counters, if required
+    if (arguments["perf-counters"].as<bool>()) {
+        if (!PerfCounterGroup::thread_instance().available()) {
+            std::cerr << "Warning: the hardware performance counters are unavailable and will not be reported." << std::endl;
+        }
+        for (std::size_t ki=0; ki < k_list_size; ++ki) {
+            tests_opt[ki]->set_collect_perf_counters(true);
+            for (const sh_composition_test &test: tests_list[ki]) {
+                test->set_collect_perf_counters(true);
+            }
+        }
+    }
+
+    // account the heap memory allocated by each stage, if required (always in scaling mode)
+    const bool param_memory_usage = arguments["memory-usage"].as<bool>() || param_scaling;
+    if (param_memory_usage) {
+        if (!MemoryAccounting::hooks_installed()) {
+            std::cerr << "Warning: the memory usage of the stages is unavailable without the build option FILTERING_MEMORY_HOOKS and will not be reported." << std::endl;
+        }
+        MemoryAccounting::enable();
+        for (std::size_t ki=0; ki < k_list_size; ++ki) {
+            tests_opt[ki]->set_collect_memory_usage(true);
+            for (const sh_composition_test &test: tests_list[ki]) {
+                test->set_collect_memory_usage(true);
+            }
+        }
+    }
+
+    // certify an upper bound on the optimal score of each list, if required
+    if (arguments["certificates"].as<bool>()) {
+        for (std::size_t ki=0; ki < k_list_size; ++ki) {
+            for (const sh_composition_test &test: tests_list[ki]) {
+                test->set_collect_certificates(true);
             }
         }
     }
 
+    // capture the lists on which the tests are too slow, if required
+    std::unique_ptr<OutlierCapture> capture;
+    if (arguments.count("capture-dir")) {
+        try {
+            const int capture_limit = arguments["capture-limit"].as<int>();
+            if (capture_limit <= 0) {
+                throw std::runtime_error("The parameter capture-limit must be a number strictly greater than 0");
+            }
+            capture.reset(new OutlierCapture(
+                    arguments["capture-dir"].as<std::string>(), arguments["metric"].as<std::string>(),
+                    n_cut_list_size * k_list_size * (tests_list[0].size() + 1),
+                    arguments["capture-threshold"].as<double>(), arguments["capture-percentile"].as<double>(),
+                    static_cast<std::size_t>(capture_limit)));
+        } catch (std::runtime_error & e) {
+            std::cerr << e.what() << "." << std::endl;
+            return -1;
+        }
+    }
+
+    // log the outcomes of the tests on every list, if required
+    std::unique_ptr<ListLog> list_log;
+    if (arguments.count("list-log")) {
+        try {
+            std::vector<std::string> test_names(1, tests_opt[0]->name);
+            for (const sh_composition_test &test: tests_list[0]) {
+                test_names.push_back(test->name);
+            }
+            list_log.reset(new ListLog(arguments["list-log"].as<std::string>(), arguments["list-log-format"].as<std::string>(), test_names));
+        } catch (std::runtime_error & e) {
+            std::cerr << e.what() << "." << std::endl;
+            return -1;
+        }
+    }
+
+    // skip the optimal filter on the lists already in the OPT cache, if required
+    std::unique_ptr<OptCache> opt_cache;
+    if (arguments.count("opt-cache")) {
+        try {
+            opt_cache.reset(new OptCache(arguments["opt-cache"].as<std::string>(), arguments["metric"].as<std::string>()));
+        } catch (std::runtime_error & e) {
+            std::cerr << e.what() << "." << std::endl;
+            return -1;
+        }
+    }
+
     // read the number of input lists from the input stream
     std::size_t num_lists;
+    std::vector<double> file_size_list;
     const bool use_files = param_file_path_list.size();
-    if (use_files) {
+    if (param_synthetic) {
+        num_lists = param_synthetic_lists;
+    } else if (use_files) {
         std::vector<std::string> new_file_list;
         for (const std::string &file_path: param_file_path_list) {
             struct stat s;
@@ -195,6 +408,7 @@ assessment(
                 } else if (s.st_mode & S_IFREG) {
                     // it's a file
                     new_file_list.push_back(file_path);
+                    file_size_list.push_back(static_cast<double>(s.st_size));
                 } else {
                     // something else
                     throw std::runtime_error(std::string("Unable to recognize the file: ") + file_path);
@@ -218,41 +432,48 @@ assessment(
     }
 
 
-    // PROCESS a list at a time
-    TestsAggregationOutcome aggregated_outcome_opt[n_cut_list_size][k_list_size];
-    TestsAggregationOutcome aggregated_outcome_list[n_cut_list_size][k_list_size][tests_list[0].size()];
-    std::size_t aggregated_num_lists_assessed[n_cut_list_size][k_list_size];
-    double aggregated_avg_reading_time[n_cut_list_size][k_list_size];
-    for (std::size_t ni = 0; ni < n_cut_list_size; ++ni) {
-        for (std::size_t ki = 0; ki < k_list_size; ++ki) {
-            aggregated_num_lists_assessed[ni][ki] = 0;
-            aggregated_avg_reading_time[ni][ki] = 0.0;
+    // the lists are processed in blocks of consecutive lists, and each shard processes a range of consecutive blocks
+    const std::size_t lists_per_block = 16;
+    const std::size_t num_blocks = (num_lists + lists_per_block - 1) / lists_per_block;
+    const std::size_t first_block = param_shard_id * num_blocks / param_num_shards;
+    const std::size_t end_block = (param_shard_id + 1) * num_blocks / param_num_shards;
+    const std::size_t first_list = std::min(num_lists, first_block * lists_per_block);
+    const std::size_t end_list = std::min(num_lists, end_block * lists_per_block);
+
+    // pre-read the lists from the input stream, because the threads cannot share it and the sampling mode reads them
+    // in a random order
+    std::vector<std::unique_ptr<ResultsList>> stdin_lists;
+    if (!use_files && !param_synthetic) {
+        const bool prefetch = param_sample || (param_num_threads > 1 && !param_parallel_tests);
+        for (std::size_t i = 0; i < (prefetch ? end_list : first_list); ++i) {
+            TraceSpan read_span("read", -1, -1, -1, nullptr, i);
+            ResultsList resultsList = read_results_list(std::cin, false);
+            stdin_lists.emplace_back((i < first_list) ? nullptr : new ResultsList(std::move(resultsList)));
         }
-    }
-
-    for (std::size_t i=0; i < num_lists; ++i) {
-        if (param_show_progress) {
-            std::cout << i << " of " << num_lists << "\r";
-            std::cout.flush();
-        }
-
-        // read the input
-        std::ifstream istream_file(nullptr);
-        if (use_files) {
-            istream_file = std::ifstream(param_file_path_list[i]);
+        if (!prefetch) {
+            // the lists of the previous shards are skipped
+            stdin_lists.clear();
         }
+    }
 
-        ResultsList resultsList = read_results_list(
-                (!use_files) ? std::cin : istream_file,
-                use_files
-        );
-
-        if (use_files) {
-            istream_file.close();
-        }
 
+    // ASSESS a list at a time
+    const std::size_t num_tests = tests_list[0].size();
+    auto get_test = [&](const std::size_t ki, const std::size_t t) -> composition_test & {
+        return (t == 0) ? *tests_opt[ki] : *tests_list[ki][t - 1];
+    };
+    // the tests of a list are run first, sequentially or in parallel, and then aggregated in a fixed order
+    auto assess_list = [&](const ResultsList &resultsList, const std::size_t i, AssessmentAggregation &aggregation, WorkStealingPool *tests_pool) {
         const relevance_type *rel_list = resultsList.relevances.data();
         const std::size_t rel_list_len = resultsList.size();
+        TraceRecorder::set_current_list(i);
+
+        std::vector<std::size_t> list_n(n_cut_list_size, 0);
+        std::vector<minmax_type> list_minmax_element(n_cut_list_size);
+        std::vector<double> list_reading_time(n_cut_list_size, 0.0);
+        std::vector<TestOutcome> list_outcomes(n_cut_list_size * k_list_size * (num_tests + 1));
+        std::vector<std::uint64_t> list_hash(n_cut_list_size, 0);
+        std::vector<char> list_opt_cached(n_cut_list_size * k_list_size, 0);
 
         // loop over the different cuts of n
         for (std::size_t ni = 0; ni < n_cut_list_size; ++ni) {
@@ -266,9 +487,11 @@ assessment(
             if (n == 0) {
                 continue;
             }
+            list_n[ni] = n;
 
             // compute min and max elements of the list (this is something that could be done during the sort by attribute)
-            minmax_type minmax_element;
+            TraceSpan minmax_span("minmax", n);
+            minmax_type &minmax_element = list_minmax_element[ni];
             minmax_element.min = minmax_element.max = rel_list[0];
             for (index_type j = 1; j < n; ++j) {
                 if (rel_list[j] < minmax_element.min) {
@@ -277,52 +500,120 @@ assessment(
                     minmax_element.max = rel_list[j];
                 }
             }
+            minmax_span.end();
 
             // read time
-            double reading_time = get_time_milliseconds();
+            std::uint64_t reading_start = get_time_nanoseconds();
             for (int attempt=0; attempt < param_num_runs; ++attempt) {
                 for (std::size_t i = 0; i < n; ++i) {
                     doNotOptimizeAway(rel_list[i]);
                 }
             }
-            reading_time = (get_time_milliseconds() - reading_time) / param_num_runs;
+            list_reading_time[ni] = get_elapsed_milliseconds(reading_start, get_time_nanoseconds()) / param_num_runs;
+            if (opt_cache != nullptr) {
+                list_hash[ni] = opt_cache->list_hash(rel_list, n);
+            }
 
-            // loop over the different values of k
+            // loop over the different values of k and over the tests (the first one is the optimal test)
             for (std::size_t ki = 0; ki < k_list_size; ++ki) {
                 // skip the combination n_cut smaller than k
                 if (n_cut > 0 && param_k_list[ki] > n_cut) {
                     continue;
                 }
 
-                TestOutcome outcome = tests_opt[ki]->operator()(rel_list, n, minmax_element);
-                score_type optimal_score = outcome.score;
-
-                // optimal filtering
-                aggregated_outcome_opt[ni][ki].update_aggregation(outcome, aggregated_num_lists_assessed[ni][ki], -1);
-                if (param_check_solutions) {
-                    try {
-                        check_solution(outcome.score, rel_list, outcome.indices, score_fun.get(), -1);
-                    } catch (CheckSolutionException & e) {
-                        std::ostringstream error;
-                        error << e.what() << ". " << tests_opt[ki]->name << " with n=" << param_n_cut_list[ni] << " and k=" << param_k_list[ki] << " on the list ";
-                        if (use_files) {
-                            error << "'" <<param_file_path_list[i] << "'";
-                        } else {
-                            error << i;
-                        }
-                        throw CheckSolutionException(error.str());
+                // the tests are run in groups, which are scheduled together: a group per test when they are run in
+                // parallel, unless they are interleaved
+                TestOutcome *outcomes = &list_outcomes[(ni * k_list_size + ki) * (num_tests + 1)];
+
+                // the optimal solution found in the OPT cache replaces the optimal test, which is not timed
+                std::size_t first_test = 0;
+                if (opt_cache != nullptr) {
+                    FilterSolution optimal_solution;
+                    if (opt_cache->lookup(list_hash[ni], n, param_k_list[ki], optimal_solution)) {
+                        outcomes[0].score = optimal_solution.score;
+                        outcomes[0].indices = std::move(optimal_solution.indices);
+                        list_opt_cached[ni * k_list_size + ki] = 1;
+                        first_test = 1;
                     }
                 }
-                // all others
-                for (std::size_t j=0; j < tests_list[ki].size(); ++j) {
-                    outcome = tests_list[ki][j]->operator()(rel_list, n, minmax_element);
-                    aggregated_outcome_list[ni][ki][j].update_aggregation(outcome, aggregated_num_lists_assessed[ni][ki], optimal_score);
+
+                const std::size_t group_size = (tests_pool != nullptr && !param_schedule.interleave) ? 1 : num_tests + 1;
+                for (std::size_t t = first_test; t <= num_tests; t += group_size) {
+                    std::vector<composition_test *> group;
+                    for (std::size_t g = t; g < std::min(t + group_size, num_tests + 1); ++g) {
+                        group.push_back(&get_test(ki, g));
+                    }
+                    TestOutcome *group_outcomes = outcomes + t;
+                    const minmax_type *group_minmax_element = &minmax_element;
+                    // the seed depends only on the list, the cuts and the group, so that the order is reproducible
+                    const unsigned seed = param_seed;
+                    const int num_runs = param_num_runs;
+                    auto run_group = [&param_schedule, group, group_outcomes, rel_list, n, group_minmax_element, seed, num_runs, i, ni, ki, t](std::size_t) {
+                        std::seed_seq seed_sequence{seed, static_cast<unsigned>(i), static_cast<unsigned>(ni), static_cast<unsigned>(ki), static_cast<unsigned>(t)};
+                        std::mt19937 random_engine(seed_sequence);
+                        run_scheduled_tests(group, rel_list, n, *group_minmax_element, num_runs, param_schedule, random_engine, group_outcomes, i);
+                    };
+                    if (tests_pool != nullptr) {
+                        tests_pool->submit(run_group);
+                    } else {
+                        run_group(0);
+                    }
+                }
+            }
+        }
+        if (tests_pool != nullptr) {
+            tests_pool->wait();
+        }
+
+        // aggregate the outcomes
+        std::string log_records;
+        for (std::size_t ni = 0; ni < n_cut_list_size; ++ni) {
+            if (list_n[ni] == 0) {
+                continue;
+            }
+            for (std::size_t ki = 0; ki < k_list_size; ++ki) {
+                // skip the combination n_cut smaller than k
+                if (param_n_cut_list[ni] > 0 && param_k_list[ki] > param_n_cut_list[ni]) {
+                    continue;
+                }
+
+                const TestOutcome *outcomes = &list_outcomes[(ni * k_list_size + ki) * (num_tests + 1)];
+                const score_type optimal_score = outcomes[0].score;
+                if (opt_cache != nullptr && !list_opt_cached[ni * k_list_size + ki]) {
+                    FilterSolution optimal_solution;
+                    optimal_solution.score = outcomes[0].score;
+                    optimal_solution.indices = outcomes[0].indices;
+                    opt_cache->insert(list_hash[ni], list_n[ni], param_k_list[ki], optimal_solution);
+                }
+                for (std::size_t t = 0; t <= num_tests; ++t) {
+                    const TestOutcome &outcome = outcomes[t];
+                    const composition_test &test = get_test(ki, t);
+                    if (t == 0 && list_opt_cached[ni * k_list_size + ki]) {
+                        // optimal filtering found in the OPT cache, which has no times
+                        aggregation.outcome_opt(ni, ki).update_score(outcome.score);
+                    } else if (t == 0) {
+                        // optimal filtering
+                        aggregation.outcome_opt(ni, ki).update_aggregation(outcome, -1);
+                    } else {
+                        // all others
+                        aggregation.outcome(ni, ki, t - 1).update_aggregation(outcome, optimal_score);
+                    }
+                    // the cached optimal filterings are not timed, thus they are kept out of the time percentiles
+                    const bool timed = !(t == 0 && list_opt_cached[ni * k_list_size + ki]);
+                    if (capture != nullptr && timed && capture->observe((ni * k_list_size + ki) * (num_tests + 1) + t, outcome)) {
+                        capture->capture(resultsList, list_n[ni], param_k_list[ki], i,
+                                         use_files ? param_file_path_list[i] : std::string(), test, outcome);
+                    }
                     if (param_check_solutions) {
                         try {
-                            check_solution(outcome.score, rel_list, outcome.indices, score_fun.get(), optimal_score, tests_list[ki][j]->epsilon_below, tests_list[ki][j]->epsilon_above);
+                            if (t == 0) {
+                                check_solution(outcome.score, rel_list, outcome.indices, score_fun.get(), -1);
+                            } else {
+                                check_solution(outcome.score, rel_list, outcome.indices, score_fun.get(), optimal_score, test.epsilon_below, test.epsilon_above);
+                            }
                         } catch (CheckSolutionException & e) {
                             std::ostringstream error;
-                            error << e.what() << ". " << tests_list[ki][j]->name << " with n=" << param_n_cut_list[ni] << " and k=" << param_k_list[ki] << " on the list ";
+                            error << e.what() << ". " << test.name << " with n=" << param_n_cut_list[ni] << " and k=" << param_k_list[ki] << " on the list ";
                             if (use_files) {
                                 error << "'" <<param_file_path_list[i] << "'";
                             } else {
@@ -333,62 +624,231 @@ assessment(
                     }
                 }
 
-                // update reading time and aggregated_num_lists_assessed
-                {
-                    double new_multiplier = 1.0 / (aggregated_num_lists_assessed[ni][ki] + 1);
-                    double old_multiplier = aggregated_num_lists_assessed[ni][ki] * new_multiplier;
+                // update reading time, list length and num_lists_assessed
+                aggregation.num_lists_assessed(ni, ki) += 1;
+                aggregation.sum_reading_time(ni, ki).add(list_reading_time[ni]);
+                aggregation.sum_list_length(ni, ki) += list_n[ni];
+                if (list_log != nullptr) {
+                    list_log->format_record(log_records, i, param_n_cut_list[ni], list_n[ni], param_k_list[ki], outcomes);
+                }
+            }
+        }
+        if (list_log != nullptr) {
+            list_log->write(log_records);
+        }
+    };
+
+
+    // PROCESS the lists in blocks of consecutive lists. Each block is aggregated on its own and then merged in the
+    // order of the blocks, so that the results do not depend on the number of threads and on the scheduling
+    const std::size_t num_shard_lists = end_list - first_list;
+    AssessmentAggregation aggregation(n_cut_list_size, k_list_size, num_tests);
+    std::mutex merge_mutex;
+    std::map<std::size_t, std::unique_ptr<AssessmentAggregation>> completed_blocks;
+    std::size_t next_block_to_merge = first_block;
+    std::atomic<std::size_t> num_lists_processed(0);
+
+    // reads, or generates, the i-th list and assesses it
+    auto read_and_assess_list = [&](const std::size_t i, AssessmentAggregation &list_aggregation, WorkStealingPool *tests_pool) {
+        if (param_synthetic) {
+            // each list has its own seed, so that it is the same list written by the generate command
+            TraceSpan read_span("generate", param_synthetic_config.length, -1, -1, nullptr, i);
+            std::seed_seq seed_sequence{param_seed, static_cast<unsigned>(i)};
+            std::mt19937 random_engine(seed_sequence);
+            ResultsList resultsList(generate_synthetic_list(param_synthetic_config, random_engine));
+            read_span.end();
+            assess_list(resultsList, i, list_aggregation, tests_pool);
+        } else if (use_files) {
+            TraceSpan read_span("read", -1, -1, -1, nullptr, i);
+            std::ifstream istream_file(param_file_path_list[i]);
+            ResultsList resultsList = read_results_list(istream_file, use_files);
+            istream_file.close();
+            read_span.end();
+            assess_list(resultsList, i, list_aggregation, tests_pool);
+        } else if (!stdin_lists.empty()) {
+            assess_list(*stdin_lists[i], i, list_aggregation, tests_pool);
+            stdin_lists[i].reset();
+        } else {
+            TraceSpan read_span("read", -1, -1, -1, nullptr, i);
+            ResultsList resultsList = read_results_list(std::cin, use_files);
+            read_span.end();
+            assess_list(resultsList, i, list_aggregation, tests_pool);
+        }
+    };
+
+    auto process_block = [&](const std::size_t block_id, WorkStealingPool *tests_pool) {
+        std::unique_ptr<AssessmentAggregation> block_aggregation(new AssessmentAggregation(n_cut_list_size, k_list_size, num_tests));
 
-                    aggregated_num_lists_assessed[ni][ki] += 1;
-                    aggregated_avg_reading_time[ni][ki] = old_multiplier * aggregated_avg_reading_time[ni][ki] + new_multiplier * reading_time;
+        for (std::size_t i = block_id * lists_per_block, i_end = std::min(num_lists, i + lists_per_block); i < i_end; ++i) {
+            read_and_assess_list(i, *block_aggregation, tests_pool);
+
+            ++num_lists_processed;
+            if (param_show_progress && (param_num_threads == 1 || param_parallel_tests)) {
+                std::cout << num_lists_processed << " of " << num_shard_lists << "\r";
+                std::cout.flush();
+            }
+        }
+
+        // merge all the consecutive blocks completed so far
+        std::lock_guard<std::mutex> lock(merge_mutex);
+        completed_blocks[block_id] = std::move(block_aggregation);
+        auto it = completed_blocks.begin();
+        while (it != completed_blocks.end() && it->first == next_block_to_merge) {
+            aggregation.merge(*(it->second));
+            it = completed_blocks.erase(it);
+            ++next_block_to_merge;
+        }
+    };
+
+    // SAMPLE the lists, stratified by their size, in rounds until the confidence intervals of the estimates are narrow
+    // enough. Each list is aggregated on its own and then merged in the order of the batch into its stratum
+    std::vector<TestEstimates> estimates;
+    std::size_t num_sampling_rounds = 0;
+    std::size_t num_lists_sampled = 0;
+    if (param_sample) {
+        std::vector<double> list_size_list;
+        if (param_synthetic) {
+            list_size_list.assign(num_lists, static_cast<double>(param_synthetic_config.length));
+        } else if (use_files) {
+            list_size_list = file_size_list;
+        } else {
+            for (const std::unique_ptr<ResultsList> &resultsList: stdin_lists) {
+                list_size_list.push_back(static_cast<double>(resultsList->size()));
+            }
+        }
+        StratifiedSampler sampler(list_size_list, param_strata, param_seed);
+        std::vector<std::unique_ptr<AssessmentAggregation>> strata_aggregations;
+        for (std::size_t h = 0; h < sampler.num_strata(); ++h) {
+            strata_aggregations.emplace_back(new AssessmentAggregation(n_cut_list_size, k_list_size, num_tests));
+        }
+        std::unique_ptr<WorkStealingPool> pool((param_num_threads > 1) ? new WorkStealingPool(param_num_threads, param_cpu_list) : nullptr);
+
+        while (num_lists > 0) {
+            const std::vector<std::size_t> batch = sampler.next_batch(param_sample_batch);
+            std::vector<std::unique_ptr<AssessmentAggregation>> list_aggregations;
+            for (std::size_t b = 0; b < batch.size(); ++b) {
+                list_aggregations.emplace_back(new AssessmentAggregation(n_cut_list_size, k_list_size, num_tests));
+            }
+            if (pool != nullptr && !param_parallel_tests) {
+                for (std::size_t b = 0; b < batch.size(); ++b) {
+                    pool->submit([&read_and_assess_list, &batch, &list_aggregations, b](std::size_t) {
+                        read_and_assess_list(batch[b], *list_aggregations[b], nullptr);
+                    });
                 }
+                pool->wait();
+            } else {
+                for (std::size_t b = 0; b < batch.size(); ++b) {
+                    read_and_assess_list(batch[b], *list_aggregations[b], pool.get());
+                }
+            }
+            for (std::size_t b = 0; b < batch.size(); ++b) {
+                strata_aggregations[sampler.stratum(batch[b])]->merge(*list_aggregations[b]);
+            }
+            ++num_sampling_rounds;
+            num_lists_sampled = sampler.sampled();
 
+            estimates = compute_stratified_estimates(sampler, strata_aggregations, param_confidence);
+            if (param_show_progress) {
+                std::cout << num_lists_sampled << " of " << num_lists << " sampled\r";
+                std::cout.flush();
+            }
+            if (sampler.exhausted() || within_sampling_targets(estimates, param_targets)) {
+                break;
             }
         }
+        for (const std::unique_ptr<AssessmentAggregation> &stratum_aggregation: strata_aggregations) {
+            aggregation.merge(*stratum_aggregation);
+        }
+    } else if (param_num_threads == 1) {
+        for (std::size_t block_id = first_block; block_id < end_block; ++block_id) {
+            process_block(block_id, nullptr);
+        }
+    } else if (param_parallel_tests) {
+        // the lists are processed one at a time, while their tests run in parallel
+        WorkStealingPool pool(param_num_threads, param_cpu_list);
+        for (std::size_t block_id = first_block; block_id < end_block; ++block_id) {
+            process_block(block_id, &pool);
+        }
+    } else {
+        WorkStealingPool pool(param_num_threads, param_cpu_list);
+        for (std::size_t block_id = first_block; block_id < end_block; ++block_id) {
+            pool.submit([&process_block, block_id](std::size_t) {
+                process_block(block_id, nullptr);
+            });
+        }
+        while (!pool.wait_for(std::chrono::milliseconds(100))) {
+            if (param_show_progress) {
+                std::cout << num_lists_processed << " of " << num_shard_lists << "\r";
+                std::cout.flush();
+            }
+        }
+    }
+    assert(param_sample || next_block_to_merge == end_block);
+    if (param_memory_usage) {
+        aggregation.peak_rss_bytes = MemoryAccounting::peak_rss_bytes();
+    }
+
+    if (list_log != nullptr) {
+        try {
+            list_log->close();
+        } catch (std::runtime_error & e) {
+            std::cerr << e.what() << "." << std::endl;
+            return -1;
+        }
     }
-    if (param_show_progress) {
-        std::cout << num_lists << " of " << num_lists << "\r";
+
+    if (opt_cache != nullptr) {
+        try {
+            opt_cache->save();
+        } catch (std::runtime_error & e) {
+            std::cerr << e.what() << "." << std::endl;
+            return -1;
+        }
+    }
+
+    if (param_show_progress && param_sample) {
+        std::cout << "Sampled " << num_lists_sampled << " of " << num_lists << " lists in " << num_sampling_rounds << " rounds" << std::endl;
+        std::cout.flush();
+    } else if (param_show_progress) {
+        std::cout << num_shard_lists << " of " << num_shard_lists << "\r";
         std::cout << std::endl;
         std::cout.flush();
     }
+    if (param_show_progress && opt_cache != nullptr) {
+        std::cout << "OPT cache: " << opt_cache->hits() << " hits, " << opt_cache->misses() << " misses" << std::endl;
+        std::cout.flush();
+    }
 
 
     // WRITE the output
     // select the output stream
     std::ostream & ostream = (param_ofstream != nullptr) ? *param_ofstream : std::cout;
 
-    ostream << "[" << std::endl;
-    // loop over the different cuts of n
-    for (std::size_t ni = 0; ni < n_cut_list_size; ++ni) {
-        // loop over the different values of k
-        for (std::size_t ki = 0; ki < k_list_size; ++ki) {
-            // skip the combination n_cut smaller than k
-            if (param_n_cut_list[ni] > 0 && param_k_list[ki] > param_n_cut_list[ni]) {
-                continue;
-            }
-
-            ostream << "{" << std::endl;
-            ostream << "\t\"n_cut\": " << param_n_cut_list[ni];
-            ostream << ", \"k\": " << param_k_list[ki];
-            ostream << ", \"avg_reading_time\": " << aggregated_avg_reading_time[ni][ki];
-            ostream << ", \"num_lists_assessed\": " << aggregated_num_lists_assessed[ni][ki];
-            ostream << ", \"strategies\": {";
+    AssessmentConfiguration config;
+    config.metric = arguments["metric"].as<std::string>();
+    config.n_cut_list = param_n_cut_list;
+    config.k_list = param_k_list;
+    config.report_throughput = param_scaling;
+    config.test_names.push_back(tests_opt[0]->name);
+    for (const sh_composition_test &test: tests_list[0]) {
+        config.test_names.push_back(test->name);
+    }
 
-            // optimal filtering
-            ostream << std::endl << "\t\t\"" << tests_opt[ki]->name << "\": " << aggregated_outcome_opt[ni][ki];
-            // all others
-            for (std::size_t j=0; j < tests_list[ki].size(); ++j) {
-                ostream << "," << std::endl << "\t\t\"" << tests_list[ki][j]->name << "\": " << aggregated_outcome_list[ni][ki][j];
-            }
+    TraceRecorder::set_current_list(-1);
+    TraceSpan output_span("output");
+    if (arguments.count("shard")) {
+        write_assessment_partial(ostream, config, aggregation, param_shard_id, param_num_shards);
+    } else {
+        write_assessment_report(ostream, config, aggregation, !estimates.empty() ? &estimates : nullptr);
+    }
+    output_span.end();
 
-            ostream << std::endl << "\t}" << std::endl;
-            ostream << "}";
-            if (ki < (k_list_size-1) || ni < (n_cut_list_size-1)) {
-                ostream << ",";
-            }
-            ostream << std::endl;
-        }
+    // write the trace
+    if (param_trace_ofstream != nullptr) {
+        TraceRecorder::write(*param_trace_ofstream);
+        param_trace_ofstream->close();
+        delete(param_trace_ofstream);
     }
-    ostream << "]" << std::endl;
 
     // close the file output stream
     if (param_ofstream != nullptr) {
@@ -412,10 +872,46 @@ int main(int argc, char *argv[]) {
             ("e, epsilon-list", "Target approximation factor", cxxopts::value<std::string>()->default_value("0.1,0.01"))
             ("s, skip-shorter-lists", "Skips the lists shorter than n elements", cxxopts::value<bool>()->default_value("true"))
             ("r, num-runs", "Number of times each test must be repeated", cxxopts::value<int>()->default_value("5"))
+            ("warmup-runs", "Number of untimed runs of each test before the timed ones", cxxopts::value<int>()->default_value("0"))
+            ("cold-cache", "Evict the caches before each run of a test", cxxopts::value<bool>()->default_value("false"))
+            ("flush-size", "Size in MB of the buffer written to evict the caches", cxxopts::value<int>()->default_value("64"))
+            ("interleave", "Run the tests of a list in a random order at each run, instead of repeating each test back-to-back", cxxopts::value<bool>()->default_value("false"))
+            ("seed", "Seed of the random order of the interleaved tests and of the synthetic lists", cxxopts::value<unsigned>()->default_value("0"))
+            ("outlier-threshold", "Discard the runs whose time is farther than this number of scaled median absolute deviations from the median (0 keeps all runs)", cxxopts::value<double>()->default_value("0"))
             ("a, cpu-affinity", "Set the cpu affinity of the process", cxxopts::value<int>()->default_value("-1"))
+            ("t, threads", "Number of threads assessing the lists in parallel", cxxopts::value<int>()->default_value("1"))
+            ("cpu-list", "Comma separated list of cpus where to pin the threads, one per thread", cxxopts::value<std::string>())
+            ("perf-counters", "Collect the hardware performance counters of the two stages of each strategy", cxxopts::value<bool>()->default_value("false"))
+            ("memory-usage", "Report the heap memory allocated by the two stages of each strategy and the peak resident set size", cxxopts::value<bool>()->default_value("false"))
+            ("certificates", "Certify for each list an upper bound on its optimal score without the optimal filter, and report the certified errors of the strategies", cxxopts::value<bool>()->default_value("false"))
+            ("parallel-tests", "Run the tests of a list in parallel instead of assessing many lists in parallel", cxxopts::value<bool>()->default_value("false"))
             ("c, check-solutions", "Check all solutions", cxxopts::value<bool>()->default_value("false"))
             ("p, show-progress", "Show the computation progress", cxxopts::value<bool>()->default_value("true"))
             ("o, output", "Write result to FILE instead of standard output", cxxopts::value<std::string>())
+            ("capture-dir", "Write the lists on which a test is too slow, with the test and its timings, to the directory DIR", cxxopts::value<std::string>())
+            ("capture-threshold", "Capture the lists on which the total time of a test is greater than this number of milliseconds", cxxopts::value<double>()->default_value("0"))
+            ("capture-percentile", "Capture the lists on which the total time of a test is greater than this percentile of the times observed so far", cxxopts::value<double>()->default_value("0"))
+            ("capture-limit", "Maximum number of lists to capture", cxxopts::value<int>()->default_value("100"))
+            ("opt-cache", "Read the optimal solutions of the lists from the OPT cache FILE instead of computing them, and add the new ones to it", cxxopts::value<std::string>())
+            ("list-log", "Write the outcomes of the tests on every list to FILE", cxxopts::value<std::string>())
+            ("list-log-format", "Format of the list log. Available options are: jsonl, binary", cxxopts::value<std::string>()->default_value("jsonl"))
+            ("trace", "Write a Chrome trace-event json with the timeline of the stages of every list to FILE", cxxopts::value<std::string>())
+            ("synthetic", "Assess synthetic lists with the given relevance distribution instead of reading them. Available options are: uniform, zipf, graded, adversarial", cxxopts::value<std::string>())
+            ("synthetic-lists", "Number of synthetic lists to assess", cxxopts::value<int>()->default_value("10"))
+            ("synthetic-length", "Number of elements of the synthetic lists, or 0 for the greatest n", cxxopts::value<index_type>()->default_value("0"))
+            ("max-relevance", "Maximum relevance of the elements of the synthetic lists", cxxopts::value<double>()->default_value("4"))
+            ("zipf-exponent", "Exponent of the zipf distribution of the synthetic lists", cxxopts::value<double>()->default_value("1"))
+            ("grades", "Number of relevance labels of the graded distribution of the synthetic lists", cxxopts::value<int>()->default_value("5"))
+            ("sortedness", "Fraction of each synthetic list, from its beginning, sorted by decreasing relevance", cxxopts::value<double>()->default_value("0"))
+            ("scaling", "Report the average list length and the throughput of each strategy, and the memory usage", cxxopts::value<bool>()->default_value("false"))
+            ("sample", "Assess a random sample of the lists, stratified by their size, until the confidence intervals of the estimates are within the targets", cxxopts::value<bool>()->default_value("false"))
+            ("strata", "Number of strata of the lists, by size, in sampling mode", cxxopts::value<int>()->default_value("4"))
+            ("sample-batch", "Number of lists sampled at each round in sampling mode", cxxopts::value<int>()->default_value("32"))
+            ("confidence", "Confidence level of the intervals of the estimates in sampling mode", cxxopts::value<double>()->default_value("0.95"))
+            ("target-ci-score", "Target half width of the interval of the average score, relative to the estimate", cxxopts::value<double>()->default_value("0.01"))
+            ("target-ci-error", "Target half width of the interval of the average approximation error", cxxopts::value<double>()->default_value("0.001"))
+            ("target-ci-time", "Target half width of the interval of the average total time, relative to the estimate", cxxopts::value<double>()->default_value("0.05"))
+            ("shard", "Assess only the i-th of N shards of the lists, in the format i/N, and write a partial aggregation to be merged with the merge command", cxxopts::value<std::string>())
             ("test-cutoff", "Test the cutoff-opt strategy", cxxopts::value<bool>()->default_value("true"))
             ("test-topk", "Test the topk-opt strategy", cxxopts::value<bool>()->default_value("true"))
             ("test-epsfiltering", "Test the epsilon filtering strategy", cxxopts::value<bool>()->default_value("true"));
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "filtering.h"
+
+#define N 10000
+#define K 20
+#define NUM_LISTS 4
+
+
+/**
+ * Checks the C interface of libfiltering on random lists: every strategy must select at most k distinct elements in
+ * their ranking order, EpsFiltering must be within epsilon of the optimal score, the batch entry point must agree with
+ * the single list one, and invalid arguments must be reported as errors.
+ */
+
+static int
+check(int condition, const char *message) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s\n", message);
+    }
+    return condition;
+}
+
+static int
+check_indices(const uint32_t *indices, uint32_t num_indices, uint32_t n) {
+    uint32_t i;
+    for (i = 0; i < num_indices; ++i) {
+        if (indices[i] >= n || (i > 0 && indices[i] <= indices[i - 1])) {
+            return 0;
+        }
+    }
+    return num_indices <= K;
+}
+
+int
+main(void) {
+    static float relevances[NUM_LISTS][N];
+    static const char *const names[] = {"opt", "cutoff", "topk", "epsfiltering"};
+    const float *lists[NUM_LISTS];
+    uint32_t sizes[NUM_LISTS];
+    uint32_t indices[NUM_LISTS * K];
+    uint32_t num_indices[NUM_LISTS];
+    float scores[NUM_LISTS];
+    float opt_score = 0;
+    int ok = 1;
+    int strategy;
+    size_t l;
+    uint32_t i;
+    filtering_filter *filter;
+
+    ok &= check(filtering_abi_version() == FILTERING_ABI_VERSION, "ABI version");
+
+    srand(42);
+    for (l = 0; l < NUM_LISTS; ++l) {
+        for (i = 0; i < N; ++i) {
+            relevances[l][i] = 4.0f * (float) rand() / (float) RAND_MAX;
+        }
+        lists[l] = relevances[l];
+        sizes[l] = N - (uint32_t) l * 1000;
+    }
+
+    for (strategy = FILTERING_STRATEGY_OPT; strategy <= FILTERING_STRATEGY_EPSFILTERING; ++strategy) {
+        uint32_t num_selected;
+        float score;
+        if (filtering_filter_create(FILTERING_METRIC_DCG, strategy, K, 0.01f, &filter) != FILTERING_OK) {
+            fprintf(stderr, "FAILED: %s\n", filtering_last_error());
+            return 1;
+        }
+        ok &= check(filtering_filter_k(filter) == K, "k of the filter");
+
+        ok &= check(filtering_filter_run(filter, lists[0], sizes[0], indices, &num_selected, &score) == FILTERING_OK, "run");
+        ok &= check(check_indices(indices, num_selected, sizes[0]), "indices of run");
+        if (strategy == FILTERING_STRATEGY_OPT) {
+            opt_score = score;
+        } else {
+            ok &= check(score <= opt_score * 1.0001f, "score not above the optimal one");
+        }
+        if (strategy == FILTERING_STRATEGY_EPSFILTERING) {
+            ok &= check(score >= opt_score * (1.0f - 0.01f), "EpsFiltering within epsilon of the optimal score");
+        }
+        printf("%s: %u elements, score %f\n", names[strategy], num_selected, score);
+
+        ok &= check(filtering_filter_run_batch(filter, lists, sizes, NUM_LISTS, indices, num_indices, scores) == FILTERING_OK, "run_batch");
+        ok &= check(scores[0] == score && num_indices[0] == num_selected, "batch agrees with run");
+        for (l = 0; l < NUM_LISTS; ++l) {
+            ok &= check(check_indices(indices + l * K, num_indices[l], sizes[l]), "indices of run_batch");
+        }
+
+        if (strategy == FILTERING_STRATEGY_OPT || strategy == FILTERING_STRATEGY_EPSFILTERING) {
+            float anytime_score, anytime_epsilon;
+            ok &= check(filtering_filter_run_anytime(filter, lists[0], sizes[0], 1000.0, indices, &num_selected, &anytime_score, &anytime_epsilon) == FILTERING_OK, "run_anytime");
+            ok &= check(check_indices(indices, num_selected, sizes[0]), "indices of run_anytime");
+            ok &= check(anytime_epsilon <= (strategy == FILTERING_STRATEGY_OPT ? 0.0f : 0.01f), "epsilon of run_anytime");
+            ok &= check(anytime_score >= opt_score * (1.0f - anytime_epsilon) * 0.9999f, "run_anytime within its epsilon of the optimal score");
+        } else {
+            ok &= check(filtering_filter_run_anytime(filter, lists[0], sizes[0], 1000.0, indices, &num_selected, NULL, NULL) == FILTERING_ERROR_INVALID_ARGUMENT, "run_anytime rejected");
+        }
+
+        if (strategy != FILTERING_STRATEGY_CUTOFF) {
+            float certified_score, upper_bound;
+            ok &= check(filtering_filter_run_certified(filter, lists[0], sizes[0], indices, &num_selected, &certified_score, &upper_bound) == FILTERING_OK, "run_certified");
+            ok &= check(check_indices(indices, num_selected, sizes[0]), "indices of run_certified");
+            ok &= check(certified_score == score, "run_certified agrees with run");
+            ok &= check(upper_bound >= opt_score * 0.9999f, "upper bound not below the optimal score");
+            printf("%s: certified ratio %f\n", names[strategy], certified_score / upper_bound);
+        } else {
+            ok &= check(filtering_filter_run_certified(filter, lists[0], sizes[0], indices, &num_selected, NULL, NULL) == FILTERING_ERROR_INVALID_ARGUMENT, "run_certified rejected");
+        }
+
+        ok &= check(filtering_filter_run(filter, NULL, 10, indices, &num_selected, &score) == FILTERING_ERROR_INVALID_ARGUMENT, "NULL list rejected");
+        filtering_filter_destroy(filter);
+    }
+
+    ok &= check(filtering_filter_create(FILTERING_METRIC_DCGLZ, FILTERING_STRATEGY_EPSFILTERING, K, 2.0f, &filter) == FILTERING_ERROR_INVALID_ARGUMENT, "epsilon rejected");
+    ok &= check(filter == NULL, "no filter on error");
+    ok &= check(filtering_filter_create(7, FILTERING_STRATEGY_OPT, K, 0, &filter) == FILTERING_ERROR_INVALID_ARGUMENT, "metric rejected");
+    printf("last error: %s\n", filtering_last_error());
+
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include "filtering.h"
+#include "../filtering/search_quality_metric.hpp"
+#include "../utils/anytime.hpp"
+#include "../utils/strategies.hpp"
+
+
+/**
+ * Filter behind the opaque handle of the C interface, independent of the metric.
+ */
+struct filtering_filter {
+    explicit filtering_filter(k_type k) :
+            k(k) {
+    }
+
+    virtual ~filtering_filter() = default;
+
+    /**
+     * Selects the elements of a list
+     * @param rel_list The relevances of the list
+     * @param n The number of elements of the list
+     * @param indices Where to write the indices selected
+     * @param num_indices Where to store the number of indices selected
+     * @return The score of the selection
+     */
+    virtual score_type
+    run(const relevance_type *rel_list, index_type n, std::uint32_t *indices, std::uint32_t *num_indices) = 0;
+
+    /**
+     * Selects the elements of a list within a time budget
+     * @param rel_list The relevances of the list
+     * @param n The number of elements of the list
+     * @param budget The time budget, in milliseconds
+     * @param indices Where to write the indices selected
+     * @param num_indices Where to store the number of indices selected
+     * @param epsilon Where to store the approximation factor proven for the selection
+     * @return The score of the selection
+     */
+    virtual score_type
+    run_anytime(const relevance_type *rel_list, index_type n, double budget,
+                std::uint32_t *indices, std::uint32_t *num_indices, score_type *epsilon) = 0;
+
+    /**
+     * Selects the elements of a list and certifies an upper bound on its optimal score
+     * @param rel_list The relevances of the list
+     * @param n The number of elements of the list
+     * @param indices Where to write the indices selected
+     * @param num_indices Where to store the number of indices selected
+     * @param upper_bound Where to store the upper bound on the optimal score
+     * @return The score of the selection
+     */
+    virtual score_type
+    run_certified(const relevance_type *rel_list, index_type n,
+                  std::uint32_t *indices, std::uint32_t *num_indices, score_type *upper_bound) = 0;
+
+    const k_type k;
+};
+
+
+namespace {
+
+/**
+ * Message of the last error of each thread
+ */
+thread_local std::string last_error;
+
+
+/**
+ * Filter of a metric, i.e., the composition test of a strategy run once per list.
+ * @tparam ScoreFun Score function type
+ */
+template <typename ScoreFun>
+class MetricFilter: public filtering_filter {
+public:
+    MetricFilter(const std::string &strategy, k_type k, score_type epsilon) :
+            filtering_filter(k),
+            score_fun(std::make_shared<ScoreFun>(k)),
+            test(make_strategy_test<ScoreFun>(strategy, this->score_fun, std::make_shared<FilterSpirin<ScoreFun>>(k, this->score_fun), epsilon, 1)) {
+        if (strategy == "opt" || strategy == "epsfiltering") {
+            this->anytime_filter.reset(new AnytimeFilter<ScoreFun>(this->score_fun, this->test->filter, epsilon));
+        }
+        if (strategy != "cutoff") {
+            this->certified_test = make_strategy_test<ScoreFun>(strategy, this->score_fun, this->test->filter, epsilon, 1);
+            this->certified_test->set_collect_certificates(true);
+        }
+    }
+
+    score_type
+    run(const relevance_type *rel_list, index_type n, std::uint32_t *indices, std::uint32_t *num_indices) override {
+        return this->run_test(*this->test, rel_list, n, indices, num_indices).score;
+    }
+
+    score_type
+    run_anytime(const relevance_type *rel_list, index_type n, double budget,
+                std::uint32_t *indices, std::uint32_t *num_indices, score_type *epsilon) override {
+        if (this->anytime_filter == nullptr) {
+            throw std::invalid_argument("The anytime filtering is available only for the opt and the epsfiltering strategies");
+        }
+        const AnytimeSolution outcome = this->anytime_filter->operator()(rel_list, n, budget);
+        const std::size_t num_selected = std::min(outcome.solution.size(), static_cast<std::size_t>(this->k));
+        std::copy(outcome.solution.indices.begin(), outcome.solution.indices.begin() + num_selected, indices);
+        *num_indices = static_cast<std::uint32_t>(num_selected);
+        *epsilon = outcome.epsilon;
+        return outcome.solution.score;
+    }
+
+    score_type
+    run_certified(const relevance_type *rel_list, index_type n,
+                  std::uint32_t *indices, std::uint32_t *num_indices, score_type *upper_bound) override {
+        if (this->certified_test == nullptr) {
+            throw std::invalid_argument("The certificates are available only for the opt, the topk and the epsfiltering strategies");
+        }
+        const TestOutcome outcome = this->run_test(*this->certified_test, rel_list, n, indices, num_indices);
+        *upper_bound = std::max(outcome.upper_bound, static_cast<score_type>(0));
+        return outcome.score;
+    }
+
+private:
+    /**
+     * Selects the elements of a list with the given composition test
+     * @param test The composition test
+     * @param rel_list The relevances of the list
+     * @param n The number of elements of the list
+     * @param indices Where to write the indices selected
+     * @param num_indices Where to store the number of indices selected
+     * @return The outcome of the test
+     */
+    TestOutcome
+    run_test(PrunerFilterCompositionTest<ScoreFun> &test, const relevance_type *rel_list, index_type n,
+             std::uint32_t *indices, std::uint32_t *num_indices) const {
+        if (n == 0) {
+            *num_indices = 0;
+            return TestOutcome();
+        }
+
+        // compute min and max elements of the list
+        minmax_type minmax_element;
+        minmax_element.min = minmax_element.max = rel_list[0];
+        for (index_type j = 1; j < n; ++j) {
+            if (rel_list[j] < minmax_element.min) {
+                minmax_element.min = rel_list[j];
+            } else if (rel_list[j] > minmax_element.max) {
+                minmax_element.max = rel_list[j];
+            }
+        }
+
+        TestOutcome outcome = test.run_once(rel_list, n, minmax_element);
+        const std::size_t num_selected = std::min(outcome.indices.size(), static_cast<std::size_t>(this->k));
+        std::copy(outcome.indices.begin(), outcome.indices.begin() + num_selected, indices);
+        *num_indices = static_cast<std::uint32_t>(num_selected);
+        return outcome;
+    }
+
+private:
+    const std::shared_ptr<ScoreFun> score_fun;
+    const std::shared_ptr<PrunerFilterCompositionTest<ScoreFun>> test;
+    std::unique_ptr<AnytimeFilter<ScoreFun>> anytime_filter;
+    std::shared_ptr<PrunerFilterCompositionTest<ScoreFun>> certified_test;
+};
+
+
+/**
+ * Runs a function, converting the exceptions into error codes and recording their message
+ * @param function The function
+ * @return FILTERING_OK, or the error code of the exception raised
+ */
+template <typename Function>
+int
+guarded(Function function) {
+    try {
+        function();
+        last_error.clear();
+        return FILTERING_OK;
+    } catch (std::invalid_argument &e) {
+        last_error = e.what();
+        return FILTERING_ERROR_INVALID_ARGUMENT;
+    } catch (std::bad_alloc &) {
+        last_error = "Out of memory";
+        return FILTERING_ERROR_OUT_OF_MEMORY;
+    } catch (std::exception &e) {
+        last_error = e.what();
+        return FILTERING_ERROR_INTERNAL;
+    } catch (...) {
+        last_error = "Unknown error";
+        return FILTERING_ERROR_INTERNAL;
+    }
+}
+
+
+void
+check_list(const float *relevances, std::uint32_t n, const std::uint32_t *indices, const std::uint32_t *num_indices) {
+    if ((relevances == nullptr && n > 0) || indices == nullptr || num_indices == nullptr) {
+        throw std::invalid_argument("The relevances, the indices and the number of indices must not be NULL");
+    }
+}
+
+}  // namespace
+
+
+extern "C" {
+
+unsigned int
+filtering_abi_version(void) {
+    return FILTERING_ABI_VERSION;
+}
+
+const char *
+filtering_last_error(void) {
+    return last_error.c_str();
+}
+
+int
+filtering_filter_create(int metric, int strategy, uint16_t k, float epsilon, filtering_filter **filter) {
+    return guarded([&] {
+        static const char *const strategies[] = {"opt", "cutoff", "topk", "epsfiltering"};
+        if (filter == nullptr) {
+            throw std::invalid_argument("The filter must not be NULL");
+        }
+        *filter = nullptr;
+        if (strategy < FILTERING_STRATEGY_OPT || strategy > FILTERING_STRATEGY_EPSFILTERING) {
+            throw std::invalid_argument("The given strategy is unavailable");
+        }
+        if (k == 0) {
+            throw std::invalid_argument("The parameter k must be strictly greater than 0");
+        }
+        if (strategy == FILTERING_STRATEGY_EPSFILTERING && !(epsilon > 0 && epsilon < 1)) {
+            throw std::invalid_argument("The parameter epsilon must be between zero and one");
+        }
+        const score_type test_epsilon = (strategy == FILTERING_STRATEGY_EPSFILTERING) ? epsilon : 0;
+        if (metric == FILTERING_METRIC_DCG) {
+            *filter = new MetricFilter<dcg_metric>(strategies[strategy], k, test_epsilon);
+        } else if (metric == FILTERING_METRIC_DCGLZ) {
+            *filter = new MetricFilter<dcglz_metric>(strategies[strategy], k, test_epsilon);
+        } else {
+            throw std::invalid_argument("The given metric is unavailable");
+        }
+    });
+}
+
+void
+filtering_filter_destroy(filtering_filter *filter) {
+    delete filter;
+}
+
+uint16_t
+filtering_filter_k(const filtering_filter *filter) {
+    return (filter != nullptr) ? filter->k : 0;
+}
+
+int
+filtering_filter_run(filtering_filter *filter, const float *relevances, uint32_t n,
+                     uint32_t *indices, uint32_t *num_indices, float *score) {
+    return guarded([&] {
+        if (filter == nullptr) {
+            throw std::invalid_argument("The filter must not be NULL");
+        }
+        check_list(relevances, n, indices, num_indices);
+        const score_type list_score = filter->run(relevances, n, indices, num_indices);
+        if (score != nullptr) {
+            *score = list_score;
+        }
+    });
+}
+
+int
+filtering_filter_run_anytime(filtering_filter *filter, const float *relevances, uint32_t n, double budget_ms,
+                             uint32_t *indices, uint32_t *num_indices, float *score, float *epsilon) {
+    return guarded([&] {
+        if (filter == nullptr) {
+            throw std::invalid_argument("The filter must not be NULL");
+        }
+        check_list(relevances, n, indices, num_indices);
+        score_type list_epsilon;
+        const score_type list_score = filter->run_anytime(relevances, n, budget_ms, indices, num_indices, &list_epsilon);
+        if (score != nullptr) {
+            *score = list_score;
+        }
+        if (epsilon != nullptr) {
+            *epsilon = list_epsilon;
+        }
+    });
+}
+
+int
+filtering_filter_run_certified(filtering_filter *filter, const float *relevances, uint32_t n,
+                               uint32_t *indices, uint32_t *num_indices, float *score, float *upper_bound) {
+    return guarded([&] {
+        if (filter == nullptr) {
+            throw std::invalid_argument("The filter must not be NULL");
+        }
+        check_list(relevances, n, indices, num_indices);
+        score_type list_upper_bound;
+        const score_type list_score = filter->run_certified(relevances, n, indices, num_indices, &list_upper_bound);
+        if (score != nullptr) {
+            *score = list_score;
+        }
+        if (upper_bound != nullptr) {
+            *upper_bound = list_upper_bound;
+        }
+    });
+}
+
+int
+filtering_filter_run_batch(filtering_filter *filter, const float *const *relevances, const uint32_t *sizes,
+                           size_t num_lists, uint32_t *indices, uint32_t *num_indices, float *scores) {
+    return guarded([&] {
+        if (filter == nullptr) {
+            throw std::invalid_argument("The filter must not be NULL");
+        }
+        if (num_lists > 0 && (relevances == nullptr || sizes == nullptr || indices == nullptr || num_indices == nullptr)) {
+            throw std::invalid_argument("The lists, their sizes, the indices and the numbers of indices must not be NULL");
+        }
+        for (std::size_t i = 0; i < num_lists; ++i) {
+            check_list(relevances[i], sizes[i], indices, num_indices);
+            const score_type list_score = filter->run(relevances[i], sizes[i], indices + i * filter->k, num_indices + i);
+            if (scores != nullptr) {
+                scores[i] = list_score;
+            }
+        }
+    });
+}
+
+}
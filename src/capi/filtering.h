@@ -0,0 +1,172 @@
+#ifndef CAPI_FILTERING_H
+#define CAPI_FILTERING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(FILTERING_BUILD_LIBRARY) && defined(__GNUC__)
+#define FILTERING_API __attribute__((visibility("default")))
+#else
+#define FILTERING_API
+#endif
+
+
+/**
+ * C interface of the filtering strategies, exported by libfiltering.so.
+ * A filter is created once for a metric, a strategy, k and epsilon, and can then be run by many threads at the same
+ * time on lists owned by the caller. The relevances are read in place and the indices of the elements selected are
+ * written into buffers provided by the caller, which must have room for at least k indices per list.
+ * All the functions returning an int return FILTERING_OK on success, or an error code whose message is available
+ * from filtering_last_error on the same thread. No C++ exception crosses the interface.
+ */
+
+/**
+ * Version of the interface, incremented on every incompatible change
+ */
+#define FILTERING_ABI_VERSION 1
+
+/**
+ * Error codes
+ */
+#define FILTERING_OK 0
+#define FILTERING_ERROR_INVALID_ARGUMENT 1
+#define FILTERING_ERROR_OUT_OF_MEMORY 2
+#define FILTERING_ERROR_INTERNAL 3
+
+/**
+ * Search quality metrics
+ */
+#define FILTERING_METRIC_DCG 0
+#define FILTERING_METRIC_DCGLZ 1
+
+/**
+ * Filtering strategies: the optimal filter alone, or preceded by the cutoff, topk, or epsilon pruner
+ */
+#define FILTERING_STRATEGY_OPT 0
+#define FILTERING_STRATEGY_CUTOFF 1
+#define FILTERING_STRATEGY_TOPK 2
+#define FILTERING_STRATEGY_EPSFILTERING 3
+
+/**
+ * Opaque handle of a filter
+ */
+typedef struct filtering_filter filtering_filter;
+
+/**
+ * Version of the interface implemented by the library, to be compared with FILTERING_ABI_VERSION
+ * @return The version
+ */
+FILTERING_API unsigned int
+filtering_abi_version(void);
+
+/**
+ * Message of the last error occurred on the calling thread
+ * @return The message, valid until the next call on the same thread, or an empty string
+ */
+FILTERING_API const char *
+filtering_last_error(void);
+
+/**
+ * Creates a filter
+ * @param metric The search quality metric, one of FILTERING_METRIC_*
+ * @param strategy The filtering strategy, one of FILTERING_STRATEGY_*
+ * @param k The maximum number of elements to select, greater than zero
+ * @param epsilon The target approximation factor in (0, 1), used only by FILTERING_STRATEGY_EPSFILTERING
+ * @param filter Where to store the handle of the filter
+ * @return FILTERING_OK, or an error code
+ */
+FILTERING_API int
+filtering_filter_create(int metric, int strategy, uint16_t k, float epsilon, filtering_filter **filter);
+
+/**
+ * Destroys a filter. Passing NULL is allowed
+ * @param filter The filter
+ */
+FILTERING_API void
+filtering_filter_destroy(filtering_filter *filter);
+
+/**
+ * Maximum number of elements selected by a filter, i.e., the size of the index buffer required for each list
+ * @param filter The filter
+ * @return k
+ */
+FILTERING_API uint16_t
+filtering_filter_k(const filtering_filter *filter);
+
+/**
+ * Selects the elements of a list. It can be called by many threads on the same filter
+ * @param filter The filter
+ * @param relevances The estimated relevances of the n elements of the list, in their ranking order
+ * @param n The number of elements of the list
+ * @param indices Where to write the indices of the elements selected, in their ranking order; at least k entries
+ * @param num_indices Where to store the number of elements selected
+ * @param score Where to store the score of the selection, or NULL
+ * @return FILTERING_OK, or an error code
+ */
+FILTERING_API int
+filtering_filter_run(filtering_filter *filter, const float *relevances, uint32_t n,
+                     uint32_t *indices, uint32_t *num_indices, float *score);
+
+/**
+ * Selects the elements of a list within a time budget, starting from the solution of the topk strategy and refining it
+ * with the epsilon pruning and decreasing epsilons, down to the epsilon of the filter, or to the optimal solution for
+ * FILTERING_STRATEGY_OPT, while the next refinement is expected to fit the budget. The first solution is always
+ * computed. It is available only for FILTERING_STRATEGY_OPT and FILTERING_STRATEGY_EPSFILTERING
+ * @param filter The filter
+ * @param relevances The estimated relevances of the n elements of the list, in their ranking order
+ * @param n The number of elements of the list
+ * @param budget_ms The time budget, in milliseconds
+ * @param indices Where to write the indices of the elements selected, in their ranking order; at least k entries
+ * @param num_indices Where to store the number of elements selected
+ * @param score Where to store the score of the selection, or NULL
+ * @param epsilon Where to store the approximation factor proven for the selection, i.e., its score is at least
+ *                (1 - epsilon) times the optimal one, or NULL
+ * @return FILTERING_OK, or an error code
+ */
+FILTERING_API int
+filtering_filter_run_anytime(filtering_filter *filter, const float *relevances, uint32_t n, double budget_ms,
+                             uint32_t *indices, uint32_t *num_indices, float *score, float *epsilon);
+
+/**
+ * Selects the elements of a list and certifies an upper bound on its optimal score without computing the optimal
+ * solution, so that the ratio between the score and the upper bound is a lower bound on the approximation ratio of the
+ * selection. The bound of FILTERING_STRATEGY_EPSFILTERING is derived from the thresholds applied by the epsilon
+ * pruning to the elements pruned, and it is usually much tighter than score / (1 - epsilon). It is available for all
+ * strategies except FILTERING_STRATEGY_CUTOFF, which guarantees no approximation ratio
+ * @param filter The filter
+ * @param relevances The estimated relevances of the n elements of the list, in their ranking order
+ * @param n The number of elements of the list
+ * @param indices Where to write the indices of the elements selected, in their ranking order; at least k entries
+ * @param num_indices Where to store the number of elements selected
+ * @param score Where to store the score of the selection, or NULL
+ * @param upper_bound Where to store the upper bound on the optimal score, or NULL
+ * @return FILTERING_OK, or an error code
+ */
+FILTERING_API int
+filtering_filter_run_certified(filtering_filter *filter, const float *relevances, uint32_t n,
+                               uint32_t *indices, uint32_t *num_indices, float *score, float *upper_bound);
+
+/**
+ * Selects the elements of many lists, in order, on the calling thread
+ * @param filter The filter
+ * @param relevances The relevances of each list
+ * @param sizes The number of elements of each list
+ * @param num_lists The number of lists
+ * @param indices Where to write the indices selected, k entries per list: those of list i start at i * k
+ * @param num_indices Where to store the number of elements selected of each list
+ * @param scores Where to store the score of each list, or NULL
+ * @return FILTERING_OK, or the error code of the first list that failed, whose following lists are not filtered
+ */
+FILTERING_API int
+filtering_filter_run_batch(filtering_filter *filter, const float *const *relevances, const uint32_t *sizes,
+                           size_t num_lists, uint32_t *indices, uint32_t *num_indices, float *scores);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAPI_FILTERING_H */
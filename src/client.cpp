@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+#include "data_structures/latency_histogram.hpp"
+#include "utils/composition.hpp"
+#include "utils/cxxopts.hpp"
+#include "utils/protocol.hpp"
+#include "utils/utils.hpp"
+
+
+/**
+ * Outcome of a benchmark of the server.
+ */
+typedef struct {
+    /**
+     * Number of requests completed after the warmup
+     */
+    std::uint64_t num_requests = 0;
+    /**
+     * Time elapsed from the end of the warmup to the completion of the last request, in seconds
+     */
+    double elapsed = 0;
+    /**
+     * Sum of the round-trip latencies, in milliseconds
+     */
+    double sum_latency = 0;
+    /**
+     * Distribution of the round-trip latencies, in nanoseconds
+     */
+    LatencyHistogram latency;
+    /**
+     * Sum of the times spent by the server in filtering the lists, in milliseconds
+     */
+    double sum_service_time = 0;
+    /**
+     * Distribution of the times spent by the server in filtering the lists, in nanoseconds
+     */
+    LatencyHistogram service_time;
+} BenchmarkOutcome;
+
+
+/**
+ * Sends a request on a connection and waits for its response
+ * @param fd The connection
+ * @param frame The frame of the request
+ * @param request_id The id of the request
+ * @param payload A buffer for the payload of the response
+ * @param response Where to store the response
+ * @throws std::runtime_error if the communication fails or the server answers with an error
+ */
+void
+send_request(int fd, const std::string &frame, std::uint32_t request_id, std::string &payload, protocol::Response &response) {
+    protocol::write_all(fd, frame);
+    protocol::read_frame(fd, payload);
+    protocol::decode_response(payload.data(), payload.size(), response);
+    if (response.request_id != request_id) {
+        throw std::runtime_error("The response does not match the request");
+    }
+    if (response.status != 0) {
+        throw std::runtime_error(std::string("The server answered with an error: ") + response.error);
+    }
+}
+
+
+/**
+ * Replays the requests against the server in a closed loop: each connection sends a new request as soon as the
+ * response of the previous one arrives
+ * @param frames The frames of the requests, replayed in a round-robin order
+ * @param socket_path The path of the Unix domain socket of the server, or an empty string
+ * @param port The TCP port of the server
+ * @param num_connections The number of concurrent connections
+ * @param warmup The duration of the warmup, whose requests are not recorded, in seconds
+ * @param duration The duration of the measurement, in seconds
+ * @return The outcome of the benchmark
+ */
+BenchmarkOutcome
+run_benchmark(const std::vector<std::string> &frames, const std::string &socket_path, int port,
+              std::size_t num_connections, double warmup, double duration) {
+    const std::uint64_t warmup_ns = static_cast<std::uint64_t>(warmup * 1e9);
+    const std::uint64_t end_ns = warmup_ns + static_cast<std::uint64_t>(duration * 1e9);
+
+    std::atomic<std::size_t> next_request(0);
+    std::vector<BenchmarkOutcome> outcomes(num_connections);
+    std::vector<std::uint64_t> last_completion(num_connections, 0);
+    std::vector<std::string> errors(num_connections);
+    std::vector<int> fds;
+    for (std::size_t c = 0; c < num_connections; ++c) {
+        fds.push_back(protocol::connect_socket(socket_path, port));
+    }
+    std::vector<std::thread> connections;
+    const std::uint64_t start = get_time_nanoseconds();
+
+    auto connection_loop = [&](std::size_t connection_id) {
+        BenchmarkOutcome &outcome = outcomes[connection_id];
+        std::string frame;
+        std::string payload;
+        protocol::Response response;
+        try {
+            while (true) {
+                const std::uint64_t begin = get_time_nanoseconds() - start;
+                if (begin >= end_ns) {
+                    break;
+                }
+                const std::uint32_t request_id = static_cast<std::uint32_t>(next_request++);
+                frame = frames[request_id % frames.size()];
+                std::memcpy(&frame[sizeof(std::uint32_t)], &request_id, sizeof(request_id));
+                send_request(fds[connection_id], frame, request_id, payload, response);
+                const std::uint64_t completion = get_time_nanoseconds() - start;
+
+                if (begin >= warmup_ns) {
+                    ++outcome.num_requests;
+                    outcome.sum_latency += (completion - begin) / 1e6;
+                    outcome.latency.record(completion - begin);
+                    outcome.sum_service_time += response.service_time / 1e6;
+                    outcome.service_time.record(response.service_time);
+                    last_completion[connection_id] = std::max(last_completion[connection_id], completion);
+                }
+            }
+        } catch (std::runtime_error & e) {
+            errors[connection_id] = e.what();
+        }
+    };
+    for (std::size_t c = 0; c < num_connections; ++c) {
+        connections.emplace_back(connection_loop, c);
+    }
+    for (std::thread &connection: connections) {
+        connection.join();
+    }
+    for (std::size_t c = 0; c < num_connections; ++c) {
+        close(fds[c]);
+        if (!errors[c].empty()) {
+            throw std::runtime_error(errors[c]);
+        }
+    }
+
+    // merge the outcomes of the connections
+    BenchmarkOutcome outcome;
+    std::uint64_t end = warmup_ns;
+    for (std::size_t c = 0; c < num_connections; ++c) {
+        outcome.num_requests += outcomes[c].num_requests;
+        outcome.sum_latency += outcomes[c].sum_latency;
+        outcome.latency.merge(outcomes[c].latency);
+        outcome.sum_service_time += outcomes[c].sum_service_time;
+        outcome.service_time.merge(outcomes[c].service_time);
+        end = std::max(end, last_completion[c]);
+    }
+    outcome.elapsed = (end - warmup_ns) / 1e9;
+    return outcome;
+}
+
+
+int main(int argc, char *argv[]) {
+    // command line options
+    cxxopts::Options options(argv[0], "Sends the lists to the filtering server and prints the ids to select, or benchmarks the latency of the server");
+    options
+            .add_options()
+            ("h, help", "Print this help message")
+            ("socket", "Path of the Unix domain socket of the server", cxxopts::value<std::string>())
+            ("port", "TCP port of the server on the loopback interface, if no socket is given", cxxopts::value<int>()->default_value("0"))
+            ("s, strategy", "The filtering strategy. Available options are: opt, cutoff, topk, epsfiltering", cxxopts::value<std::string>()->default_value("epsfiltering"))
+            ("n, n-cut", "Truncate all lists to the first n elements, if n is greater than zero", cxxopts::value<index_type>()->default_value("0"))
+            ("k", "Maximum number of elements to return", cxxopts::value<k_type>()->default_value("50"))
+            ("e, epsilon", "Target approximation factor", cxxopts::value<score_type>()->default_value("0.01"))
+            ("show-latency", "Print the latency of each request on the standard error", cxxopts::value<bool>()->default_value("false"))
+            ("b, benchmark", "Replay the lists in a closed loop and print the throughput and the latencies instead of the ids", cxxopts::value<bool>()->default_value("false"))
+            ("c, connections", "Number of concurrent connections of the benchmark", cxxopts::value<int>()->default_value("1"))
+            ("d, duration", "Duration of the benchmark, in seconds", cxxopts::value<double>()->default_value("5"))
+            ("warmup", "Duration of the warmup before the benchmark, in seconds", cxxopts::value<double>()->default_value("1"))
+            ("o, output", "Write result to FILE instead of standard output", cxxopts::value<std::string>());
+    options
+            .add_options("hidden")
+            ("positional", "Positional arguments: these are the arguments that are entered without an option", cxxopts::value<std::vector<std::string>>());
+
+    options.parse_positional({"positional"});
+
+    // command line parsing
+    cxxopts::ParseResult arguments = options.parse(argc, argv);
+
+    // help
+    if (arguments.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    // parameters
+    std::vector<std::string> param_file_path_list;
+    const std::string param_socket_path = arguments.count("socket") ? arguments["socket"].as<std::string>() : std::string();
+    const int        param_port = arguments["port"].as<int>();
+    const index_type param_n_cut = arguments["n-cut"].as<index_type>();
+    const k_type     param_k = arguments["k"].as<k_type>();
+    const score_type param_epsilon = arguments["epsilon"].as<score_type>();
+    const bool       param_show_latency = arguments["show-latency"].as<bool>();
+    const bool       param_benchmark = arguments["benchmark"].as<bool>();
+    const int        param_connections = arguments["connections"].as<int>();
+    const double     param_warmup = arguments["warmup"].as<double>();
+    const double     param_duration = arguments["duration"].as<double>();
+    std::uint8_t     param_strategy = 0;
+    std::ofstream * param_ofstream = nullptr;
+
+    try {
+        // check the command line parameters
+        if (arguments.count("positional")) {
+            param_file_path_list = arguments["positional"].as<std::vector<std::string>>();
+            for (const std::string &file_path: param_file_path_list) {
+                struct stat s;
+                if (stat(file_path.c_str(), &s) != 0) {
+                    throw std::runtime_error(std::string("Unable to access the stats of the file: ") + file_path);
+                } else if (!(s.st_mode & S_IFREG)) {
+                    throw std::runtime_error(std::string("Unable to recognize the file: ") + file_path);
+                }
+            }
+        }
+        if (param_socket_path.empty() && (param_port <= 0 || param_port > 65535)) {
+            throw std::runtime_error("Either the parameter socket or a port between 1 and 65535 is required");
+        }
+        param_strategy = protocol::strategy_code(arguments["strategy"].as<std::string>());
+        if (param_k <= 0) {
+            throw std::runtime_error("The parameter k must be strictly greater than 0");
+        }
+        if (param_connections <= 0) {
+            throw std::runtime_error("The parameter connections must be a number strictly greater than 0");
+        }
+        if (param_warmup < 0 || param_duration <= 0) {
+            throw std::runtime_error("The parameter warmup must be non-negative and the parameter duration must be positive");
+        }
+
+        // param output
+        if (arguments.count("output")) {
+            std::string output_file_path = arguments["output"].as<std::string>();
+            param_ofstream = new std::ofstream(output_file_path);
+            if (!param_ofstream->is_open()) {
+                throw std::runtime_error(std::string("Unable to open the output file ") + output_file_path);
+            }
+        }
+
+        // READ the lists, a single one from the standard input unless it starts with their number as in assessment
+        std::vector<ResultsList> lists;
+        if (!param_file_path_list.empty()) {
+            for (const std::string &file_path: param_file_path_list) {
+                std::ifstream istream_file(file_path);
+                lists.push_back(read_results_list(istream_file, true));
+            }
+        } else if (param_benchmark) {
+            std::size_t num_lists;
+            if (!(std::cin >> num_lists)) {
+                throw std::runtime_error("The input stream is not properly formatted. Unable to extract the number of lists");
+            }
+            std::cin.ignore();
+            for (std::size_t i = 0; i < num_lists; ++i) {
+                lists.push_back(read_results_list(std::cin, false));
+            }
+        } else {
+            lists.push_back(read_results_list(std::cin, false));
+        }
+
+        // encode the requests
+        std::vector<std::string> frames;
+        std::vector<std::size_t> frame_list;
+        for (std::size_t i = 0; i < lists.size(); ++i) {
+            const std::size_t n = (param_n_cut > 0) ? std::min(lists[i].size(), static_cast<std::size_t>(param_n_cut)) : lists[i].size();
+            if (n == 0) {
+                continue;
+            }
+            protocol::Request request;
+            request.request_id = static_cast<std::uint32_t>(frames.size());
+            request.strategy = param_strategy;
+            request.k = param_k;
+            request.epsilon = param_epsilon;
+            request.relevances.assign(lists[i].relevances.begin(), lists[i].relevances.begin() + n);
+            frames.emplace_back();
+            protocol::encode_request(frames.back(), request);
+            frame_list.push_back(i);
+        }
+        if (frames.empty()) {
+            throw std::runtime_error("The input does not contain any list");
+        }
+
+        // select the output stream
+        std::ostream & ostream = (param_ofstream != nullptr) ? *param_ofstream : std::cout;
+
+        if (param_benchmark) {
+            // BENCHMARK the server
+            const BenchmarkOutcome outcome = run_benchmark(frames, param_socket_path, param_port, param_connections, param_warmup, param_duration);
+            const double qps = (outcome.elapsed > 0) ? outcome.num_requests / outcome.elapsed : 0.0;
+            ostream << "{\"strategy\": \"" << protocol::strategy_codes[param_strategy] << "\"";
+            ostream << ", \"n_cut\": " << param_n_cut;
+            ostream << ", \"k\": " << param_k;
+            ostream << ", \"connections\": " << param_connections;
+            ostream << ", \"requests\": " << outcome.num_requests;
+            ostream << ", \"elapsed\": " << outcome.elapsed;
+            ostream << ", \"qps\": " << qps;
+            ostream << ", \"avg_latency\": " << ((outcome.num_requests > 0) ? outcome.sum_latency / outcome.num_requests : 0.0);
+            ostream << ", \"latency_percentiles\": "; TestsAggregationOutcome::write_percentiles(ostream, outcome.latency);
+            ostream << ", \"avg_service_time\": " << ((outcome.num_requests > 0) ? outcome.sum_service_time / outcome.num_requests : 0.0);
+            ostream << ", \"service_time_percentiles\": "; TestsAggregationOutcome::write_percentiles(ostream, outcome.service_time);
+            ostream << "}" << std::endl;
+        } else {
+            // FILTER each list and print the ids of the elements selected, with an empty line between two lists
+            const int fd = protocol::connect_socket(param_socket_path, param_port);
+            std::string payload;
+            protocol::Response response;
+            for (std::size_t r = 0; r < frames.size(); ++r) {
+                const std::uint64_t start = get_time_nanoseconds();
+                send_request(fd, frames[r], static_cast<std::uint32_t>(r), payload, response);
+                const double latency = get_elapsed_milliseconds(start, get_time_nanoseconds());
+                if (param_show_latency) {
+                    std::cerr << "{\"list\": " << frame_list[r] << ", \"latency\": " << latency
+                              << ", \"service_time\": " << response.service_time / 1e6 << "}" << std::endl;
+                }
+                if (r > 0) {
+                    ostream << std::endl;
+                }
+                const ResultsList &resultsList = lists[frame_list[r]];
+                for (std::uint32_t index: response.indices) {
+                    if (index >= resultsList.ids.size()) {
+                        close(fd);
+                        throw std::runtime_error("The server returned an index out of the list " + std::to_string(frame_list[r]));
+                    }
+                    ostream << resultsList.ids[index] << std::endl;
+                }
+            }
+            close(fd);
+        }
+    } catch (std::runtime_error & e) {
+        std::cerr << e.what() << "." << std::endl;
+        return -1;
+    }
+
+    // close the file output stream
+    if (param_ofstream != nullptr) {
+        param_ofstream->close();
+        delete(param_ofstream);
+    }
+
+    return 0;
+}
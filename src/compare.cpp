@@ -0,0 +1,261 @@
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include "utils/cxxopts.hpp"
+#include "utils/json.hpp"
+#include "utils/statistics.hpp"
+
+
+/**
+ * Times of a benchmark, by the id of the sample: the id of the list, for the list logs, or the position of the
+ * repetition, for the microbench outputs.
+ */
+typedef std::map<std::size_t, double> TimeSamples;
+
+
+/**
+ * Reads the total times of the strategies from a list log written by assessment with --list-log, one sample per list
+ * for each (n_cut, k, strategy). The lists not timed (e.g., the optimal solutions found in the OPT cache) are skipped.
+ * @param infile The list log, in the jsonl format
+ * @param samples Where to store the samples, by key
+ */
+void
+read_list_log_samples(std::istream &infile, std::map<std::string, TimeSamples> &samples) {
+    std::string line;
+    while (std::getline(infile, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        std::istringstream line_stream(line);
+        const JsonValue record = JsonValue::parse(line_stream);
+        const std::size_t list_id = static_cast<std::size_t>(record["list"].as_number());
+        for (const auto &strategy: record["strategies"].as_object()) {
+            const double total_time = strategy.second["total_time"].as_number();
+            if (total_time <= 0) {
+                continue;
+            }
+            std::ostringstream key;
+            key << "n_cut=" << record["n_cut"].as_number() << " k=" << record["k"].as_number() << " " << strategy.first;
+            samples[key.str()][list_id] = total_time;
+        }
+    }
+}
+
+
+/**
+ * Reads the times of the benchmarks from a microbench output, which contains each benchmark and parameters once.
+ * The samples are the times per iteration of the repetitions.
+ * @param document The json document written by microbench
+ * @param samples Where to store the samples, by key
+ * @throws std::runtime_error if a benchmark and parameters appear twice
+ */
+void
+read_microbench_samples(const JsonValue &document, std::map<std::string, TimeSamples> &samples) {
+    for (const JsonValue &benchmark: document["benchmarks"].as_array()) {
+        std::ostringstream key;
+        key << benchmark["name"].as_string();
+        for (const auto &param: benchmark["params"].as_object()) {
+            key << " " << param.first << "=" << param.second.as_number();
+        }
+        if (samples.count(key.str())) {
+            throw std::runtime_error(std::string("The microbench output contains the benchmark twice: ") + key.str());
+        }
+        TimeSamples &benchmark_samples = samples[key.str()];
+        for (const JsonValue &sample: benchmark["samples_ns"].as_array()) {
+            benchmark_samples[benchmark_samples.size()] = sample.as_number();
+        }
+    }
+}
+
+
+/**
+ * Reads the samples from a list log of assessment or a microbench output
+ * @param file_path The path of the file
+ * @param samples Where to store the samples, by key
+ * @return The kind of the file: list_log or microbench
+ */
+std::string
+read_samples(const std::string &file_path, std::map<std::string, TimeSamples> &samples) {
+    std::ifstream infile(file_path);
+    if (!infile.is_open()) {
+        throw std::runtime_error(std::string("Unable to open the file ") + file_path);
+    }
+    // a list log is made of a json object per line
+    std::string first_line;
+    std::getline(infile, first_line);
+    std::istringstream first_line_stream(first_line);
+    JsonValue first_value;
+    try {
+        first_value = JsonValue::parse(first_line_stream);
+    } catch (std::runtime_error &) {
+    }
+    if (first_value.is_object() && first_value.has("list") && first_value.has("strategies")) {
+        infile.clear();
+        infile.seekg(0);
+        read_list_log_samples(infile, samples);
+        return "list_log";
+    }
+
+    infile.clear();
+    infile.seekg(0);
+    const JsonValue document = JsonValue::parse(infile);
+    if (document.is_array()) {
+        throw std::runtime_error(std::string("The assessment reports contain no per-list times, compare the list logs written by assessment with --list-log instead: ") + file_path);
+    } else if (document.is_object() && document.has("format") && document["format"].as_string() == "microbench") {
+        read_microbench_samples(document, samples);
+        return "microbench";
+    }
+    throw std::runtime_error(std::string("The file is neither a list log of assessment nor a microbench output: ") + file_path);
+}
+
+
+int main(int argc, char *argv[]) {
+    // command line options
+    cxxopts::Options options(argv[0], "Compares the times of a candidate assessment list log, or microbench output, with a baseline and exits with status 1 if some of them are significantly slower");
+    options
+            .add_options()
+            ("h, help", "Print this help message")
+            ("c, confidence", "Confidence level of the intervals of the differences", cxxopts::value<double>()->default_value("0.95"))
+            ("t, threshold", "Relative slowdown tolerated, e.g., 0.02 for 2%", cxxopts::value<double>()->default_value("0.02"))
+            ("o, output", "Write result to FILE instead of standard output", cxxopts::value<std::string>());
+    options
+            .add_options("hidden")
+            ("positional", "Positional arguments: these are the arguments that are entered without an option", cxxopts::value<std::vector<std::string>>());
+
+    options.parse_positional({"positional"});
+
+    // command line parsing
+    cxxopts::ParseResult arguments = options.parse(argc, argv);
+
+    // help
+    if (arguments.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    const double param_confidence = arguments["confidence"].as<double>();
+    const double param_threshold = arguments["threshold"].as<double>();
+    std::map<std::string, TimeSamples> baseline, candidate;
+    std::string kind;
+    std::ofstream * param_ofstream = nullptr;
+
+    try {
+        if (param_confidence <= 0 || param_confidence >= 1) {
+            throw std::runtime_error("The parameter confidence must be a number between zero and one");
+        }
+        if (param_threshold < 0) {
+            throw std::runtime_error("The parameter threshold must be a number greater or equal than 0");
+        }
+        if (!arguments.count("positional") || arguments["positional"].as<std::vector<std::string>>().size() != 2) {
+            throw std::runtime_error("The baseline and the candidate files are required");
+        }
+        const std::vector<std::string> &file_paths = arguments["positional"].as<std::vector<std::string>>();
+        kind = read_samples(file_paths[0], baseline);
+        if (read_samples(file_paths[1], candidate) != kind) {
+            throw std::runtime_error("The baseline and the candidate files are of different kinds");
+        }
+
+        // param output
+        if (arguments.count("output")) {
+            std::string output_file_path = arguments["output"].as<std::string>();
+            param_ofstream = new std::ofstream(output_file_path);
+            if (!param_ofstream->is_open()) {
+                throw std::runtime_error(std::string("Unable to open the output file ") + output_file_path);
+            }
+        }
+    } catch (std::runtime_error & e) {
+        std::cerr << e.what() << "." << std::endl;
+        return -1;
+    }
+
+    // select the output stream
+    std::ostream & ostream = (param_ofstream != nullptr) ? *param_ofstream : std::cout;
+
+    // COMPARE the times: a regression is a slowdown whose confidence interval lies entirely above the threshold. The
+    // times of the same lists are paired, so that the interval measures the noise between the runs and not the
+    // variability among the lists, while the repetitions of the microbenchmarks are independent
+    const bool paired = (kind == "list_log");
+    std::size_t num_compared = 0, num_regressions = 0, num_improvements = 0, num_inconclusive = 0;
+    for (const auto &entry: baseline) {
+        auto it = candidate.find(entry.first);
+        if (it == candidate.end()) {
+            std::cerr << "Warning: " << entry.first << " is missing in the candidate." << std::endl;
+            continue;
+        }
+        std::vector<double> base_samples, cand_samples;
+        for (const auto &sample: entry.second) {
+            if (paired) {
+                auto paired_sample = it->second.find(sample.first);
+                if (paired_sample == it->second.end()) {
+                    continue;
+                }
+                cand_samples.push_back(paired_sample->second);
+            }
+            base_samples.push_back(sample.second);
+        }
+        if (!paired) {
+            for (const auto &sample: it->second) {
+                cand_samples.push_back(sample.second);
+            }
+        }
+        const SampleSummary base = summarize_samples(base_samples);
+        const SampleSummary cand = summarize_samples(cand_samples);
+        if (base.count == 0 || cand.count == 0 || base.mean <= 0) {
+            continue;
+        }
+        const DifferenceInterval interval = paired ? paired_interval(base_samples, cand_samples, param_confidence) :
+                                            welch_interval(base, cand, param_confidence);
+        const double change = interval.difference / base.mean;
+        const double change_low = interval.low / base.mean;
+        const double change_high = interval.high / base.mean;
+
+        std::string status = "unchanged";
+        if (!std::isfinite(change_low) || !std::isfinite(change_high)) {
+            // too few samples to estimate the noise
+            status = "inconclusive";
+            ++num_inconclusive;
+        } else if (change_low > param_threshold) {
+            status = "regression";
+            ++num_regressions;
+        } else if (change_high < -param_threshold) {
+            status = "improvement";
+            ++num_improvements;
+        }
+        ++num_compared;
+
+        ostream << "{\"key\": "; write_json_string(ostream, entry.first);
+        ostream << ", \"baseline_mean\": " << base.mean;
+        ostream << ", \"baseline_stddev\": " << base.stddev;
+        ostream << ", \"baseline_count\": " << base.count;
+        ostream << ", \"candidate_mean\": " << cand.mean;
+        ostream << ", \"candidate_stddev\": " << cand.stddev;
+        ostream << ", \"candidate_count\": " << cand.count;
+        ostream << ", \"change\": " << change;
+        if (status != "inconclusive") {
+            ostream << ", \"change_low\": " << change_low;
+            ostream << ", \"change_high\": " << change_high;
+        } else {
+            ostream << ", \"change_low\": null, \"change_high\": null";
+        }
+        ostream << ", \"status\": \"" << status << "\"}" << std::endl;
+    }
+    for (const auto &entry: candidate) {
+        if (baseline.find(entry.first) == baseline.end()) {
+            std::cerr << "Warning: " << entry.first << " is missing in the baseline." << std::endl;
+        }
+    }
+    ostream << "{\"compared\": " << num_compared << ", \"regressions\": " << num_regressions
+            << ", \"improvements\": " << num_improvements << ", \"inconclusive\": " << num_inconclusive << "}" << std::endl;
+
+    // close the file output stream
+    if (param_ofstream != nullptr) {
+        param_ofstream->close();
+        delete(param_ofstream);
+    }
+
+    return (num_regressions > 0) ? 1 : 0;
+}
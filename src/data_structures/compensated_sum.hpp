@@ -0,0 +1,162 @@
+#ifndef DATA_STRUCTURES_COMPENSATED_SUM_HPP
+#define DATA_STRUCTURES_COMPENSATED_SUM_HPP
+
+#include <cmath>
+#include <cstddef>
+
+
+/**
+ * Sum of floating point values with the compensated summation of Kahan, in the variant of Neumaier that also handles
+ * addends greater than the running sum. The rounding error of each addition is kept apart and added back, thus the
+ * error of the sum does not grow with the number of values added.
+ * Must not be compiled with -ffast-math, which would optimize the compensation away.
+ */
+class CompensatedSum {
+public:
+    /**
+     * Adds a value to the sum
+     * @param value The value to add
+     */
+    void
+    add(double value) {
+        const double sum = this->sum_ + value;
+        if (std::abs(this->sum_) >= std::abs(value)) {
+            this->compensation_ += (this->sum_ - sum) + value;
+        } else {
+            this->compensation_ += (value - sum) + this->sum_;
+        }
+        this->sum_ = sum;
+    }
+
+    /**
+     * Merges another sum into this one
+     * @param other The sum to merge
+     */
+    void
+    merge(const CompensatedSum &other) {
+        this->add(other.sum_);
+        this->compensation_ += other.compensation_;
+    }
+
+    /**
+     * Replaces the sum with the given value, e.g., read from a file
+     * @param value The new value of the sum
+     */
+    void
+    assign(double value) {
+        this->sum_ = value;
+        this->compensation_ = 0;
+    }
+
+    /**
+     * Value of the sum
+     */
+    double
+    value() const {
+        return this->sum_ + this->compensation_;
+    }
+
+private:
+    double sum_ = 0;
+    double compensation_ = 0;
+};
+
+
+/**
+ * Running mean and variance of a sequence of values, with the algorithm of Welford. The sum of the values is
+ * compensated and the sum of the squared deviations from the mean is updated incrementally, thus the variance does not
+ * suffer from the cancellation of the formula based on the sum of the squares.
+ * Two instances are merged with the pairwise formula of Chan, Golub and LeVeque.
+ */
+class RunningMoments {
+public:
+    /**
+     * Adds a value
+     * @param value The value to add
+     */
+    void
+    add(double value) {
+        const double delta = value - this->mean();
+        this->count_ += 1;
+        this->sum_.add(value);
+        this->m2_ += delta * (value - this->mean());
+    }
+
+    /**
+     * Merges other moments into these ones
+     * @param other The moments to merge
+     */
+    void
+    merge(const RunningMoments &other) {
+        if (other.count_ == 0) {
+            return;
+        }
+        const double delta = other.mean() - this->mean();
+        const double count = static_cast<double>(this->count_);
+        const double other_count = static_cast<double>(other.count_);
+        this->m2_ += other.m2_ + delta * delta * count * other_count / (count + other_count);
+        this->count_ += other.count_;
+        this->sum_.merge(other.sum_);
+    }
+
+    /**
+     * Replaces the moments with the given ones, e.g., read from a file
+     * @param count The number of values
+     * @param sum The sum of the values
+     * @param m2 The sum of the squared deviations of the values from their mean
+     */
+    void
+    assign(std::size_t count, double sum, double m2) {
+        this->count_ = count;
+        this->sum_.assign(sum);
+        this->m2_ = m2;
+    }
+
+    /**
+     * Number of values added
+     */
+    std::size_t
+    count() const {
+        return this->count_;
+    }
+
+    /**
+     * Sum of the values
+     */
+    double
+    sum() const {
+        return this->sum_.value();
+    }
+
+    /**
+     * Sum of the squared deviations of the values from their mean
+     */
+    double
+    m2() const {
+        return this->m2_;
+    }
+
+    /**
+     * Mean of the values, or zero if there are none
+     */
+    double
+    mean() const {
+        return (this->count_ > 0) ? this->sum_.value() / this->count_ : 0.0;
+    }
+
+    /**
+     * Sample variance of the values, or zero if there are less than two
+     */
+    double
+    variance() const {
+        return (this->count_ > 1) ? this->m2_ / (this->count_ - 1) : 0.0;
+    }
+
+private:
+    std::size_t count_ = 0;
+    CompensatedSum sum_;
+    double m2_ = 0;
+};
+
+
+#endif //DATA_STRUCTURES_COMPENSATED_SUM_HPP
@@ -0,0 +1,128 @@
+#ifndef DATA_STRUCTURES_HASH_HPP
+#define DATA_STRUCTURES_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+
+/**
+ * Fast non-cryptographic 64-bit hash of a sequence of bytes, used to address the lists by their content.
+ *
+ * @note It is the XXH64 function of xxHash by Yann Collet, https://github.com/Cyan4973/xxHash
+ */
+struct hash64 {
+public:
+    /**
+     * Hashes a sequence of bytes
+     * @param data The bytes
+     * @param length The number of bytes
+     * @param seed The seed, which selects a different hash function
+     * @return The hash
+     */
+    static inline std::uint64_t
+    hash(const void *data, std::size_t length, std::uint64_t seed=0) {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        const unsigned char *const end = p + length;
+        std::uint64_t h;
+
+        if (length >= 32) {
+            const unsigned char *const limit = end - 32;
+            std::uint64_t v1 = seed + prime1 + prime2;
+            std::uint64_t v2 = seed + prime2;
+            std::uint64_t v3 = seed;
+            std::uint64_t v4 = seed - prime1;
+            do {
+                v1 = round(v1, read64(p)); p += 8;
+                v2 = round(v2, read64(p)); p += 8;
+                v3 = round(v3, read64(p)); p += 8;
+                v4 = round(v4, read64(p)); p += 8;
+            } while (p <= limit);
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = merge_round(h, v1);
+            h = merge_round(h, v2);
+            h = merge_round(h, v3);
+            h = merge_round(h, v4);
+        } else {
+            h = seed + prime5;
+        }
+        h += static_cast<std::uint64_t>(length);
+
+        while (p + 8 <= end) {
+            h ^= round(0, read64(p));
+            h = rotl(h, 27) * prime1 + prime4;
+            p += 8;
+        }
+        if (p + 4 <= end) {
+            h ^= static_cast<std::uint64_t>(read32(p)) * prime1;
+            h = rotl(h, 23) * prime2 + prime3;
+            p += 4;
+        }
+        while (p < end) {
+            h ^= (*p) * prime5;
+            h = rotl(h, 11) * prime1;
+            ++p;
+        }
+
+        h ^= h >> 33;
+        h *= prime2;
+        h ^= h >> 29;
+        h *= prime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    /**
+     * Hashes a string
+     * @param value The string
+     * @param seed The seed, which selects a different hash function
+     * @return The hash
+     */
+    static inline std::uint64_t
+    hash(const std::string &value, std::uint64_t seed=0) {
+        return hash(value.data(), value.size(), seed);
+    }
+
+private:
+    static const std::uint64_t prime1 = 11400714785074694791ULL;
+    static const std::uint64_t prime2 = 14029467366897019727ULL;
+    static const std::uint64_t prime3 = 1609587929392839161ULL;
+    static const std::uint64_t prime4 = 9650029242287828579ULL;
+    static const std::uint64_t prime5 = 2870177450012600261ULL;
+
+    static inline std::uint64_t
+    rotl(std::uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    static inline std::uint64_t
+    read64(const unsigned char *p) {
+        std::uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static inline std::uint32_t
+    read32(const unsigned char *p) {
+        std::uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static inline std::uint64_t
+    round(std::uint64_t accumulator, std::uint64_t input) {
+        accumulator += input * prime2;
+        accumulator = rotl(accumulator, 31);
+        return accumulator * prime1;
+    }
+
+    static inline std::uint64_t
+    merge_round(std::uint64_t accumulator, std::uint64_t value) {
+        accumulator ^= round(0, value);
+        return accumulator * prime1 + prime4;
+    }
+};
+
+
+#endif //DATA_STRUCTURES_HASH_HPP
@@ -0,0 +1,203 @@
+#ifndef DATA_STRUCTURES_LATENCY_HISTOGRAM_HPP
+#define DATA_STRUCTURES_LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+/**
+ * Histogram of non-negative integer values (e.g., latencies in nanoseconds) with log-linear buckets, in the style of
+ * HdrHistogram. The values smaller than 2^precision_bits are counted exactly, while the greater ones are counted in
+ * 2^(precision_bits-1) buckets per power of two, thus with a relative error smaller than 2^-(precision_bits-1).
+ * Two histograms can be merged by summing their counters.
+ */
+class LatencyHistogram {
+public:
+    /**
+     * Number of bits of precision of the buckets
+     */
+    static const unsigned precision_bits = 8;
+
+    /**
+     * Adds a value to the histogram
+     * @param value The value to record
+     * @param count The number of occurrences of the value
+     */
+    void
+    record(std::uint64_t value, std::uint64_t count=1) {
+        if (count == 0) {
+            return;
+        }
+        std::size_t index = LatencyHistogram::bucket_index(value);
+        if (index >= this->counts.size()) {
+            this->counts.resize(index + 1, 0);
+        }
+        this->counts[index] += count;
+        if (this->total_count == 0 || value < this->min_value) {
+            this->min_value = value;
+        }
+        if (this->total_count == 0 || value > this->max_value) {
+            this->max_value = value;
+        }
+        this->total_count += count;
+    }
+
+    /**
+     * Merges another histogram into this one
+     * @param other The histogram to merge
+     */
+    void
+    merge(const LatencyHistogram &other) {
+        if (other.total_count == 0) {
+            return;
+        }
+        if (other.counts.size() > this->counts.size()) {
+            this->counts.resize(other.counts.size(), 0);
+        }
+        for (std::size_t i = 0, i_end = other.counts.size(); i < i_end; ++i) {
+            this->counts[i] += other.counts[i];
+        }
+        if (this->total_count == 0 || other.min_value < this->min_value) {
+            this->min_value = other.min_value;
+        }
+        if (this->total_count == 0 || other.max_value > this->max_value) {
+            this->max_value = other.max_value;
+        }
+        this->total_count += other.total_count;
+    }
+
+    /**
+     * Number of values recorded
+     */
+    std::uint64_t
+    count() const {
+        return this->total_count;
+    }
+
+    /**
+     * Minimum value recorded, or zero if the histogram is empty
+     */
+    std::uint64_t
+    min() const {
+        return this->min_value;
+    }
+
+    /**
+     * Maximum value recorded, or zero if the histogram is empty
+     */
+    std::uint64_t
+    max() const {
+        return this->max_value;
+    }
+
+    /**
+     * Gets the value at the given percentile, i.e., the highest value equivalent to the bucket containing the
+     * smallest value greater or equal than the given percentage of the recorded values
+     * @param percentile The percentile, in the range [0, 100]
+     * @return The value at the given percentile, or zero if the histogram is empty
+     */
+    std::uint64_t
+    value_at_percentile(double percentile) const {
+        if (this->total_count == 0) {
+            return 0;
+        }
+        percentile = std::min(std::max(percentile, 0.0), 100.0);
+        std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * this->total_count));
+        rank = std::max<std::uint64_t>(rank, 1);
+
+        std::uint64_t cumulative_count = 0;
+        for (std::size_t i = 0, i_end = this->counts.size(); i < i_end; ++i) {
+            cumulative_count += this->counts[i];
+            if (cumulative_count >= rank) {
+                return std::min(std::max(LatencyHistogram::bucket_highest_value(i), this->min_value), this->max_value);
+            }
+        }
+        return this->max_value;
+    }
+
+    /**
+     * Gets the non-empty buckets of the histogram as pairs (bucket index, count)
+     * @return The list of non-empty buckets
+     */
+    std::vector<std::pair<std::size_t, std::uint64_t>>
+    buckets() const {
+        std::vector<std::pair<std::size_t, std::uint64_t>> result;
+        for (std::size_t i = 0, i_end = this->counts.size(); i < i_end; ++i) {
+            if (this->counts[i] > 0) {
+                result.emplace_back(i, this->counts[i]);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Builds a histogram from the buckets returned by buckets() and the minimum and maximum values
+     * @param buckets The list of non-empty buckets
+     * @param min_value The minimum value recorded
+     * @param max_value The maximum value recorded
+     * @return The histogram
+     */
+    static LatencyHistogram
+    from_buckets(const std::vector<std::pair<std::size_t, std::uint64_t>> &buckets, std::uint64_t min_value, std::uint64_t max_value) {
+        LatencyHistogram histogram;
+        for (const auto &bucket: buckets) {
+            if (bucket.first >= histogram.counts.size()) {
+                histogram.counts.resize(bucket.first + 1, 0);
+            }
+            histogram.counts[bucket.first] += bucket.second;
+            histogram.total_count += bucket.second;
+        }
+        if (histogram.total_count > 0) {
+            histogram.min_value = min_value;
+            histogram.max_value = max_value;
+        }
+        return histogram;
+    }
+
+    /**
+     * Gets the index of the bucket containing the given value
+     * @param value The value
+     * @return The index of the bucket
+     */
+    static std::size_t
+    bucket_index(std::uint64_t value) {
+        if (value < (1ull << precision_bits)) {
+            return static_cast<std::size_t>(value);
+        }
+        // position of the most significant bit
+        unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+        unsigned shift = msb - (precision_bits - 1);
+        std::uint64_t mantissa = value >> shift;  // in the range [2^(precision_bits-1), 2^precision_bits)
+        return static_cast<std::size_t>((1ull << precision_bits) + (shift - 1) * (1ull << (precision_bits - 1)) +
+                                        (mantissa - (1ull << (precision_bits - 1))));
+    }
+
+    /**
+     * Gets the highest value contained in the given bucket
+     * @param index The index of the bucket
+     * @return The highest value of the bucket
+     */
+    static std::uint64_t
+    bucket_highest_value(std::size_t index) {
+        if (index < (1ull << precision_bits)) {
+            return index;
+        }
+        std::uint64_t i = index - (1ull << precision_bits);
+        unsigned shift = static_cast<unsigned>(i >> (precision_bits - 1)) + 1;
+        std::uint64_t mantissa = (i & ((1ull << (precision_bits - 1)) - 1)) + (1ull << (precision_bits - 1));
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+private:
+    std::vector<std::uint64_t> counts;
+    std::uint64_t total_count = 0;
+    std::uint64_t min_value = 0;
+    std::uint64_t max_value = 0;
+};
+
+
+#endif //DATA_STRUCTURES_LATENCY_HISTOGRAM_HPP
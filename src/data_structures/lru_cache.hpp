@@ -0,0 +1,231 @@
+#ifndef DATA_STRUCTURES_LRU_CACHE_HPP
+#define DATA_STRUCTURES_LRU_CACHE_HPP
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+/**
+ * Counters of a cache.
+ */
+typedef struct cache_statistics {
+    /**
+     * Number of lookups that found their key
+     */
+    std::uint64_t hits = 0;
+    /**
+     * Number of lookups that did not find their key
+     */
+    std::uint64_t misses = 0;
+    /**
+     * Number of entries inserted
+     */
+    std::uint64_t insertions = 0;
+    /**
+     * Number of entries evicted to make room for the new ones
+     */
+    std::uint64_t evictions = 0;
+    /**
+     * Number of entries in the cache
+     */
+    std::uint64_t entries = 0;
+    /**
+     * Memory charged to the entries in the cache, in bytes
+     */
+    std::uint64_t bytes = 0;
+
+    /**
+     * Adds the counters of another cache, e.g., of another shard
+     * @param other The counters to add
+     */
+    void
+    merge(const struct cache_statistics &other) {
+        this->hits += other.hits;
+        this->misses += other.misses;
+        this->insertions += other.insertions;
+        this->evictions += other.evictions;
+        this->entries += other.entries;
+        this->bytes += other.bytes;
+    }
+
+    /**
+     * Fraction of the lookups that found their key
+     * @return The hit ratio, or zero if there has been no lookup
+     */
+    double
+    hit_ratio() const {
+        const std::uint64_t lookups = this->hits + this->misses;
+        return (lookups > 0) ? static_cast<double>(this->hits) / lookups : 0.0;
+    }
+
+    /**
+     * Writes on the output stream a json representation of the counters
+     * @param os the output stream where to write
+     * @param statistics the counters to write
+     * @return the output stream
+     */
+    friend std::ostream & operator<<(std::ostream &os, const struct cache_statistics &statistics) {
+        os << "{";
+        os << "\"hits\": " << statistics.hits;
+        os << ", \"misses\": " << statistics.misses;
+        os << ", \"hit_ratio\": " << statistics.hit_ratio();
+        os << ", \"insertions\": " << statistics.insertions;
+        os << ", \"evictions\": " << statistics.evictions;
+        os << ", \"entries\": " << statistics.entries;
+        os << ", \"bytes\": " << statistics.bytes;
+        os << "}";
+        return os;
+    }
+} CacheStatistics;
+
+
+/**
+ * Cache with least-recently-used eviction, bounded by the memory charged to its entries and split into shards, each
+ * with its own lock, so that concurrent lookups of different keys rarely contend.
+ * The keys are already uniformly distributed hashes, thus the shard of a key is given by its highest bits.
+ * @tparam Value Type of the values, which must be copyable
+ */
+template <typename Value>
+class ShardedLRUCache {
+public:
+    /**
+     * Type of the keys
+     */
+    typedef std::uint64_t key_type;
+
+    /**
+     * Constructor
+     * @param capacity Maximum memory charged to the entries, in bytes, split evenly among the shards
+     * @param num_shards Number of shards
+     */
+    explicit ShardedLRUCache(std::size_t capacity, std::size_t num_shards=16) {
+        if (num_shards == 0) {
+            throw std::invalid_argument("The parameter num_shards must be a strictly positive number");
+        }
+        for (std::size_t i = 0; i < num_shards; ++i) {
+            this->shards.emplace_back(new shard(capacity / num_shards));
+        }
+    }
+
+    ShardedLRUCache(const ShardedLRUCache &) = delete;
+    ShardedLRUCache & operator=(const ShardedLRUCache &) = delete;
+
+    /**
+     * Looks up a key, marking its entry as the most recently used
+     * @param key The key
+     * @param value Where to copy the value, if found
+     * @return True if the key has been found, false otherwise
+     */
+    bool
+    lookup(key_type key, Value &value) {
+        shard &target = this->shard_of(key);
+        std::lock_guard<std::mutex> lock(target.mutex);
+        auto it = target.index.find(key);
+        if (it == target.index.end()) {
+            ++target.statistics.misses;
+            return false;
+        }
+        target.entries.splice(target.entries.begin(), target.entries, it->second);
+        value = it->second->value;
+        ++target.statistics.hits;
+        return true;
+    }
+
+    /**
+     * Inserts or replaces the value of a key, evicting the least recently used entries of its shard until the memory
+     * charged fits the capacity of the shard. A value larger than the capacity of a shard is not inserted.
+     * @param key The key
+     * @param value The value
+     * @param size The memory charged to the entry, in bytes
+     */
+    void
+    insert(key_type key, const Value &value, std::size_t size) {
+        shard &target = this->shard_of(key);
+        std::lock_guard<std::mutex> lock(target.mutex);
+        if (size > target.capacity) {
+            return;
+        }
+        auto it = target.index.find(key);
+        if (it != target.index.end()) {
+            target.statistics.bytes -= it->second->size;
+            target.entries.erase(it->second);
+            target.index.erase(it);
+            --target.statistics.entries;
+        }
+        while (!target.entries.empty() && target.statistics.bytes + size > target.capacity) {
+            const entry &victim = target.entries.back();
+            target.statistics.bytes -= victim.size;
+            target.index.erase(victim.key);
+            target.entries.pop_back();
+            --target.statistics.entries;
+            ++target.statistics.evictions;
+        }
+        target.entries.push_front(entry{key, value, size});
+        target.index[key] = target.entries.begin();
+        target.statistics.bytes += size;
+        ++target.statistics.entries;
+        ++target.statistics.insertions;
+    }
+
+    /**
+     * Counters of the cache, summed over the shards
+     * @return The counters
+     */
+    CacheStatistics
+    statistics() const {
+        CacheStatistics sum;
+        for (const std::unique_ptr<shard> &s: this->shards) {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            sum.merge(s->statistics);
+        }
+        return sum;
+    }
+
+private:
+    /**
+     * Entry of the cache
+     */
+    struct entry {
+        key_type key;
+        Value value;
+        std::size_t size;
+    };
+
+    /**
+     * Shard of the cache: the entries from the most to the least recently used, and their index by key
+     */
+    struct shard {
+        explicit shard(std::size_t capacity) :
+                capacity(capacity) {
+        }
+
+        const std::size_t capacity;
+        mutable std::mutex mutex;
+        std::list<entry> entries;
+        std::unordered_map<key_type, typename std::list<entry>::iterator> index;
+        CacheStatistics statistics;
+    };
+
+    /**
+     * Shard of the given key
+     * @param key The key
+     * @return The shard
+     */
+    shard &
+    shard_of(key_type key) {
+        return *this->shards[(key >> 32) % this->shards.size()];
+    }
+
+private:
+    std::vector<std::unique_ptr<shard>> shards;
+};
+
+
+#endif //DATA_STRUCTURES_LRU_CACHE_HPP
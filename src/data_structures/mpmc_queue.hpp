@@ -0,0 +1,133 @@
+#ifndef DATA_STRUCTURES_MPMC_QUEUE_HPP
+#define DATA_STRUCTURES_MPMC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+
+/**
+ * Bounded lock-free queue with many producers and many consumers.
+ * Each cell carries a sequence number telling whether it is ready to be written or read at the current position, thus
+ * producers and consumers only compete, with a compare-and-swap, on the position of their own end of the queue.
+ * Both try_push and try_pop fail instead of waiting when the queue is full or empty.
+ *
+ * @note It is the bounded queue of Dmitry Vyukov, http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+ * @tparam T Type of the elements, which must be default constructible and movable
+ */
+template <typename T>
+class MPMCQueue {
+public:
+    /**
+     * Constructor
+     * @param capacity Maximum number of elements in the queue, rounded up to a power of two
+     */
+    explicit MPMCQueue(std::size_t capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("The parameter capacity must be a strictly positive number");
+        }
+        std::size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        this->mask = size - 1;
+        this->cells.reset(new cell[size]);
+        for (std::size_t i = 0; i < size; ++i) {
+            this->cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPMCQueue(const MPMCQueue &) = delete;
+    MPMCQueue & operator=(const MPMCQueue &) = delete;
+
+    /**
+     * Maximum number of elements in the queue
+     * @return The capacity
+     */
+    std::size_t
+    capacity() const {
+        return this->mask + 1;
+    }
+
+    /**
+     * Appends an element to the queue, if it is not full
+     * @param value The element, moved into the queue only on success
+     * @return True if the element has been appended, false if the queue is full
+     */
+    bool
+    try_push(T &value) {
+        std::size_t position = this->enqueue_position.load(std::memory_order_relaxed);
+        cell *target;
+        while (true) {
+            target = &this->cells[position & this->mask];
+            const std::size_t sequence = target->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (difference == 0) {
+                if (this->enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = this->enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+        target->value = std::move(value);
+        target->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Removes the oldest element of the queue, if it is not empty
+     * @param value Where to move the element
+     * @return True if an element has been removed, false if the queue is empty
+     */
+    bool
+    try_pop(T &value) {
+        std::size_t position = this->dequeue_position.load(std::memory_order_relaxed);
+        cell *target;
+        while (true) {
+            target = &this->cells[position & this->mask];
+            const std::size_t sequence = target->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+            if (difference == 0) {
+                if (this->dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = this->dequeue_position.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(target->value);
+        target->sequence.store(position + this->mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    /**
+     * Cell of the ring buffer
+     */
+    struct cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    /**
+     * Size of a cache line, used to keep the positions of producers and consumers apart
+     */
+    static const std::size_t cache_line_size = 64;
+
+    std::unique_ptr<cell[]> cells;
+    std::size_t mask;
+    char padding_enqueue[cache_line_size];
+    std::atomic<std::size_t> enqueue_position{0};
+    char padding_dequeue[cache_line_size];
+    std::atomic<std::size_t> dequeue_position{0};
+};
+
+
+#endif //DATA_STRUCTURES_MPMC_QUEUE_HPP
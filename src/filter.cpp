@@ -2,6 +2,7 @@
 #include <cfloat>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sys/stat.h>
 #include <unordered_set>
 
@@ -12,8 +13,12 @@
 #include "pruners/pruner_cutoff.hpp"
 #include "pruners/pruner_epspruning.hpp"
 #include "pruners/pruner_topk.hpp"
+#include "utils/anytime.hpp"
 #include "utils/composition.hpp"
+#include "utils/cost_model.hpp"
 #include "utils/cxxopts.hpp"
+#include "utils/json.hpp"
+#include "utils/trace.hpp"
 #include "utils/utils.hpp"
 
 
@@ -27,10 +32,16 @@ assessment(
     const k_type      param_k = arguments["k"].as<int>();
     const index_type  param_n_cut = arguments["n-cut"].as<int>();
     const score_type  param_epsilon = arguments["epsilon"].as<float>();
+    const double      param_deadline = arguments["deadline"].as<double>();
+    const double      param_latency = arguments["latency"].as<double>();
     std::ofstream * param_ofstream = nullptr;
+    std::ofstream * param_trace_ofstream = nullptr;
 
     typedef PrunerFilterCompositionTest<ScoreFun> composition_type;
     composition_type * composition = nullptr;
+    std::unique_ptr<AnytimeFilter<ScoreFun>> anytime_filter;
+    std::unique_ptr<CostModel<ScoreFun>> cost_model;
+    std::shared_ptr<composition_type> planned_composition;
     const bool use_files = arguments.count("positional");
 
     // check the command line parameters
@@ -55,19 +66,7 @@ assessment(
         if (arguments.count("cpu-affinity")) {
             int cpu_affinity = arguments["cpu-affinity"].as<int>();
             if (cpu_affinity > -1) {
-#ifdef __linux__
-                cpu_set_t mask;
-                int status;
-
-                CPU_ZERO(&mask);
-                CPU_SET(cpu_affinity, &mask);
-                status = sched_setaffinity(0, sizeof(mask), &mask);
-                if (status != 0) {
-                    throw std::runtime_error(std::string("Unable to set the cpu affinity: ") + std::strerror(errno));
-                }
-#else
-                throw std::runtime_error("The cpu affinity can be set only on linux");
-#endif
+                set_cpu_affinity(cpu_affinity);
             }
         }
 
@@ -80,6 +79,17 @@ assessment(
             }
         }
 
+        // param trace
+        if (arguments.count("trace")) {
+            std::string trace_file_path = arguments["trace"].as<std::string>();
+            param_trace_ofstream = new std::ofstream(trace_file_path);
+            if (!param_trace_ofstream->is_open()) {
+                throw std::runtime_error(std::string("Unable to open the trace file ") + trace_file_path);
+            }
+            TraceRecorder::enable();
+            TraceRecorder::set_current_list(0);
+        }
+
         // TEST CONFIGURATION
         std::shared_ptr<ScoreFun> score_fun = std::make_shared<ScoreFun>(param_k);
         std::shared_ptr<FilterSpirin<ScoreFun>> filter = std::shared_ptr<FilterSpirin<ScoreFun>>(new FilterSpirin<ScoreFun>(param_k, score_fun));
@@ -104,6 +114,31 @@ assessment(
             composition = new composition_type("OPT", nullptr, filter, 1);
         }
 
+        // the strategy is chosen for the list by the cost model, if required
+        if (arguments.count("cost-model")) {
+            if (composition->pruner != nullptr || param_deadline > 0) {
+                throw std::runtime_error(std::string("The parameter cost-model chooses the strategy, thus it cannot be used with the other strategies and deadline"));
+            }
+            std::string cost_model_file_path = arguments["cost-model"].as<std::string>();
+            std::ifstream cost_model_stream(cost_model_file_path);
+            if (!cost_model_stream.is_open()) {
+                throw std::runtime_error(std::string("Unable to open the file ") + cost_model_file_path);
+            }
+            cost_model.reset(new CostModel<ScoreFun>(JsonValue::parse(cost_model_stream)));
+        }
+
+        // the anytime filtering refines the solution down to the selected strategy
+        if (param_deadline > 0) {
+            if (composition->pruner != nullptr && !arguments["test-epsfiltering"].as<bool>()) {
+                throw std::runtime_error(std::string("The parameter deadline is available only for the optimal and the epsilon filtering strategies"));
+            }
+            try {
+                anytime_filter.reset(new AnytimeFilter<ScoreFun>(score_fun, filter, (composition->pruner != nullptr) ? param_epsilon : 0));
+            } catch (std::invalid_argument & e) {
+                throw std::runtime_error(e.what());
+            }
+        }
+
         // check the input file
         if (use_files) {
             struct stat s;
@@ -127,6 +162,7 @@ assessment(
     }
 
     // read the input
+    TraceSpan read_span("read");
     std::ifstream istream_file(nullptr);
     if (use_files) {
         istream_file = std::ifstream(param_file_path);
@@ -140,12 +176,14 @@ assessment(
     if (use_files) {
         istream_file.close();
     }
+    read_span.end();
 
     const relevance_type *rel_list = resultsList.relevances.data();
     const std::size_t rel_list_len = resultsList.size();
     const std::size_t n = (param_n_cut > 0) ? std::min(rel_list_len, static_cast<std::size_t>(param_n_cut)) : rel_list_len;
 
     // compute min and max elements of the list (this is something that could be done during the sort by attribute)
+    TraceSpan minmax_span("minmax", n);
     minmax_type minmax_element;
     minmax_element.min = minmax_element.max = rel_list[0];
     for (index_type j = 1; j < n; ++j) {
@@ -156,16 +194,41 @@ assessment(
         }
     }
 
-    TestOutcome outcome = composition->operator()(rel_list, n, minmax_element);
+    minmax_span.end();
+
+    TestOutcome outcome;
+    if (cost_model != nullptr) {
+        try {
+            const StrategyPlan plan = cost_model->plan(n, minmax_element, param_k, param_epsilon, param_latency);
+            std::cerr << plan << std::endl;
+            const std::shared_ptr<Filter<ScoreFun>> filter = composition->filter;
+            planned_composition = make_strategy_test<ScoreFun>(plan.strategy, filter->score_fun, filter, plan.epsilon, 1);
+            delete(composition);
+            composition = planned_composition.get();
+        } catch (std::runtime_error & e) {
+            std::cerr << e.what() << "." << std::endl;
+            return -1;
+        }
+    }
+    if (anytime_filter != nullptr) {
+        AnytimeSolution anytime_outcome = anytime_filter->operator()(rel_list, n, param_deadline);
+        std::cerr << anytime_outcome << std::endl;
+        outcome.score = anytime_outcome.solution.score;
+        outcome.indices = std::move(anytime_outcome.solution.indices);
+    } else {
+        outcome = composition->operator()(rel_list, n, minmax_element);
+    }
 
 
     // WRITE the output
     // select the output stream
     std::ostream & ostream = (param_ofstream != nullptr) ? *param_ofstream : std::cout;
 
+    TraceSpan output_span("output", outcome.indices.size());
     for (std::size_t i=0, i_end=outcome.indices.size(); i < i_end; ++i) {
         ostream << resultsList.ids[outcome.indices[i]] << std::endl;
     }
+    output_span.end();
 
     // close the file output stream
     if (param_ofstream != nullptr) {
@@ -173,6 +236,13 @@ assessment(
         delete(param_ofstream);
     }
 
+    // write the trace
+    if (param_trace_ofstream != nullptr) {
+        TraceRecorder::write(*param_trace_ofstream);
+        param_trace_ofstream->close();
+        delete(param_trace_ofstream);
+    }
+
     return 0;
 }
 
@@ -189,6 +259,10 @@ int main(int argc, char *argv[]) {
             ("e, epsilon", "Target approximation factor", cxxopts::value<float>()->default_value("0.01"))
             ("a, cpu-affinity", "Set the cpu affinity of the process", cxxopts::value<int>()->default_value("-1"))
             ("o, output", "Write result to FILE instead of standard output", cxxopts::value<std::string>())
+            ("trace", "Write a Chrome trace-event json with the timeline of the stages to FILE", cxxopts::value<std::string>())
+            ("cost-model", "Choose the fastest strategy guaranteeing the epsilon and predicted to meet the latency by means of the cost model in FILE, written by plan", cxxopts::value<std::string>())
+            ("latency", "Latency target of the strategy chosen by the cost model, in ms, if greater than zero", cxxopts::value<double>()->default_value("0"))
+            ("deadline", "Filter within this number of ms, refining the solution of topk-opt down to the selected strategy, if greater than zero", cxxopts::value<double>()->default_value("0"))
             ("test-cutoff", "Test the cutoff-opt strategy", cxxopts::value<bool>()->default_value("false"))
             ("test-topk", "Test the topk-opt strategy", cxxopts::value<bool>()->default_value("false"))
             ("test-epsfiltering", "Test the epsilon filtering strategy", cxxopts::value<bool>()->default_value("false"));
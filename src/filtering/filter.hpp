@@ -4,6 +4,7 @@
 #include <memory>
 #include <vector>
 #include "types.hpp"
+#include "workspace.hpp"
 
 
 /**
@@ -55,6 +56,8 @@ public:
 
 /**
  * Abstract class implementing a generic filter@k.
+ * The filters keep no state between the calls of operator(), thus the same filter can be used by many threads at the
+ * same time, provided that each thread passes its own workspace.
  * @tparam ScoreFun Score function type
  */
 template <typename ScoreFun>
@@ -85,6 +88,20 @@ public:
     virtual FilterSolution
     operator()(const relevance_type * rel_list, const index_type n) const = 0;
 
+    /**
+     * Filters the given list of relevances reusing the buffers of the given workspace.
+     * The default implementation ignores the workspace.
+     * @param rel_list List containing the relevance scores, ordered according to some attribute
+     * @param n Number of elements of rel_list
+     * @param workspace The workspace of the calling thread
+     * @return The filtering solution built on top of the given list of relevances
+     */
+    virtual FilterSolution
+    operator()(const relevance_type * rel_list, const index_type n, Workspace &workspace) const {
+        (void)(workspace); // to suppress the unused parameter warning
+        return this->operator()(rel_list, n);
+    }
+
 public:
     /**
      * Maximum number of elements to keep
@@ -114,6 +131,8 @@ public:
             Filter<ScoreFun>(k, score_fun) {
     }
 
+    using Filter<ScoreFun>::operator();
+
     /**
      * Filters the given list of relevances and returns a filtering solution representing the outcome of the filtering@k.
      * @param rel_list List containing the relevance scores, ordered according to some attribute
@@ -0,0 +1,192 @@
+#ifndef FILTERING_FILTERING_STATS_HPP
+#define FILTERING_FILTERING_STATS_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+
+/**
+ * Internal statistics of the pruners and filters, collected by the calling thread only when the macro
+ * FILTERING_STATS is defined (cmake option FILTERING_STATS). Otherwise the hooks compile to nothing.
+ */
+typedef struct filtering_stats {
+    /**
+     * Identifiers of the counters
+     */
+    enum Counter {
+        EPSPRUNING_INTERVALS,
+        EPSPRUNING_THRESHOLD_ADVANCES,
+        EPSPRUNING_HEAP_REPLACEMENTS,
+        TOPK_TIE_POPS,
+        SPIRIN_CELLS_COMPUTED,
+        SPIRIN_TRACEBACK_LENGTH,
+        NUM_COUNTERS
+    };
+
+    /**
+     * Values of the counters
+     */
+    std::uint64_t counters[NUM_COUNTERS] = {0, 0, 0, 0, 0, 0};
+    /**
+     * Number of candidates kept by the epsilon pruning while the threshold is in each interval
+     */
+    std::vector<std::uint64_t> epspruning_candidates_per_interval;
+
+    /**
+     * Name of the given counter
+     * @param counter The identifier of the counter
+     * @return The name of the counter
+     */
+    static const char *
+    name(std::size_t counter) {
+        static const char *names[NUM_COUNTERS] = {
+                "epspruning_intervals",
+                "epspruning_threshold_advances",
+                "epspruning_heap_replacements",
+                "topk_tie_pops",
+                "spirin_cells_computed",
+                "spirin_traceback_length"
+        };
+        return names[counter];
+    }
+
+    /**
+     * Resets all statistics
+     */
+    void
+    clear() {
+        for (std::size_t i = 0; i < NUM_COUNTERS; ++i) {
+            this->counters[i] = 0;
+        }
+        this->epspruning_candidates_per_interval.clear();
+    }
+
+    /**
+     * Adds other statistics to these ones
+     * @param other The statistics to add
+     */
+    void
+    merge(const struct filtering_stats &other) {
+        for (std::size_t i = 0; i < NUM_COUNTERS; ++i) {
+            this->counters[i] += other.counters[i];
+        }
+        if (other.epspruning_candidates_per_interval.size() > this->epspruning_candidates_per_interval.size()) {
+            this->epspruning_candidates_per_interval.resize(other.epspruning_candidates_per_interval.size(), 0);
+        }
+        for (std::size_t i = 0, i_end = other.epspruning_candidates_per_interval.size(); i < i_end; ++i) {
+            this->epspruning_candidates_per_interval[i] += other.epspruning_candidates_per_interval[i];
+        }
+    }
+
+    /**
+     * Gets the statistics of the calling thread
+     * @return The statistics of the calling thread
+     */
+    static struct filtering_stats &
+    thread_instance() {
+        static thread_local struct filtering_stats stats;
+        return stats;
+    }
+} FilteringStats;
+
+
+#ifdef FILTERING_STATS
+/**
+ * Adds the given value to a counter of the statistics of the calling thread
+ */
+#define FILTERING_STATS_ADD(counter, value) (FilteringStats::thread_instance().counters[FilteringStats::counter] += (value))
+/**
+ * Counts a candidate kept by the epsilon pruning while the threshold is in the given interval
+ */
+#define FILTERING_STATS_EPSPRUNING_CANDIDATE(interval_id) do { \
+        std::vector<std::uint64_t> &candidates = FilteringStats::thread_instance().epspruning_candidates_per_interval; \
+        if ((interval_id) >= candidates.size()) { \
+            candidates.resize((interval_id) + 1, 0); \
+        } \
+        candidates[(interval_id)] += 1; \
+    } while (false)
+#else
+#define FILTERING_STATS_ADD(counter, value) ((void)0)
+#define FILTERING_STATS_EPSPRUNING_CANDIDATE(interval_id) ((void)0)
+#endif
+
+
+/**
+ * Sums of the internal statistics collected on many lists.
+ */
+typedef struct filtering_stats_sums {
+    /**
+     * Number of statistics summed
+     */
+    std::size_t count = 0;
+    /**
+     * Sums of the statistics
+     */
+    FilteringStats sums;
+
+    /**
+     * Adds the given statistics
+     * @param stats The statistics to add
+     */
+    void
+    add(const FilteringStats &stats) {
+        this->count += 1;
+        this->sums.merge(stats);
+    }
+
+    /**
+     * Merges other sums into these ones
+     * @param other The sums to merge
+     */
+    void
+    merge(const struct filtering_stats_sums &other) {
+        this->count += other.count;
+        this->sums.merge(other.sums);
+    }
+
+    /**
+     * Checks whether no statistic has been collected
+     */
+    bool
+    empty() const {
+        if (this->count == 0) {
+            return true;
+        }
+        for (std::size_t i = 0; i < FilteringStats::NUM_COUNTERS; ++i) {
+            if (this->sums.counters[i] > 0) {
+                return false;
+            }
+        }
+        return this->sums.epspruning_candidates_per_interval.empty();
+    }
+
+    /**
+     * Writes on the output stream a json object with the average value of each non-zero statistic
+     * @param os the output stream where to write
+     * @param sums the sums to write
+     * @return the output stream
+     */
+    friend std::ostream & operator<<(std::ostream &os, const struct filtering_stats_sums &sums) {
+        os << "{";
+        bool first = true;
+        for (std::size_t i = 0; i < FilteringStats::NUM_COUNTERS; ++i) {
+            if (sums.sums.counters[i] > 0) {
+                os << (first ? "" : ", ") << "\"avg_" << FilteringStats::name(i) << "\": " << static_cast<double>(sums.sums.counters[i]) / sums.count;
+                first = false;
+            }
+        }
+        if (!sums.sums.epspruning_candidates_per_interval.empty()) {
+            os << (first ? "" : ", ") << "\"avg_epspruning_candidates_per_interval\": [";
+            for (std::size_t i = 0, i_end = sums.sums.epspruning_candidates_per_interval.size(); i < i_end; ++i) {
+                os << ((i > 0) ? ", " : "") << static_cast<double>(sums.sums.epspruning_candidates_per_interval[i]) / sums.count;
+            }
+            os << "]";
+        }
+        os << "}";
+        return os;
+    }
+} FilteringStatsSums;
+
+
+#endif //FILTERING_FILTERING_STATS_HPP
@@ -50,6 +50,8 @@ public:
 
 /**
  * Abstract class implementing a generic pruner.
+ * The pruners keep no state between the calls of operator(), thus the same pruner can be used by many threads at the
+ * same time.
  * @tparam ScoreFun Score function type
  */
 template <typename ScoreFun>
@@ -18,6 +18,11 @@ struct dcg_metric {
         delete[](discount_sums);
     }
 
+    static const char *
+    name() {
+        return "dcg";
+    }
+
     inline score_type
     operator()(relevance_type relevance, index_type position) const {
         return this->gain_factor(relevance) * this->discount_factor(position);
@@ -86,6 +91,11 @@ struct dcglz_metric {
         delete[](discount_sums);
     }
 
+    static const char *
+    name() {
+        return "dcglz";
+    }
+
     inline score_type
     operator()(relevance_type relevance, index_type position) const {
         return this->gain_factor(relevance) * this->discount_factor(position);
@@ -0,0 +1,29 @@
+#ifndef FILTERING_WORKSPACE_HPP
+#define FILTERING_WORKSPACE_HPP
+
+#include <vector>
+#include "types.hpp"
+
+
+/**
+ * Buffers reused by the pruners and filters across the lists filtered by the same thread, so that filtering many
+ * lists does not allocate and free the dynamic programming table of each list.
+ * A workspace must be used by one thread at a time, thus each thread owns its own workspace.
+ */
+typedef struct {
+    /**
+     * Relevances of the elements not pruned by the first stage
+     */
+    std::vector<relevance_type> relevances;
+    /**
+     * Table of the dynamic programming algorithm of the filter
+     */
+    std::vector<score_type> table;
+    /**
+     * Gains and discounts of the elements, used by the filter
+     */
+    std::vector<score_type> factors;
+} Workspace;
+
+
+#endif //FILTERING_WORKSPACE_HPP
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <cassert>
 #include "../filtering/filter.hpp"
+#include "../filtering/filtering_stats.hpp"
 
 
 /**
@@ -33,25 +34,65 @@ public:
      */
     FilterSolution
     operator()(const relevance_type * rel_list, const index_type n) const {
-        return this->filter_impl(rel_list, n);
+        if (n == 0 || this->k == 0) {
+            return FilterSolution();
+        }
+        const k_type k = (this->k > n) ? n : this->k;
+
+        // matrix used by the dynamic algorithm
+        // I use a malloc here to avoid the cost of initializing all elements
+        score_type *M = new score_type[table_size(n, k)];
+        score_type *buffer = new score_type[n + k];
+        FilterSolution solution = this->filter_impl(rel_list, n, M, buffer);
+        delete[](buffer);
+        delete[](M);
+
+        return solution;
+    }
+
+    /**
+     * Filters the given list of relevances reusing the matrix and the buffers of the given workspace, which grow to the
+     * size of the greatest list filtered and are never shrunk.
+     * @param rel_list List containing the relevance scores, ordered according to some attribute
+     * @param n Number of elements of rel_list
+     * @param workspace The workspace of the calling thread
+     * @return The filtering solution built on top of the given list of relevances
+     */
+    FilterSolution
+    operator()(const relevance_type * rel_list, const index_type n, Workspace &workspace) const {
+        if (n == 0 || this->k == 0) {
+            return FilterSolution();
+        }
+        const k_type k = (this->k > n) ? n : this->k;
+
+        if (workspace.table.size() < table_size(n, k)) {
+            workspace.table.resize(table_size(n, k));
+        }
+        if (workspace.factors.size() < static_cast<std::size_t>(n) + k) {
+            workspace.factors.resize(static_cast<std::size_t>(n) + k);
+        }
+        return this->filter_impl(rel_list, n, workspace.table.data(), workspace.factors.data());
     }
 
 private:
-    template <bool debug_print=false>
+    /**
+     * Number of cells of the matrix used by the dynamic algorithm
+     * @param n Number of elements of the list
+     * @param k Maximum number of elements to keep, not greater than n
+     * @return The number of cells
+     */
+    static std::size_t
+    table_size(const index_type n, const k_type k) {
+        return ((k - 1) * (k - 1 + 1) / 2) + static_cast<std::size_t>(k) * (n - (k - 1));
+    }
+
     inline FilterSolution
-    filter_impl(const relevance_type * rel_list, const index_type n) const {
+    filter_impl(const relevance_type * rel_list, const index_type n, score_type *M, score_type *buffer) const {
         FilterSolution solution;
-        if (n == 0 || this->k == 0) {
-            return solution;
-        }
         // check the value of k
         const ScoreFun & score_fun = *(this->score_fun.get());
         const k_type k = (this->k > n) ? n : this->k;
 
-        // matrix used by the dynamic algorithm
-        // I use a malloc here to avoid the cost of initializing all elements
-        score_type *M = new score_type[((k - 1) * (k - 1 + 1) / 2) + k * (n - (k - 1))];
-        score_type *buffer = new score_type[n + k];
         score_type *gains = buffer, *discounts = buffer + n;
         for (std::size_t i = 0; i < k; ++i) {
             gains[i] = score_fun.gain_factor(rel_list[i]);
@@ -67,9 +108,6 @@ private:
 
         // filling the table
         M[0] = gains[0] * discounts[0];
-        if (debug_print) {
-            std::cout << 0 << "\t" << M[0] << std::endl;
-        }
         for (std::size_t row = 1; row < k; ++row) {  // the triangular block ends in position k-1
             curr_row_shift = prev_row_shift + row;
 
@@ -80,14 +118,6 @@ private:
             }
             M[curr_row_shift + row] = M[prev_row_shift + row - 1] + gains[row] * discounts[row];
 
-            if (debug_print) {
-                std::cout << row << "\t" << M[curr_row_shift + 0];
-                for (std::size_t col=1; col <= row; ++col) {
-                    std::cout << "\t" << M[curr_row_shift + col];
-                }
-                std::cout << std::endl;
-            }
-
             prev_row_shift = curr_row_shift;
         }
         for (std::size_t row = k; row < n; ++row) {  // after position k-1 the block is rectangular
@@ -99,16 +129,9 @@ private:
                                                    M[prev_row_shift + col - 1] + gains[row] * discounts[col]);
             }
 
-            if (debug_print) {
-                std::cout << row << "\t" << M[curr_row_shift + 0];
-                for (std::size_t col=1; col < k; ++col) {
-                    std::cout << "\t" << M[curr_row_shift + col];
-                }
-                std::cout << std::endl;
-            }
-
             prev_row_shift = curr_row_shift;
         }
+        FILTERING_STATS_ADD(SPIRIN_CELLS_COMPUTED, table_size(n, k));
 
         solution.indices.reserve(n);
         // identifying the best score within the last row
@@ -123,6 +146,7 @@ private:
 
         // going back to identify the elements participating to the solution
         for (std::size_t row = n - 1; row > 0; --row) {
+            FILTERING_STATS_ADD(SPIRIN_TRACEBACK_LENGTH, 1);
             assert(curr_row_shift >= row);
             prev_row_shift = curr_row_shift - ((row < k) ? row : k);
             if (M[curr_row_shift + best_column] > M[prev_row_shift + best_column]) {
@@ -140,8 +164,6 @@ private:
 
         // reverse the vector containing the indices, because I filled it from right to left
         std::reverse(solution.indices.begin(), solution.indices.end());
-        delete[](buffer);
-        delete[](M);
 
         return solution;
     }
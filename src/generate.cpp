@@ -0,0 +1,135 @@
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sys/stat.h>
+#include <vector>
+
+#include "utils/cxxopts.hpp"
+#include "utils/synthetic.hpp"
+#include "utils/utils.hpp"
+
+
+/**
+ * Reads the configuration of the synthetic lists from the command line arguments
+ * @param arguments The command line arguments
+ * @param length The length of the lists
+ * @return The configuration, already checked
+ */
+SyntheticListConfig
+read_synthetic_list_config(const cxxopts::ParseResult &arguments, index_type length) {
+    SyntheticListConfig config;
+    config.distribution = arguments["distribution"].as<std::string>();
+    config.length = length;
+    config.max_relevance = arguments["max-relevance"].as<double>();
+    config.zipf_exponent = arguments["zipf-exponent"].as<double>();
+    config.grades = arguments["grades"].as<int>();
+    config.sortedness = arguments["sortedness"].as<double>();
+    check_synthetic_list_config(config);
+    return config;
+}
+
+
+int main(int argc, char *argv[]) {
+    // command line options
+    cxxopts::Options options(argv[0], "Generates synthetic lists of results with the given relevance distribution");
+    options
+            .add_options()
+            ("h, help", "Print this help message")
+            ("d, distribution", "Distribution of the relevances. Available options are: uniform, zipf, graded, adversarial", cxxopts::value<std::string>()->default_value("uniform"))
+            ("n, length", "Number of elements of each list", cxxopts::value<index_type>()->default_value("1000"))
+            ("l, num-lists", "Number of lists to generate", cxxopts::value<std::size_t>()->default_value("1"))
+            ("max-relevance", "Maximum relevance of the elements", cxxopts::value<double>()->default_value("4"))
+            ("zipf-exponent", "Exponent of the zipf distribution", cxxopts::value<double>()->default_value("1"))
+            ("grades", "Number of relevance labels of the graded distribution", cxxopts::value<int>()->default_value("5"))
+            ("sortedness", "Fraction of each list, from its beginning, sorted by decreasing relevance", cxxopts::value<double>()->default_value("0"))
+            ("seed", "Seed of the random generator", cxxopts::value<unsigned>()->default_value("0"))
+            ("o, output", "Write the lists to FILE, in the input stream format of assessment, instead of standard output", cxxopts::value<std::string>())
+            ("output-dir", "Write each list to a tsv file in the directory DIR instead", cxxopts::value<std::string>());
+
+    // command line parsing
+    cxxopts::ParseResult arguments = options.parse(argc, argv);
+
+    // help
+    if (arguments.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    const std::size_t param_num_lists = arguments["num-lists"].as<std::size_t>();
+    const unsigned param_seed = arguments["seed"].as<unsigned>();
+    SyntheticListConfig param_config;
+    std::string param_output_dir;
+    std::ofstream * param_ofstream = nullptr;
+
+    // check the command line parameters
+    try {
+        param_config = read_synthetic_list_config(arguments, arguments["length"].as<index_type>());
+        if (param_num_lists == 0) {
+            throw std::runtime_error("The parameter num-lists must be a number strictly greater than 0");
+        }
+        if (arguments.count("output") && arguments.count("output-dir")) {
+            throw std::runtime_error("The parameters output and output-dir cannot be used together");
+        }
+
+        // param output
+        if (arguments.count("output")) {
+            std::string output_file_path = arguments["output"].as<std::string>();
+            param_ofstream = new std::ofstream(output_file_path);
+            if (!param_ofstream->is_open()) {
+                throw std::runtime_error(std::string("Unable to open the output file ") + output_file_path);
+            }
+        }
+        if (arguments.count("output-dir")) {
+            param_output_dir = arguments["output-dir"].as<std::string>();
+            struct stat s;
+            if (stat(param_output_dir.c_str(), &s) != 0) {
+                if (mkdir(param_output_dir.c_str(), 0755) != 0) {
+                    throw std::runtime_error(std::string("Unable to create the output directory ") + param_output_dir + ": " + std::strerror(errno));
+                }
+            } else if (!(s.st_mode & S_IFDIR)) {
+                throw std::runtime_error(std::string("The output path is not a directory: ") + param_output_dir);
+            }
+        }
+    } catch (std::runtime_error & e) {
+        std::cerr << e.what() << "." << std::endl;
+        return -1;
+    }
+
+    // select the output stream
+    std::ostream & ostream = (param_ofstream != nullptr) ? *param_ofstream : std::cout;
+    if (param_output_dir.empty()) {
+        ostream << param_num_lists << "\n";
+    }
+
+    // GENERATE the lists, each one with its own seed so that a list does not depend on the others
+    for (std::size_t i = 0; i < param_num_lists; ++i) {
+        std::seed_seq seed_sequence{param_seed, static_cast<unsigned>(i)};
+        std::mt19937 random_engine(seed_sequence);
+        std::vector<relevance_type> relevances = generate_synthetic_list(param_config, random_engine);
+
+        if (param_output_dir.empty()) {
+            ostream << relevances.size() << "\n";
+            write_synthetic_list_tsv(ostream, relevances);
+        } else {
+            std::ostringstream file_path;
+            file_path << param_output_dir << "/list-" << i << ".tsv";
+            std::ofstream file_stream(file_path.str());
+            write_synthetic_list_tsv(file_stream, relevances);
+            if (!file_stream) {
+                std::cerr << "Unable to write the file " << file_path.str() << "." << std::endl;
+                return -1;
+            }
+        }
+    }
+    ostream.flush();
+
+    // close the file output stream
+    if (param_ofstream != nullptr) {
+        param_ofstream->close();
+        delete(param_ofstream);
+    }
+
+    return 0;
+}
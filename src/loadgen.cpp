@@ -0,0 +1,536 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+#include "data_structures/latency_histogram.hpp"
+#include "filtering/search_quality_metric.hpp"
+#include "utils/cxxopts.hpp"
+#include "utils/pipeline.hpp"
+#include "utils/strategies.hpp"
+#include "utils/utils.hpp"
+
+
+/**
+ * A list of the dataset ready to be filtered.
+ */
+typedef struct {
+    /**
+     * The list
+     */
+    std::unique_ptr<ResultsList> list;
+    /**
+     * Number of elements to filter, after the cut
+     */
+    index_type n;
+} LoadRequest;
+
+
+/**
+ * Outcome of a load run with a given concurrency.
+ */
+typedef struct {
+    /**
+     * Number of requests completed after the warmup
+     */
+    std::uint64_t num_requests = 0;
+    /**
+     * Time elapsed from the end of the warmup to the completion of the last request, in seconds
+     */
+    double elapsed = 0;
+    /**
+     * Sum of the latencies, in milliseconds
+     */
+    double sum_latency = 0;
+    /**
+     * Distribution of the latencies, in nanoseconds
+     */
+    LatencyHistogram latency;
+} LoadOutcome;
+
+
+/**
+ * Replays the requests against the filtering pipeline with the given number of concurrent workers.
+ * In the closed-loop mode (qps equal to zero) each worker sends a new request as soon as the previous one completes,
+ * and the latency is the service time. In the open-loop mode the requests arrive as a Poisson process with the given
+ * rate, independently of their completion, and the latency is measured from the arrival, so it includes the time
+ * spent waiting for a worker.
+ * @param test The filtering pipeline, shared by the workers
+ * @param requests The requests, replayed in a round-robin order
+ * @param num_workers The number of concurrent workers
+ * @param cpu_list The cpus where to pin the workers, or an empty list
+ * @param qps The target number of requests per second, or zero for the closed-loop mode
+ * @param warmup The duration of the warmup, whose requests are not recorded, in seconds
+ * @param duration The duration of the measurement, in seconds
+ * @param seed The seed of the arrivals
+ * @return The outcome of the run
+ */
+template <typename ScoreFun>
+LoadOutcome
+run_load(PrunerFilterCompositionTest<ScoreFun> &test, const std::vector<LoadRequest> &requests, std::size_t num_workers,
+         const std::vector<int> &cpu_list, double qps, double warmup, double duration, unsigned seed) {
+    const std::uint64_t warmup_ns = static_cast<std::uint64_t>(warmup * 1e9);
+    const std::uint64_t end_ns = warmup_ns + static_cast<std::uint64_t>(duration * 1e9);
+
+    // arrival times of the open-loop mode, relative to the start
+    std::vector<std::uint64_t> arrivals;
+    if (qps > 0) {
+        std::mt19937 random_engine(seed);
+        std::exponential_distribution<double> interarrival(qps);
+        for (double t = interarrival(random_engine); t * 1e9 < end_ns; t += interarrival(random_engine)) {
+            arrivals.push_back(static_cast<std::uint64_t>(t * 1e9));
+        }
+    }
+
+    std::atomic<std::size_t> next_request(0);
+    std::vector<LoadOutcome> outcomes(num_workers);
+    std::vector<std::uint64_t> last_completion(num_workers, 0);
+    std::vector<std::thread> workers;
+    const std::uint64_t start = get_time_nanoseconds();
+
+    auto worker_loop = [&](std::size_t worker_id) {
+        if (!cpu_list.empty()) {
+            set_cpu_affinity(cpu_list[worker_id]);
+        }
+        LoadOutcome &outcome = outcomes[worker_id];
+        while (true) {
+            const std::size_t r = next_request++;
+            std::uint64_t arrival;
+            if (qps > 0) {
+                if (r >= arrivals.size()) {
+                    break;
+                }
+                // wait for the arrival of the request
+                arrival = arrivals[r];
+                std::uint64_t now = get_time_nanoseconds() - start;
+                if (now < arrival) {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(arrival - now));
+                }
+            } else {
+                arrival = get_time_nanoseconds() - start;
+                if (arrival >= end_ns) {
+                    break;
+                }
+            }
+
+            // filter the list, from the computation of its min and max elements to the selection of the elements
+            const LoadRequest &request = requests[r % requests.size()];
+            const relevance_type *rel_list = request.list->relevances.data();
+            minmax_type minmax_element;
+            minmax_element.min = minmax_element.max = rel_list[0];
+            for (index_type j = 1; j < request.n; ++j) {
+                if (rel_list[j] < minmax_element.min) {
+                    minmax_element.min = rel_list[j];
+                } else if (rel_list[j] > minmax_element.max) {
+                    minmax_element.max = rel_list[j];
+                }
+            }
+            doNotOptimizeAway(test.run_once(rel_list, request.n, minmax_element).score);
+            const std::uint64_t completion = get_time_nanoseconds() - start;
+
+            if (arrival >= warmup_ns) {
+                const double latency = (completion - arrival) / 1e6;
+                ++outcome.num_requests;
+                outcome.sum_latency += latency;
+                outcome.latency.record(completion - arrival);
+                last_completion[worker_id] = std::max(last_completion[worker_id], completion);
+            }
+        }
+    };
+    for (std::size_t w = 0; w < num_workers; ++w) {
+        workers.emplace_back(worker_loop, w);
+    }
+    for (std::thread &worker: workers) {
+        worker.join();
+    }
+
+    // merge the outcomes of the workers
+    LoadOutcome outcome;
+    std::uint64_t end = warmup_ns;
+    for (std::size_t w = 0; w < num_workers; ++w) {
+        outcome.num_requests += outcomes[w].num_requests;
+        outcome.sum_latency += outcomes[w].sum_latency;
+        outcome.latency.merge(outcomes[w].latency);
+        end = std::max(end, last_completion[w]);
+    }
+    outcome.elapsed = (end - warmup_ns) / 1e9;
+    return outcome;
+}
+
+
+/**
+ * Replays the requests against the filtering pipeline with its pruning and filtering stages on separate threads.
+ * A producer thread submits the requests, keeping a given number of them outstanding (closed loop, qps equal to zero)
+ * or as a Poisson process with the given rate (open loop), and the latency is measured from the submission or the
+ * arrival, respectively, to the completion of the filtering stage. Bounding the outstanding requests of the closed loop
+ * keeps the queues of the pipeline short, so that its latency is the service time and not the wait in the queues.
+ * @param test The filtering pipeline
+ * @param requests The requests, replayed in a round-robin order
+ * @param num_pruner_threads The number of threads of the pruning stage
+ * @param num_filter_threads The number of threads of the filtering stage
+ * @param concurrency The number of outstanding requests of the closed-loop mode
+ * @param qps The target number of requests per second, or zero for the closed-loop mode
+ * @param warmup The duration of the warmup, whose requests are not recorded, in seconds
+ * @param duration The duration of the measurement, in seconds
+ * @param seed The seed of the arrivals
+ * @param pruning_statistics Where to store the statistics of the pruning stage
+ * @param filtering_statistics Where to store the statistics of the filtering stage
+ * @return The outcome of the run
+ */
+template <typename ScoreFun>
+LoadOutcome
+run_pipeline(const std::shared_ptr<PrunerFilterCompositionTest<ScoreFun>> &test, const std::vector<LoadRequest> &requests,
+             std::size_t num_pruner_threads, std::size_t num_filter_threads, std::size_t concurrency, double qps,
+             double warmup, double duration, unsigned seed, PipelineStageStatistics &pruning_statistics,
+             PipelineStageStatistics &filtering_statistics) {
+    const std::uint64_t warmup_ns = static_cast<std::uint64_t>(warmup * 1e9);
+    const std::uint64_t end_ns = warmup_ns + static_cast<std::uint64_t>(duration * 1e9);
+    std::mt19937 random_engine(seed);
+    std::exponential_distribution<double> interarrival((qps > 0) ? qps : 1.0);
+
+    // the outcomes of the filter threads are merged under a lock, which is taken once per request
+    LoadOutcome outcome;
+    std::uint64_t last_completion = 0;
+    std::mutex outcome_mutex;
+    std::vector<std::uint64_t> arrivals;
+
+    // the requests submitted and not completed yet, bounded by the concurrency in the closed-loop mode
+    std::size_t num_outstanding = 0;
+    std::mutex outstanding_mutex;
+    std::condition_variable outstanding_condition;
+    const std::uint64_t start = get_time_nanoseconds();
+
+    auto sink = [&](PipelineResult &result) {
+        doNotOptimizeAway(result.solution.score);
+        const std::uint64_t completion = get_time_nanoseconds() - start;
+        const std::uint64_t arrival = (qps > 0) ? arrivals[result.list_id] : result.submit_time - start;
+        if (arrival >= warmup_ns) {
+            std::lock_guard<std::mutex> lock(outcome_mutex);
+            ++outcome.num_requests;
+            outcome.sum_latency += (completion - arrival) / 1e6;
+            outcome.latency.record(completion - arrival);
+            last_completion = std::max(last_completion, completion);
+        }
+        if (qps == 0) {
+            std::lock_guard<std::mutex> lock(outstanding_mutex);
+            --num_outstanding;
+            outstanding_condition.notify_one();
+        }
+    };
+
+    // arrival times of the open-loop mode, relative to the start, drawn before the pipeline reads them
+    if (qps > 0) {
+        for (double t = interarrival(random_engine); t * 1e9 < end_ns; t += interarrival(random_engine)) {
+            arrivals.push_back(static_cast<std::uint64_t>(t * 1e9));
+        }
+    }
+
+    PipelinedFilter<ScoreFun> pipeline(test, num_pruner_threads, num_filter_threads, sink);
+    for (std::size_t r = 0; ; ++r) {
+        if (qps > 0) {
+            if (r >= arrivals.size()) {
+                break;
+            }
+            // wait for the arrival of the request
+            std::uint64_t now = get_time_nanoseconds() - start;
+            if (now < arrivals[r]) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(arrivals[r] - now));
+            }
+        } else {
+            std::unique_lock<std::mutex> lock(outstanding_mutex);
+            outstanding_condition.wait(lock, [&]() { return num_outstanding < concurrency; });
+            if (get_time_nanoseconds() - start >= end_ns) {
+                break;
+            }
+            ++num_outstanding;
+        }
+        const LoadRequest &request = requests[r % requests.size()];
+        BatchList list;
+        list.relevances = request.list->relevances.data();
+        list.n = request.n;
+        pipeline.submit(r, list);
+    }
+    pipeline.close();
+    pruning_statistics = pipeline.pruning_statistics();
+    filtering_statistics = pipeline.filtering_statistics();
+
+    outcome.elapsed = (std::max(last_completion, warmup_ns) - warmup_ns) / 1e9;
+    return outcome;
+}
+
+
+template <typename ScoreFun>
+int
+loadgen(
+        const cxxopts::ParseResult &arguments
+) {
+    // parameters
+    std::vector<std::string> param_file_path_list;
+    std::vector<std::size_t> param_concurrency_list;
+    std::vector<int> param_cpu_list;
+    std::vector<std::size_t> param_pipeline_threads;
+    const index_type param_n_cut = arguments["n-cut"].as<index_type>();
+    const k_type     param_k = arguments["k"].as<k_type>();
+    const score_type param_epsilon = arguments["epsilon"].as<score_type>();
+    const std::string param_strategy = arguments["strategy"].as<std::string>();
+    const double     param_qps = arguments["qps"].as<double>();
+    const double     param_warmup = arguments["warmup"].as<double>();
+    const double     param_duration = arguments["duration"].as<double>();
+    const unsigned   param_seed = arguments["seed"].as<unsigned>();
+    std::ofstream * param_ofstream = nullptr;
+    std::shared_ptr<PrunerFilterCompositionTest<ScoreFun>> test;
+
+    // check the command line parameters
+    try {
+        if (arguments.count("positional")) {
+            param_file_path_list = arguments["positional"].as<std::vector<std::string>>();
+            for (const std::string &file_path: param_file_path_list) {
+                struct stat s;
+                if (stat(file_path.c_str(), &s) != 0) {
+                    throw std::runtime_error(std::string("Unable to access the stats of the file: ") + file_path);
+                } else if (!(s.st_mode & S_IFREG)) {
+                    throw std::runtime_error(std::string("Unable to recognize the file: ") + file_path);
+                }
+            }
+        }
+        if (param_k <= 0) {
+            throw std::runtime_error("The parameter k must be strictly greater than 0");
+        }
+        if (param_epsilon <= 0 || param_epsilon >= 1) {
+            throw std::runtime_error("The parameter epsilon must be between zero and one");
+        }
+        if (param_qps < 0) {
+            throw std::runtime_error("The parameter qps must be a number greater or equal than 0");
+        }
+        if (param_warmup < 0 || param_duration <= 0) {
+            throw std::runtime_error("The parameter warmup must be non-negative and the parameter duration must be positive");
+        }
+
+        // param concurrency, from one worker to a worker per core when scaling
+        const std::size_t num_cores = std::max(1u, std::thread::hardware_concurrency());
+        if (arguments["scale"].as<bool>()) {
+            for (std::size_t c = 1; c < num_cores; c *= 2) {
+                param_concurrency_list.push_back(c);
+            }
+            param_concurrency_list.push_back(num_cores);
+        } else {
+            param_concurrency_list = read_parameter_list<std::size_t>(arguments["concurrency-list"].as<std::string>());
+        }
+        if (param_concurrency_list.empty()) {
+            throw std::runtime_error("The parameter concurrency-list is empty");
+        }
+        for (std::size_t concurrency: param_concurrency_list) {
+            if (concurrency == 0) {
+                throw std::runtime_error("The parameter concurrency-list must contain values strictly greater than 0");
+            }
+        }
+
+        // param pipeline, the numbers of pruner and filter threads
+        if (arguments.count("pipeline")) {
+            param_pipeline_threads = read_parameter_list<std::size_t>(arguments["pipeline"].as<std::string>());
+            if (param_pipeline_threads.size() != 2 || param_pipeline_threads[0] == 0 || param_pipeline_threads[1] == 0) {
+                throw std::runtime_error("The parameter pipeline must contain two numbers strictly greater than 0");
+            }
+        }
+
+        // param cpu list
+        if (arguments.count("cpu-list")) {
+            param_cpu_list = read_parameter_list<int>(arguments["cpu-list"].as<std::string>());
+            if (param_cpu_list.size() < *std::max_element(param_concurrency_list.begin(), param_concurrency_list.end())) {
+                throw std::runtime_error("The parameter cpu-list must contain at least one cpu per worker");
+            }
+        }
+
+        // the closed loop of the pipeline keeps by default one request outstanding per thread
+        if (!param_pipeline_threads.empty() && !arguments.count("concurrency-list") && !arguments["scale"].as<bool>()) {
+            param_concurrency_list = {param_pipeline_threads[0] + param_pipeline_threads[1]};
+        }
+
+        // the filtering pipeline
+        std::shared_ptr<ScoreFun> score_fun = std::make_shared<ScoreFun>(param_k);
+        std::shared_ptr<Filter<ScoreFun>> filter = std::make_shared<FilterSpirin<ScoreFun>>(param_k, score_fun);
+        test = make_strategy_test<ScoreFun>(param_strategy, score_fun, filter, param_epsilon, 1);
+
+        // param output
+        if (arguments.count("output")) {
+            std::string output_file_path = arguments["output"].as<std::string>();
+            param_ofstream = new std::ofstream(output_file_path);
+            if (!param_ofstream->is_open()) {
+                throw std::runtime_error(std::string("Unable to open the output file ") + output_file_path);
+            }
+        }
+    } catch (std::runtime_error & e) {
+        std::cerr << e.what() << "." << std::endl;
+        return -1;
+    }
+
+    // READ the dataset in memory
+    std::vector<LoadRequest> requests;
+    auto add_request = [&](ResultsList &&resultsList) {
+        if (resultsList.size() == 0) {
+            return;
+        }
+        LoadRequest request;
+        request.n = static_cast<index_type>((param_n_cut > 0) ? std::min(resultsList.size(), static_cast<std::size_t>(param_n_cut)) : resultsList.size());
+        request.list.reset(new ResultsList(std::move(resultsList)));
+        requests.push_back(std::move(request));
+    };
+    if (!param_file_path_list.empty()) {
+        for (const std::string &file_path: param_file_path_list) {
+            std::ifstream istream_file(file_path);
+            add_request(read_results_list(istream_file, true));
+        }
+    } else {
+        std::size_t num_lists;
+        if (!(std::cin >> num_lists)) {
+            throw std::runtime_error(
+                    "The input stream is not properly formatted. Unable to extract the number of lists");
+        }
+        if (std::cin.peek() != '\n') {
+            throw std::runtime_error(std::string(
+                    "The input is not properly formatted. A new line is missing after the number of lists (first line)"));
+        }
+        std::cin.ignore();
+        for (std::size_t i = 0; i < num_lists; ++i) {
+            add_request(read_results_list(std::cin, false));
+        }
+    }
+    if (requests.empty()) {
+        std::cerr << "The dataset does not contain any list." << std::endl;
+        return -1;
+    }
+
+    // select the output stream
+    std::ostream & ostream = (param_ofstream != nullptr) ? *param_ofstream : std::cout;
+
+    // RUN the load through the pipelined stages, with each number of outstanding requests in the closed-loop mode
+    if (!param_pipeline_threads.empty()) {
+        if (param_qps > 0) {
+            param_concurrency_list.resize(1);
+        }
+        for (std::size_t concurrency: param_concurrency_list) {
+            PipelineStageStatistics pruning_statistics, filtering_statistics;
+            LoadOutcome outcome = run_pipeline(test, requests, param_pipeline_threads[0], param_pipeline_threads[1],
+                                               concurrency, param_qps, param_warmup, param_duration, param_seed,
+                                               pruning_statistics, filtering_statistics);
+            const double achieved_qps = (outcome.elapsed > 0) ? outcome.num_requests / outcome.elapsed : 0.0;
+
+            ostream << "{\"mode\": \"" << ((param_qps > 0) ? "open" : "closed") << "\"";
+            ostream << ", \"strategy\": "; write_json_string(ostream, test->name);
+            ostream << ", \"n_cut\": " << param_n_cut;
+            ostream << ", \"k\": " << param_k;
+            ostream << ", \"pruner_threads\": " << param_pipeline_threads[0];
+            ostream << ", \"filter_threads\": " << param_pipeline_threads[1];
+            if (param_qps > 0) {
+                ostream << ", \"target_qps\": " << param_qps;
+            } else {
+                ostream << ", \"concurrency\": " << concurrency;
+            }
+            ostream << ", \"requests\": " << outcome.num_requests;
+            ostream << ", \"elapsed\": " << outcome.elapsed;
+            ostream << ", \"qps\": " << achieved_qps;
+            ostream << ", \"avg_latency\": " << ((outcome.num_requests > 0) ? outcome.sum_latency / outcome.num_requests : 0.0);
+            ostream << ", \"latency_percentiles\": "; TestsAggregationOutcome::write_percentiles(ostream, outcome.latency);
+            ostream << ", \"pruning_stage\": " << pruning_statistics;
+            ostream << ", \"filtering_stage\": " << filtering_statistics;
+            ostream << "}" << std::endl;
+        }
+        param_concurrency_list.clear();
+    }
+
+    // RUN the load with each concurrency
+    double single_worker_qps = 0;
+    for (std::size_t concurrency: param_concurrency_list) {
+        LoadOutcome outcome = run_load(*test, requests, concurrency, param_cpu_list, param_qps, param_warmup, param_duration, param_seed);
+        const double achieved_qps = (outcome.elapsed > 0) ? outcome.num_requests / outcome.elapsed : 0.0;
+        if (concurrency == 1) {
+            single_worker_qps = achieved_qps;
+        }
+
+        ostream << "{\"mode\": \"" << ((param_qps > 0) ? "open" : "closed") << "\"";
+        ostream << ", \"strategy\": "; write_json_string(ostream, test->name);
+        ostream << ", \"n_cut\": " << param_n_cut;
+        ostream << ", \"k\": " << param_k;
+        ostream << ", \"concurrency\": " << concurrency;
+        if (param_qps > 0) {
+            ostream << ", \"target_qps\": " << param_qps;
+        }
+        ostream << ", \"requests\": " << outcome.num_requests;
+        ostream << ", \"elapsed\": " << outcome.elapsed;
+        ostream << ", \"qps\": " << achieved_qps;
+        if (single_worker_qps > 0 && param_qps == 0) {
+            ostream << ", \"scaling_efficiency\": " << achieved_qps / (single_worker_qps * concurrency);
+        }
+        ostream << ", \"avg_latency\": " << ((outcome.num_requests > 0) ? outcome.sum_latency / outcome.num_requests : 0.0);
+        ostream << ", \"latency_percentiles\": "; TestsAggregationOutcome::write_percentiles(ostream, outcome.latency);
+        ostream << "}" << std::endl;
+    }
+
+    // close the file output stream
+    if (param_ofstream != nullptr) {
+        param_ofstream->close();
+        delete(param_ofstream);
+    }
+
+    return 0;
+}
+
+
+int main(int argc, char *argv[]) {
+    // command line options
+    cxxopts::Options options(argv[0], "Replays a dataset of lists against a filtering strategy under concurrent load and prints the throughput and the latencies");
+    options
+            .add_options()
+            ("h, help", "Print this help message")
+            ("m, metric", "The search quality metric to use. Available options are: dcg, dcglz", cxxopts::value<std::string>()->default_value("dcg"))
+            ("s, strategy", "The filtering strategy. Available options are: opt, cutoff, topk, epsfiltering", cxxopts::value<std::string>()->default_value("epsfiltering"))
+            ("n, n-cut", "Truncate all lists to the first n elements, if n is greater than zero", cxxopts::value<index_type>()->default_value("0"))
+            ("k", "Maximum number of elements to return", cxxopts::value<k_type>()->default_value("50"))
+            ("e, epsilon", "Target approximation factor", cxxopts::value<score_type>()->default_value("0.01"))
+            ("c, concurrency-list", "Comma separated list of numbers of concurrent workers, or of outstanding requests of the closed loop of --pipeline (default: one per thread of the pipeline)", cxxopts::value<std::string>()->default_value("1"))
+            ("scale", "Use from one worker to a worker per core, doubling the workers at each step", cxxopts::value<bool>()->default_value("false"))
+            ("q, qps", "Target requests per second with Poisson arrivals (open loop), or 0 to send a new request as soon as a worker is free (closed loop)", cxxopts::value<double>()->default_value("0"))
+            ("d, duration", "Duration of the measurement of each concurrency, in seconds", cxxopts::value<double>()->default_value("5"))
+            ("warmup", "Duration of the warmup before each measurement, in seconds", cxxopts::value<double>()->default_value("1"))
+            ("seed", "Seed of the arrivals of the open loop", cxxopts::value<unsigned>()->default_value("0"))
+            ("cpu-list", "Comma separated list of cpus where to pin the workers, one per worker", cxxopts::value<std::string>())
+            ("pipeline", "Run the pruning and the filtering stages on separate threads, with the given comma separated numbers of pruner and filter threads, instead of the concurrent workers", cxxopts::value<std::string>())
+            ("o, output", "Write result to FILE instead of standard output", cxxopts::value<std::string>());
+    options
+            .add_options("hidden")
+            ("positional", "Positional arguments: these are the arguments that are entered without an option", cxxopts::value<std::vector<std::string>>());
+
+    options.parse_positional({"positional"});
+
+    // command line parsing
+    cxxopts::ParseResult arguments = options.parse(argc, argv);
+
+    // help
+    if (arguments.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    // call the templated proxy based on the selected metric function
+    std::string param_metric = arguments["metric"].as<std::string>();
+    try {
+        if (param_metric == "dcg") {
+            return loadgen<dcg_metric>(arguments);
+        } else if (param_metric == "dcglz") {
+            return loadgen<dcglz_metric>(arguments);
+        } else {
+            std::cerr << "The given metric is unavailable." << std::endl;
+            return -1;
+        }
+    } catch (std::runtime_error & e) {
+        std::cerr << e.what() << "." << std::endl;
+        return -1;
+    }
+}
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "utils/assessment_aggregation.hpp"
+#include "utils/cxxopts.hpp"
+#include "utils/json.hpp"
+
+
+int main(int argc, char *argv[]) {
+    // command line options
+    cxxopts::Options options(argv[0], "Merges the partial aggregations written by the shards of an assessment and prints the performance results");
+    options
+            .add_options()
+            ("h, help", "Print this help message")
+            ("o, output", "Write result to FILE instead of standard output", cxxopts::value<std::string>());
+    options
+            .add_options("hidden")
+            ("positional", "Positional arguments: these are the arguments that are entered without an option", cxxopts::value<std::vector<std::string>>());
+
+    options.parse_positional({"positional"});
+
+    // command line parsing
+    cxxopts::ParseResult arguments = options.parse(argc, argv);
+
+    // help
+    if (arguments.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    std::ofstream * param_ofstream = nullptr;
+    AssessmentConfiguration config;
+    std::vector<std::unique_ptr<AssessmentAggregation>> shards;
+
+    try {
+        if (!arguments.count("positional")) {
+            throw std::runtime_error("No partial aggregation to merge");
+        }
+
+        // read all partial aggregations and sort them by shard id
+        std::size_t num_shards = 0;
+        for (const std::string &file_path: arguments["positional"].as<std::vector<std::string>>()) {
+            std::ifstream infile(file_path);
+            if (!infile.is_open()) {
+                throw std::runtime_error(std::string("Unable to open the file ") + file_path);
+            }
+
+            AssessmentConfiguration file_config;
+            std::size_t file_shard_id, file_num_shards;
+            std::unique_ptr<AssessmentAggregation> aggregation = read_assessment_partial(
+                    JsonValue::parse(infile), file_config, file_shard_id, file_num_shards);
+
+            if (shards.empty()) {
+                config = file_config;
+                num_shards = file_num_shards;
+                shards.resize(num_shards);
+            } else if (file_config.metric != config.metric || file_config.n_cut_list != config.n_cut_list ||
+                       file_config.k_list != config.k_list || file_config.test_names != config.test_names ||
+                       file_config.report_throughput != config.report_throughput) {
+                throw std::runtime_error(std::string("The configuration of the file ") + file_path + " differs from the one of the other shards");
+            } else if (file_num_shards != num_shards) {
+                throw std::runtime_error(std::string("The number of shards of the file ") + file_path + " differs from the one of the other shards");
+            }
+            if (file_shard_id >= num_shards) {
+                throw std::runtime_error(std::string("The shard id of the file ") + file_path + " is out of range");
+            }
+            if (shards[file_shard_id] != nullptr) {
+                throw std::runtime_error(std::string("The shard of the file ") + file_path + " is duplicated");
+            }
+            shards[file_shard_id] = std::move(aggregation);
+        }
+        for (std::size_t shard_id = 0; shard_id < num_shards; ++shard_id) {
+            if (shards[shard_id] == nullptr) {
+                std::ostringstream error;
+                error << "The shard " << shard_id << "/" << num_shards << " is missing";
+                throw std::runtime_error(error.str());
+            }
+        }
+
+        // param output
+        if (arguments.count("output")) {
+            std::string output_file_path = arguments["output"].as<std::string>();
+            param_ofstream = new std::ofstream(output_file_path);
+            if (!param_ofstream->is_open()) {
+                throw std::runtime_error(std::string("Unable to open the output file ") + output_file_path);
+            }
+        }
+    } catch (std::runtime_error & e) {
+        std::cerr << e.what() << "." << std::endl;
+        return -1;
+    }
+
+    // MERGE the shards in order, as done by a single run with the blocks of lists
+    AssessmentAggregation aggregation(config.n_cut_list.size(), config.k_list.size(), config.test_names.size() - 1);
+    for (const std::unique_ptr<AssessmentAggregation> &shard: shards) {
+        aggregation.merge(*shard);
+    }
+
+    // WRITE the output
+    // select the output stream
+    std::ostream & ostream = (param_ofstream != nullptr) ? *param_ofstream : std::cout;
+
+    write_assessment_report(ostream, config, aggregation);
+
+    // close the file output stream
+    if (param_ofstream != nullptr) {
+        param_ofstream->close();
+        delete(param_ofstream);
+    }
+
+    return 0;
+}
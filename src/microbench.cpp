@@ -0,0 +1,458 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "data_structures/hash.hpp"
+#include "data_structures/heapq.hpp"
+#include "filtering/search_quality_metric.hpp"
+#include "filters/filter_spirin.hpp"
+#include "pruners/pruner_cutoff.hpp"
+#include "pruners/pruner_epspruning.hpp"
+#include "pruners/pruner_topk.hpp"
+#include "utils/batch.hpp"
+#include "utils/cached_filter.hpp"
+#include "utils/cxxopts.hpp"
+#include "utils/json.hpp"
+#include "utils/strategies.hpp"
+#include "utils/utils.hpp"
+
+
+/**
+ * Result of a microbenchmark: the time per iteration of each repetition.
+ */
+typedef struct {
+    /**
+     * Name of the benchmark
+     */
+    std::string name;
+    /**
+     * Parameters of the benchmark, e.g., n and k
+     */
+    std::vector<std::pair<std::string, double>> params;
+    /**
+     * Number of elements processed by an iteration
+     */
+    std::size_t elements;
+    /**
+     * Number of iterations of each repetition
+     */
+    std::size_t iterations;
+    /**
+     * Time per iteration of each repetition, in nanoseconds
+     */
+    std::vector<double> samples;
+} MicrobenchResult;
+
+
+/**
+ * Runs a benchmark, first calibrating the number of iterations so that each repetition lasts at least min_time
+ * @param body The benchmark, which runs the given number of iterations
+ * @param min_time Minimum time of a repetition, in milliseconds
+ * @param repetitions Number of repetitions
+ * @param result Where to store the iterations and the samples
+ */
+void
+run_microbench(const std::function<void(std::size_t)> &body, double min_time, int repetitions, MicrobenchResult &result) {
+    // warm up and calibrate, doubling the iterations until a repetition is long enough
+    std::size_t iterations = 1;
+    while (true) {
+        std::uint64_t start = get_time_nanoseconds();
+        body(iterations);
+        double elapsed = get_elapsed_milliseconds(start, get_time_nanoseconds());
+        if (elapsed >= min_time || iterations >= (static_cast<std::size_t>(1) << 30)) {
+            if (elapsed > 0) {
+                iterations = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(iterations * min_time / elapsed)));
+            }
+            break;
+        }
+        iterations *= 2;
+    }
+
+    result.iterations = iterations;
+    result.samples.clear();
+    for (int repetition = 0; repetition < repetitions; ++repetition) {
+        std::uint64_t start = get_time_nanoseconds();
+        body(iterations);
+        result.samples.push_back(get_elapsed_milliseconds(start, get_time_nanoseconds()) * 1e6 / iterations);
+    }
+}
+
+
+/**
+ * Writes the result of a benchmark as a json object with its samples and their statistics
+ * @param os The output stream where to write
+ * @param result The result to write
+ */
+void
+write_microbench_result(std::ostream &os, const MicrobenchResult &result) {
+    std::vector<double> sorted(result.samples);
+    std::sort(sorted.begin(), sorted.end());
+    const std::size_t num_samples = sorted.size();
+    double mean = 0;
+    for (double sample: sorted) {
+        mean += sample;
+    }
+    mean /= num_samples;
+    double variance = 0;
+    for (double sample: sorted) {
+        variance += (sample - mean) * (sample - mean);
+    }
+    variance = (num_samples > 1) ? variance / (num_samples - 1) : 0;
+    const double median = (num_samples % 2) ? sorted[num_samples / 2] : (sorted[num_samples / 2 - 1] + sorted[num_samples / 2]) / 2;
+
+    os << "{\"name\": "; write_json_string(os, result.name);
+    os << ", \"params\": {";
+    for (std::size_t i = 0; i < result.params.size(); ++i) {
+        os << ((i > 0) ? ", " : "") << "\"" << result.params[i].first << "\": " << result.params[i].second;
+    }
+    os << "}";
+    os << ", \"elements\": " << result.elements;
+    os << ", \"iterations\": " << result.iterations;
+    os << ", \"repetitions\": " << num_samples;
+    os << ", \"mean_ns\": " << mean;
+    os << ", \"median_ns\": " << median;
+    os << ", \"min_ns\": " << sorted.front();
+    os << ", \"stddev_ns\": " << std::sqrt(variance);
+    os << ", \"ns_per_element\": " << ((result.elements > 0) ? median / result.elements : median);
+    os << ", \"samples_ns\": [";
+    for (std::size_t i = 0; i < num_samples; ++i) {
+        os << ((i > 0) ? ", " : "") << result.samples[i];
+    }
+    os << "]}";
+}
+
+
+template <typename ScoreFun>
+int
+microbench(
+        const cxxopts::ParseResult &arguments
+) {
+    // parameters
+    std::vector<index_type>  param_n_list;
+    std::vector<k_type>      param_k_list;
+    std::vector<score_type>  param_epsilon_list;
+    std::vector<std::string> param_benchmarks;
+    const double param_min_time = arguments["min-time"].as<double>();
+    const int    param_repetitions = arguments["repetitions"].as<int>();
+    const unsigned param_seed = arguments["seed"].as<unsigned>();
+    const std::size_t param_batch_size = arguments["batch-size"].as<std::size_t>();
+    std::size_t param_num_threads = arguments["threads"].as<std::size_t>();
+    std::ofstream * param_ofstream = nullptr;
+
+    // check the command line parameters
+    try {
+        param_n_list = read_parameter_list<index_type>(arguments["n-list"].as<std::string>());
+        param_k_list = read_parameter_list<k_type>(arguments["k-list"].as<std::string>());
+        param_epsilon_list = read_parameter_list<score_type>(arguments["epsilon-list"].as<std::string>());
+        std::istringstream benchmarks_stream(arguments["benchmarks"].as<std::string>());
+        for (std::string prefix; std::getline(benchmarks_stream, prefix, ',');) {
+            if (!prefix.empty()) {
+                param_benchmarks.push_back(prefix);
+            }
+        }
+        if (param_n_list.empty() || param_k_list.empty() || param_epsilon_list.empty()) {
+            throw std::runtime_error("The parameters n-list, k-list, and epsilon-list must not be empty");
+        }
+        for (index_type n: param_n_list) {
+            if (n == 0) {
+                throw std::runtime_error("The parameter n-list must contain values strictly greater than 0");
+            }
+        }
+        for (k_type k: param_k_list) {
+            if (k == 0) {
+                throw std::runtime_error("The parameter k-list must contain values strictly greater than 0");
+            }
+        }
+        for (score_type epsilon: param_epsilon_list) {
+            if (epsilon <= 0 || epsilon >= 1) {
+                throw std::runtime_error("The parameter epsilon-list must contain values between zero and one");
+            }
+        }
+        if (param_min_time <= 0) {
+            throw std::runtime_error("The parameter min-time must be a number strictly greater than 0");
+        }
+        if (param_repetitions <= 0) {
+            throw std::runtime_error("The parameter repetitions must be a number strictly greater than 0");
+        }
+        if (param_batch_size == 0) {
+            throw std::runtime_error("The parameter batch-size must be a number strictly greater than 0");
+        }
+        if (param_num_threads == 0) {
+            param_num_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // set the cpu-affinity, if required
+        int cpu_affinity = arguments["cpu-affinity"].as<int>();
+        if (cpu_affinity > -1) {
+            set_cpu_affinity(cpu_affinity);
+        }
+
+        // param output
+        if (arguments.count("output")) {
+            std::string output_file_path = arguments["output"].as<std::string>();
+            param_ofstream = new std::ofstream(output_file_path);
+            if (!param_ofstream->is_open()) {
+                throw std::runtime_error(std::string("Unable to open the output file ") + output_file_path);
+            }
+        }
+    } catch (std::runtime_error & e) {
+        std::cerr << e.what() << "." << std::endl;
+        return -1;
+    }
+
+    auto selected = [&](const std::string &name) {
+        for (const std::string &prefix: param_benchmarks) {
+            if (prefix == "all" || name.compare(0, prefix.size(), prefix) == 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    std::ostream & ostream = (param_ofstream != nullptr) ? *param_ofstream : std::cout;
+    ostream << "{\"format\": \"microbench\", \"version\": 1, \"metric\": ";
+    write_json_string(ostream, arguments["metric"].as<std::string>());
+    ostream << ", \"benchmarks\": [";
+    bool first = true;
+    auto run = [&](const std::string &name, std::vector<std::pair<std::string, double>> params, std::size_t elements, const std::function<void(std::size_t)> &body) {
+        if (!selected(name)) {
+            return;
+        }
+        MicrobenchResult result;
+        result.name = name;
+        result.params = std::move(params);
+        result.elements = elements;
+        run_microbench(body, param_min_time, param_repetitions, result);
+        ostream << (first ? "" : ",") << std::endl << "\t";
+        write_microbench_result(ostream, result);
+        ostream.flush();
+        first = false;
+    };
+
+    std::mt19937 random_engine(param_seed);
+    std::uniform_real_distribution<relevance_type> relevance_distribution(0, 1);
+    std::shared_ptr<ScoreFun> score_fun = std::make_shared<ScoreFun>(*std::max_element(param_k_list.begin(), param_k_list.end()));
+
+    // SWEEP over the parameters
+    for (index_type n: param_n_list) {
+        // random list of relevances and its textual representation
+        std::vector<relevance_type> rel_list(n);
+        for (index_type i = 0; i < n; ++i) {
+            rel_list[i] = relevance_distribution(random_engine);
+        }
+        minmax_type minmax_element;
+        minmax_element.min = *std::min_element(rel_list.begin(), rel_list.end());
+        minmax_element.max = *std::max_element(rel_list.begin(), rel_list.end());
+
+        run("dcg_gain", {{"n", n}}, n, [&](std::size_t iterations) {
+            for (std::size_t it = 0; it < iterations; ++it) {
+                score_type sum = 0;
+                for (index_type i = 0; i < n; ++i) {
+                    sum += score_fun->gain_factor(rel_list[i]);
+                }
+                doNotOptimizeAway(sum);
+            }
+        });
+
+        run("hash_list", {{"n", n}}, n, [&](std::size_t iterations) {
+            for (std::size_t it = 0; it < iterations; ++it) {
+                doNotOptimizeAway(hash64::hash(rel_list.data(), n * sizeof(relevance_type), it));
+            }
+        });
+
+        if (selected("read_results_list")) {
+            std::ostringstream text;
+            for (index_type i = 0; i < n; ++i) {
+                text << "d" << i << "\t" << i << "\t" << rel_list[i] << "\n";
+            }
+            const std::string list_text = text.str();
+            run("read_results_list", {{"n", n}}, n, [&](std::size_t iterations) {
+                for (std::size_t it = 0; it < iterations; ++it) {
+                    std::istringstream istream(list_text);
+                    doNotOptimizeAway(read_results_list(istream, true).size());
+                }
+            });
+        }
+
+        run("pruner_cutoff", {{"n", n}}, n, [&](std::size_t iterations) {
+            PrunerCutoff<ScoreFun> pruner(score_fun);
+            for (std::size_t it = 0; it < iterations; ++it) {
+                doNotOptimizeAway(pruner(rel_list.data(), n, minmax_element).size());
+            }
+        });
+
+        for (k_type k: param_k_list) {
+            if (k > n) {
+                continue;
+            }
+
+            // replacements in a heap of k elements
+            std::vector<relevance_type> heap_source(rel_list.begin(), rel_list.begin() + k);
+            run("heapq_replace", {{"n", n}, {"k", k}}, n, [&](std::size_t iterations) {
+                std::vector<relevance_type> heap(heap_source);
+                heapq::heapify(heap);
+                for (std::size_t it = 0; it < iterations; ++it) {
+                    for (index_type i = 0; i < n; ++i) {
+                        heapq::replace(heap, rel_list[i]);
+                    }
+                    doNotOptimizeAway(heap[0]);
+                }
+            });
+
+            run("pruner_topk", {{"n", n}, {"k", k}}, n, [&](std::size_t iterations) {
+                PrunerTopk<ScoreFun> pruner(score_fun, k);
+                for (std::size_t it = 0; it < iterations; ++it) {
+                    doNotOptimizeAway(pruner(rel_list.data(), n, minmax_element).size());
+                }
+            });
+            for (score_type epsilon: param_epsilon_list) {
+                run("pruner_epspruning", {{"n", n}, {"k", k}, {"epsilon", epsilon}}, n, [&](std::size_t iterations) {
+                    PrunerEpsPruning<ScoreFun> pruner(score_fun, k, epsilon);
+                    for (std::size_t it = 0; it < iterations; ++it) {
+                        doNotOptimizeAway(pruner(rel_list.data(), n, minmax_element).size());
+                    }
+                });
+            }
+
+            run("filter_spirin", {{"n", n}, {"k", k}}, n, [&](std::size_t iterations) {
+                FilterSpirin<ScoreFun> filter(k, score_fun);
+                for (std::size_t it = 0; it < iterations; ++it) {
+                    doNotOptimizeAway(filter(rel_list.data(), n).score);
+                }
+            });
+            run("filter_spirin_workspace", {{"n", n}, {"k", k}}, n, [&](std::size_t iterations) {
+                FilterSpirin<ScoreFun> filter(k, score_fun);
+                Workspace workspace;
+                for (std::size_t it = 0; it < iterations; ++it) {
+                    doNotOptimizeAway(filter(rel_list.data(), n, workspace).score);
+                }
+            });
+
+            if (selected("filter_batch")) {
+                // batch of lists whose lengths are uniformly distributed up to n, each one a window of the random list
+                std::uniform_int_distribution<index_type> length_distribution(1, n);
+                std::vector<BatchList> batch(param_batch_size);
+                std::size_t batch_elements = 0;
+                for (BatchList &list: batch) {
+                    list.n = length_distribution(random_engine);
+                    list.relevances = rel_list.data() + (n - list.n);
+                    batch_elements += list.n;
+                }
+                std::shared_ptr<Filter<ScoreFun>> filter = std::make_shared<FilterSpirin<ScoreFun>>(k, score_fun);
+                BatchFilter<ScoreFun> batch_filter(param_num_threads);
+                std::vector<FilterSolution> results;
+                for (score_type epsilon: param_epsilon_list) {
+                    std::vector<typename BatchFilter<ScoreFun>::pipeline_type> configs = {
+                            make_strategy_test<ScoreFun>("epsfiltering", score_fun, filter, epsilon, 1)
+                    };
+                    run("filter_batch", {{"n", n}, {"k", k}, {"epsilon", epsilon}, {"batch_size", static_cast<double>(param_batch_size)}, {"threads", static_cast<double>(param_num_threads)}}, batch_elements, [&](std::size_t iterations) {
+                        for (std::size_t it = 0; it < iterations; ++it) {
+                            batch_filter.filter_batch(batch, configs, results);
+                            doNotOptimizeAway(results.back().score);
+                        }
+                    });
+                }
+            }
+
+            // lookup of a list whose solution is already cached: hashing, lookup and copy of the solution
+            for (score_type epsilon: param_epsilon_list) {
+                run("cached_filter_hit", {{"n", n}, {"k", k}, {"epsilon", epsilon}}, n, [&](std::size_t iterations) {
+                    std::shared_ptr<Filter<ScoreFun>> filter = std::make_shared<FilterSpirin<ScoreFun>>(k, score_fun);
+                    CachedFilter<ScoreFun> cached_filter(make_strategy_test<ScoreFun>("epsfiltering", score_fun, filter, epsilon, 1),
+                                                         std::make_shared<typename CachedFilter<ScoreFun>::cache_type>(1 << 20));
+                    Workspace workspace;
+                    cached_filter(rel_list.data(), n, workspace);
+                    for (std::size_t it = 0; it < iterations; ++it) {
+                        doNotOptimizeAway(cached_filter(rel_list.data(), n, workspace).score);
+                    }
+                });
+            }
+        }
+    }
+
+    // heap operations on k elements, which do not depend on n
+    for (k_type k: param_k_list) {
+        std::vector<relevance_type> heap_source(k);
+        for (k_type i = 0; i < k; ++i) {
+            heap_source[i] = relevance_distribution(random_engine);
+        }
+        run("heapq_heapify", {{"k", k}}, k, [&](std::size_t iterations) {
+            std::vector<relevance_type> heap(heap_source);
+            for (std::size_t it = 0; it < iterations; ++it) {
+                std::copy(heap_source.begin(), heap_source.end(), heap.begin());
+                heapq::heapify(heap);
+                doNotOptimizeAway(heap[0]);
+            }
+        });
+        run("heapq_pop", {{"k", k}}, k, [&](std::size_t iterations) {
+            std::vector<relevance_type> heapified(heap_source);
+            heapq::heapify(heapified);
+            std::vector<relevance_type> heap;
+            heap.reserve(k);
+            for (std::size_t it = 0; it < iterations; ++it) {
+                heap.assign(heapified.begin(), heapified.end());
+                while (!heap.empty()) {
+                    heapq::pop(heap);
+                }
+                doNotOptimizeAway(heap.size());
+            }
+        });
+    }
+    ostream << std::endl << "]}" << std::endl;
+
+    // close the file output stream
+    if (param_ofstream != nullptr) {
+        param_ofstream->close();
+        delete(param_ofstream);
+    }
+
+    return 0;
+}
+
+
+int main(int argc, char *argv[]) {
+    // command line options
+    cxxopts::Options options(argv[0], "Runs the microbenchmarks of the components of the filtering strategies and prints their timings");
+    options
+            .add_options()
+            ("h, help", "Print this help message")
+            ("m, metric", "The search quality metric to use. Available options are: dcg, dcglz", cxxopts::value<std::string>()->default_value("dcg"))
+            ("b, benchmarks", "Comma separated list of prefixes of the benchmarks to run, or all. Available benchmarks are: dcg_gain, read_results_list, heapq_heapify, heapq_replace, heapq_pop, pruner_cutoff, pruner_topk, pruner_epspruning, filter_spirin, filter_spirin_workspace, filter_batch, hash_list, cached_filter_hit", cxxopts::value<std::string>()->default_value("all"))
+            ("n, n-list", "Comma separated list of list lengths", cxxopts::value<std::string>()->default_value("1000,10000"))
+            ("k, k-list", "Comma separated list of numbers of elements to return", cxxopts::value<std::string>()->default_value("10,50,100"))
+            ("e, epsilon-list", "Comma separated list of approximation factors", cxxopts::value<std::string>()->default_value("0.1,0.01"))
+            ("min-time", "Minimum time of each repetition, in milliseconds", cxxopts::value<double>()->default_value("10"))
+            ("r, repetitions", "Number of repetitions of each benchmark", cxxopts::value<int>()->default_value("10"))
+            ("seed", "Seed of the random lists", cxxopts::value<unsigned>()->default_value("0"))
+            ("batch-size", "Number of lists of each batch of filter_batch", cxxopts::value<std::size_t>()->default_value("256"))
+            ("t, threads", "Number of worker threads of filter_batch, or 0 to use all cores", cxxopts::value<std::size_t>()->default_value("0"))
+            ("a, cpu-affinity", "Set the cpu affinity of the process", cxxopts::value<int>()->default_value("-1"))
+            ("o, output", "Write result to FILE instead of standard output", cxxopts::value<std::string>());
+
+    // command line parsing
+    cxxopts::ParseResult arguments = options.parse(argc, argv);
+
+    // help
+    if (arguments.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    // call the templated proxy based on the selected metric function
+    std::string param_metric = arguments["metric"].as<std::string>();
+    if (param_metric == "dcg") {
+        return microbench<dcg_metric>(arguments);
+    } else if (param_metric == "dcglz") {
+        return microbench<dcglz_metric>(arguments);
+    } else {
+        std::cerr << "The given metric is unavailable." << std::endl;
+        return -1;
+    }
+}
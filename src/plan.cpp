@@ -0,0 +1,94 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "filtering/search_quality_metric.hpp"
+#include "utils/cost_model.hpp"
+#include "utils/cxxopts.hpp"
+#include "utils/json.hpp"
+
+
+template <typename ScoreFun>
+int
+fit(
+        const cxxopts::ParseResult &arguments
+) {
+    std::ofstream * param_ofstream = nullptr;
+    std::vector<JsonValue> reports;
+
+    try {
+        if (!arguments.count("positional")) {
+            throw std::runtime_error("No assessment report to fit the cost model on");
+        }
+        for (const std::string &file_path: arguments["positional"].as<std::vector<std::string>>()) {
+            std::ifstream infile(file_path);
+            if (!infile.is_open()) {
+                throw std::runtime_error(std::string("Unable to open the file ") + file_path);
+            }
+            reports.push_back(JsonValue::parse(infile));
+        }
+
+        // param output
+        if (arguments.count("output")) {
+            std::string output_file_path = arguments["output"].as<std::string>();
+            param_ofstream = new std::ofstream(output_file_path);
+            if (!param_ofstream->is_open()) {
+                throw std::runtime_error(std::string("Unable to open the output file ") + output_file_path);
+            }
+        }
+
+        const CostModel<ScoreFun> cost_model = CostModel<ScoreFun>::fit(reports);
+
+        // WRITE the output
+        std::ostream & ostream = (param_ofstream != nullptr) ? *param_ofstream : std::cout;
+        ostream << cost_model << std::endl;
+    } catch (std::runtime_error & e) {
+        std::cerr << e.what() << "." << std::endl;
+        return -1;
+    }
+
+    // close the file output stream
+    if (param_ofstream != nullptr) {
+        param_ofstream->close();
+        delete(param_ofstream);
+    }
+
+    return 0;
+}
+
+
+int main(int argc, char *argv[]) {
+    // command line options
+    cxxopts::Options options(argv[0], "Fits the cost models of the filtering strategies on assessment reports and prints them, to be used by filter --cost-model");
+    options
+            .add_options()
+            ("h, help", "Print this help message")
+            ("m, metric", "The search quality metric of the reports. Available options are: dcg, dcglz", cxxopts::value<std::string>()->default_value("dcg"))
+            ("o, output", "Write result to FILE instead of standard output", cxxopts::value<std::string>());
+    options
+            .add_options("hidden")
+            ("positional", "Positional arguments: these are the arguments that are entered without an option", cxxopts::value<std::vector<std::string>>());
+
+    options.parse_positional({"positional"});
+
+    // command line parsing
+    cxxopts::ParseResult arguments = options.parse(argc, argv);
+
+    // help
+    if (arguments.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    // call the templated proxy based on the selected metric function
+    std::string param_metric = arguments["metric"].as<std::string>();
+    if (param_metric == "dcg") {
+        return fit<dcg_metric>(arguments);
+    } else if (param_metric == "dcglz") {
+        return fit<dcglz_metric>(arguments);
+    } else {
+        std::cerr << "The given metric is unavailable." << std::endl;
+        return -1;
+    }
+}
@@ -6,9 +6,26 @@
 #include <cmath>
 #include <vector>
 #include "../data_structures/heapq.hpp"
+#include "../filtering/filtering_stats.hpp"
 #include "../filtering/pruner.hpp"
 
 
+/**
+ * Thresholds applied by the epsilon pruning to a list, from its end to its beginning: each element pruned has a
+ * relevance not greater than the threshold of its level.
+ */
+typedef struct {
+    /**
+     * Threshold of each level
+     */
+    std::vector<relevance_type> thresholds;
+    /**
+     * Number of elements pruned in each level
+     */
+    std::vector<index_type> num_pruned;
+} PruningLevels;
+
+
 /**
  * Epsilon pruning.
  * @tparam ScoreFun Score function type
@@ -41,16 +58,25 @@ public:
      */
     PrunerSolution
     operator()(const relevance_type * rel_list, const index_type n, const minmax_type &minmax_element) const {
+        return this->operator()(rel_list, n, minmax_element, nullptr);
+    }
+
+    /**
+     * Prunes the given list of relevances and returns a pruning solution containing the elements that can compose
+     * a (1-epsilon)-optimal filtering solution, and the thresholds applied to the elements pruned.
+     * @param rel_list List containing the relevance scores, ordered according to some attribute
+     * @param n Number of elements of rel_list
+     * @param minmax_element The pair containing the min and maximum elements of the list
+     * @param levels Where to store the thresholds applied, or nullptr
+     * @return The pruning solution built on top of the given list of relevances
+     */
+    PrunerSolution
+    operator()(const relevance_type * rel_list, const index_type n, const minmax_type &minmax_element, PruningLevels *levels) const {
         const score_type delta = (1 - this->epsilon);
         const ScoreFun & score_fun = *(this->score_fun.get());
 
         const score_type max_gain = score_fun.gain_factor(minmax_element.max);
-        const score_type min_gain = std::max(
-                // min element
-                score_fun.gain_factor(minmax_element.min),
-                // the contribution of all elements after M must not be over epsilon times M
-                (this->epsilon * max_gain * score_fun.discount_factor(1)) / (delta * score_fun.discount_factor_sum(2, this->k))
-        ) * (1.0 - 1e-16);  // workaround to fix numerical instability
+        const score_type min_gain = this->min_gain(minmax_element);
         relevance_type min_threshold = score_fun.gain_factor_inverse(min_gain);
         for (std::size_t i = 16;
              i > 0 && score_fun.gain_factor(min_threshold) > min_gain; --i) {  // workaround to fix numerical instability
@@ -61,9 +87,7 @@ public:
 //    }
 
         // compute the number of intervals
-        std::vector<relevance_type> interval_boundaries(
-                1 + static_cast<std::size_t>(1 + std::ceil(std::log2(min_gain / max_gain) / std::log2(delta)))
-        );
+        std::vector<relevance_type> interval_boundaries(1 + this->num_intervals(minmax_element));
         // and fill the boundaries vector with all the boundaries
         double v = max_gain;
         for (std::size_t i = interval_boundaries.size(); i > 0; --i) {
@@ -72,6 +96,7 @@ public:
         }
         interval_boundaries.back() = minmax_element.max; // fix the error of the last interval due to the inverse operation
         assert(interval_boundaries[0] <= min_threshold);
+        FILTERING_STATS_ADD(EPSPRUNING_INTERVALS, interval_boundaries.size() - 1);
 
         // output pruned list
         PrunerSolution solution;
@@ -87,6 +112,7 @@ public:
             if (rel_list[i] >= min_threshold) {
                 solution.indices.push_back(i);
                 heap.push_back(rel_list[i]);
+                FILTERING_STATS_EPSPRUNING_CANDIDATE(0);
 
                 if (heap.size() == this->k) {
                     break;
@@ -94,6 +120,14 @@ public:
             }
         }
 
+        std::size_t level_end = n;
+        std::size_t level_candidates = 0;
+        if (levels != nullptr) {
+            levels->thresholds.clear();
+            levels->num_pruned.clear();
+            add_level(levels, min_threshold, i, solution.indices.size(), level_end, level_candidates);
+        }
+
         // heapify
         heapq::heapify(heap);
 
@@ -111,6 +145,8 @@ public:
             }
             solution.indices.push_back(i);
             heapq::replace(heap, rel_list[i]);
+            FILTERING_STATS_EPSPRUNING_CANDIDATE(min_interval_id);
+            FILTERING_STATS_ADD(EPSPRUNING_HEAP_REPLACEMENTS, 1);
 
             // update min_interval_id and threshold
             if (interval_boundaries[min_interval_id] < heap[0]) {
@@ -118,18 +154,79 @@ public:
                 while (interval_boundaries[min_interval_id] < heap[0]) {
                     ++min_interval_id;
                 }
+                FILTERING_STATS_ADD(EPSPRUNING_THRESHOLD_ADVANCES, 1);
+                if (levels != nullptr) {
+                    add_level(levels, min_threshold, i, solution.indices.size(), level_end, level_candidates);
+                }
+                // at the last boundary, i.e., the maximum, which bounds the elements not scanned
+                min_threshold = interval_boundaries[min_interval_id];
                 if (min_interval_id == (interval_boundaries.size() - 1)) {
                     break;
                 }
-                min_threshold = interval_boundaries[min_interval_id];
             }
         }
+        if (levels != nullptr) {
+            add_level(levels, min_threshold, 0, solution.indices.size(), level_end, level_candidates);
+        }
 
         std::reverse(solution.indices.begin(), solution.indices.end());
 
         return solution;
     }
 
+    /**
+     * Number of intervals into which the gains of a list are split, each one keeping at most k candidates
+     * @param minmax_element The pair containing the min and maximum elements of the list
+     * @return The number of intervals
+     */
+    std::size_t
+    num_intervals(const minmax_type &minmax_element) const {
+        const score_type delta = (1 - this->epsilon);
+        const score_type max_gain = this->score_fun->gain_factor(minmax_element.max);
+        return static_cast<std::size_t>(1 + std::ceil(std::log2(this->min_gain(minmax_element) / max_gain) / std::log2(delta)));
+    }
+
+private:
+    /**
+     * Adds a level to the thresholds applied, if it has pruned some elements
+     * @param levels The thresholds applied
+     * @param threshold The threshold of the level
+     * @param level_begin The first position of the level
+     * @param num_candidates The number of elements not pruned from level_begin to the end of the list
+     * @param level_end The position following the last one of the level, updated to level_begin
+     * @param level_candidates The number of elements not pruned from level_end to the end of the list, updated to
+     *                         num_candidates
+     */
+    static void
+    add_level(PruningLevels *levels, relevance_type threshold, std::size_t level_begin, std::size_t num_candidates,
+              std::size_t &level_end, std::size_t &level_candidates) {
+        const std::size_t num_pruned = (level_end - level_begin) - (num_candidates - level_candidates);
+        if (num_pruned > 0) {
+            levels->thresholds.push_back(threshold);
+            levels->num_pruned.push_back(static_cast<index_type>(num_pruned));
+        }
+        level_end = level_begin;
+        level_candidates = num_candidates;
+    }
+
+    /**
+     * Minimum gain of the elements that can be kept
+     * @param minmax_element The pair containing the min and maximum elements of the list
+     * @return The minimum gain
+     */
+    score_type
+    min_gain(const minmax_type &minmax_element) const {
+        const score_type delta = (1 - this->epsilon);
+        const ScoreFun & score_fun = *(this->score_fun.get());
+        const score_type max_gain = score_fun.gain_factor(minmax_element.max);
+        return std::max(
+                // min element
+                score_fun.gain_factor(minmax_element.min),
+                // the contribution of all elements after M must not be over epsilon times M
+                (this->epsilon * max_gain * score_fun.discount_factor(1)) / (delta * score_fun.discount_factor_sum(2, this->k))
+        ) * (1.0 - 1e-16);  // workaround to fix numerical instability
+    }
+
 public:
     /**
      * Maximum number of elements to keep
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include "../data_structures/heapq.hpp"
+#include "../filtering/filtering_stats.hpp"
 #include "../filtering/pruner.hpp"
 
 
@@ -69,6 +70,7 @@ public:
             solution.indices.push_back(i);
             if (rel_list[i] == heap[0]) {
                 heapq::pop(heap);
+                FILTERING_STATS_ADD(TOPK_TIE_POPS, 1);
                 if (heap.empty()) {
                     break;
                 }
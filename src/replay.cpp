@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+#include <vector>
+
+#include "filtering/search_quality_metric.hpp"
+#include "utils/capture.hpp"
+#include "utils/cxxopts.hpp"
+#include "utils/json.hpp"
+#include "utils/strategies.hpp"
+#include "utils/utils.hpp"
+
+
+/**
+ * Reruns the test of a captured list and writes a json line comparing the captured timings with the new ones
+ * @param os The output stream where to write
+ * @param capture_path The path of the json description of the captured list
+ * @param captured The captured list
+ * @param num_runs The number of runs of the test
+ */
+template <typename ScoreFun>
+void
+replay(std::ostream &os, const std::string &capture_path, const CapturedList &captured, int num_runs) {
+    const std::size_t slash = capture_path.find_last_of('/');
+    const std::string list_path = ((slash != std::string::npos) ? capture_path.substr(0, slash + 1) : std::string()) + captured.list_file;
+    std::ifstream list_stream(list_path);
+    if (!list_stream.is_open()) {
+        throw std::runtime_error(std::string("Unable to open the file ") + list_path);
+    }
+    ResultsList resultsList = read_results_list(list_stream, true);
+    list_stream.close();
+
+    const relevance_type *rel_list = resultsList.relevances.data();
+    const index_type n = static_cast<index_type>(std::min(resultsList.size(), static_cast<std::size_t>(captured.n)));
+    if (n == 0) {
+        throw std::runtime_error(std::string("The captured list ") + list_path + " is empty");
+    }
+
+    std::shared_ptr<ScoreFun> score_fun = std::make_shared<ScoreFun>(captured.k);
+    std::shared_ptr<Filter<ScoreFun>> filter = std::make_shared<FilterSpirin<ScoreFun>>(captured.k, score_fun);
+    std::shared_ptr<PrunerFilterCompositionTest<ScoreFun>> test = make_strategy_test<ScoreFun>(
+            strategy_of_test_name(captured.test_name), score_fun, filter, captured.epsilon, num_runs);
+
+    // compute min and max elements of the list
+    minmax_type minmax_element;
+    minmax_element.min = minmax_element.max = rel_list[0];
+    for (index_type j = 1; j < n; ++j) {
+        if (rel_list[j] < minmax_element.min) {
+            minmax_element.min = rel_list[j];
+        } else if (rel_list[j] > minmax_element.max) {
+            minmax_element.max = rel_list[j];
+        }
+    }
+
+    TestOutcome outcome = test->operator()(rel_list, n, minmax_element);
+
+    os << "{\"capture\": "; write_json_string(os, capture_path);
+    os << ", \"test\": "; write_json_string(os, test->name);
+    os << ", \"n\": " << n;
+    os << ", \"k\": " << captured.k;
+    os << ", \"score_matches\": " << ((outcome.score == captured.outcome.score) ? "true" : "false");
+    os << ", \"captured_first_stage_time\": " << captured.outcome.first_stage_time;
+    os << ", \"captured_second_stage_time\": " << captured.outcome.second_stage_time;
+    os << ", \"captured_total_time\": " << captured.outcome.total_time;
+    os << ", \"first_stage_time\": " << outcome.first_stage_time;
+    os << ", \"second_stage_time\": " << outcome.second_stage_time;
+    os << ", \"total_time\": " << outcome.total_time;
+    os << "}" << std::endl;
+}
+
+
+int main(int argc, char *argv[]) {
+    // command line options
+    cxxopts::Options options(argv[0], "Reruns the tests of the lists captured by assessment, e.g., under a profiler, and prints their timings");
+    options
+            .add_options()
+            ("h, help", "Print this help message")
+            ("r, num-runs", "Number of times each test must be repeated", cxxopts::value<int>()->default_value("100"))
+            ("a, cpu-affinity", "Set the cpu affinity of the process", cxxopts::value<int>()->default_value("-1"))
+            ("o, output", "Write result to FILE instead of standard output", cxxopts::value<std::string>());
+    options
+            .add_options("hidden")
+            ("positional", "Positional arguments: these are the arguments that are entered without an option", cxxopts::value<std::vector<std::string>>());
+
+    options.parse_positional({"positional"});
+
+    // command line parsing
+    cxxopts::ParseResult arguments = options.parse(argc, argv);
+
+    // help
+    if (arguments.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    const int param_num_runs = arguments["num-runs"].as<int>();
+    std::vector<std::string> capture_paths;
+    std::ofstream * param_ofstream = nullptr;
+
+    try {
+        if (param_num_runs <= 0) {
+            throw std::runtime_error("The parameter runs must be a number strictly greater than 0");
+        }
+        if (!arguments.count("positional")) {
+            throw std::runtime_error("No captured list to replay");
+        }
+
+        // collect the descriptions of the captured lists, expanding the directories
+        for (const std::string &path: arguments["positional"].as<std::vector<std::string>>()) {
+            struct stat s;
+            if (stat(path.c_str(), &s) != 0) {
+                throw std::runtime_error(std::string("Unable to access the stats of the file: ") + path);
+            }
+            if (!(s.st_mode & S_IFDIR)) {
+                capture_paths.push_back(path);
+                continue;
+            }
+            DIR *dir = opendir(path.c_str());
+            if (dir == nullptr) {
+                throw std::runtime_error(std::string("Unable to open the directory ") + path);
+            }
+            std::vector<std::string> dir_paths;
+            for (struct dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+                const std::string name = entry->d_name;
+                if (name.size() > 5 && name.compare(name.size() - 5, 5, ".json") == 0) {
+                    dir_paths.push_back(path + "/" + name);
+                }
+            }
+            closedir(dir);
+            std::sort(dir_paths.begin(), dir_paths.end());
+            capture_paths.insert(capture_paths.end(), dir_paths.begin(), dir_paths.end());
+        }
+
+        // set the cpu-affinity, if required
+        int cpu_affinity = arguments["cpu-affinity"].as<int>();
+        if (cpu_affinity > -1) {
+            set_cpu_affinity(cpu_affinity);
+        }
+
+        // param output
+        if (arguments.count("output")) {
+            std::string output_file_path = arguments["output"].as<std::string>();
+            param_ofstream = new std::ofstream(output_file_path);
+            if (!param_ofstream->is_open()) {
+                throw std::runtime_error(std::string("Unable to open the output file ") + output_file_path);
+            }
+        }
+    } catch (std::runtime_error & e) {
+        std::cerr << e.what() << "." << std::endl;
+        return -1;
+    }
+
+    // select the output stream
+    std::ostream & ostream = (param_ofstream != nullptr) ? *param_ofstream : std::cout;
+
+    // REPLAY the captured lists
+    int status = 0;
+    for (const std::string &capture_path: capture_paths) {
+        try {
+            std::ifstream capture_stream(capture_path);
+            if (!capture_stream.is_open()) {
+                throw std::runtime_error(std::string("Unable to open the file ") + capture_path);
+            }
+            CapturedList captured = read_captured_list(JsonValue::parse(capture_stream));
+
+            if (captured.metric == "dcg") {
+                replay<dcg_metric>(ostream, capture_path, captured, param_num_runs);
+            } else if (captured.metric == "dcglz") {
+                replay<dcglz_metric>(ostream, capture_path, captured, param_num_runs);
+            } else {
+                throw std::runtime_error(std::string("The metric of the captured list ") + capture_path + " is unavailable");
+            }
+        } catch (std::runtime_error & e) {
+            std::cerr << e.what() << "." << std::endl;
+            status = -1;
+        }
+    }
+
+    // close the file output stream
+    if (param_ofstream != nullptr) {
+        param_ofstream->close();
+        delete(param_ofstream);
+    }
+
+    return status;
+}
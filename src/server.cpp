@@ -0,0 +1,730 @@
+#include <algorithm>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "data_structures/latency_histogram.hpp"
+#include "filtering/search_quality_metric.hpp"
+#include "utils/cached_filter.hpp"
+#include "utils/cxxopts.hpp"
+#include "utils/protocol.hpp"
+#include "utils/strategies.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/utils.hpp"
+
+
+/**
+ * The filtering pipelines of the server, built once per strategy, k and epsilon on their first request and then
+ * shared by all workers. The metric is initialized once for the greatest k accepted. When a cache is given, the
+ * solutions of the lists are cached by their content, and the repeated lists are not filtered again.
+ */
+template <typename ScoreFun>
+class FilteringService {
+public:
+    /**
+     * Maximum number of distinct pipelines kept by the service
+     */
+    static const std::size_t max_tests = 1024;
+
+    /**
+     * Constructor
+     * @param max_k The greatest k accepted
+     * @param cache The cache of the solutions shared by all pipelines, or nullptr to filter every list
+     * @param max_filter_cells The greatest number of cells of the table of the filter of a list, or zero for no limit
+     */
+    explicit FilteringService(k_type max_k, std::shared_ptr<typename CachedFilter<ScoreFun>::cache_type> cache = nullptr,
+                              std::size_t max_filter_cells = 0) :
+            max_k(max_k),
+            max_filter_cells(max_filter_cells),
+            score_fun(std::make_shared<ScoreFun>(max_k)),
+            cache(std::move(cache)) {
+    }
+
+    /**
+     * Filters the list of a request. It can be called by many threads
+     * @param request The request
+     * @return The response, with a non-zero status if the request is not valid or its list cannot be filtered, e.g.,
+     * because its table exceeds the limit or the memory is exhausted
+     */
+    protocol::Response
+    serve(const protocol::Request &request) {
+        protocol::Response response;
+        response.request_id = request.request_id;
+        try {
+            const CachedFilter<ScoreFun> *cached_filter = nullptr;
+            PrunerFilterCompositionTest<ScoreFun> &test = this->get_test(request, cached_filter);
+            const relevance_type *rel_list = request.relevances.data();
+            const index_type n = static_cast<index_type>(request.relevances.size());
+
+            if (cached_filter != nullptr) {
+                const std::uint64_t start = get_time_nanoseconds();
+                FilterSolution solution = (*cached_filter)(rel_list, n);
+                response.service_time = get_time_nanoseconds() - start;
+                response.score = solution.score;
+                response.indices.assign(solution.indices.begin(), solution.indices.end());
+                return response;
+            }
+
+            // compute min and max elements of the list
+            const std::uint64_t start = get_time_nanoseconds();
+            minmax_type minmax_element;
+            minmax_element.min = minmax_element.max = rel_list[0];
+            for (index_type j = 1; j < n; ++j) {
+                if (rel_list[j] < minmax_element.min) {
+                    minmax_element.min = rel_list[j];
+                } else if (rel_list[j] > minmax_element.max) {
+                    minmax_element.max = rel_list[j];
+                }
+            }
+            TestOutcome outcome = test.run_once(rel_list, n, minmax_element);
+            response.service_time = get_time_nanoseconds() - start;
+            response.score = outcome.score;
+            response.indices.assign(outcome.indices.begin(), outcome.indices.end());
+        } catch (std::exception & e) {
+            response.status = 1;
+            response.error = e.what();
+        }
+        return response;
+    }
+
+    /**
+     * Counters of the cache of the solutions
+     * @return The counters, all zero if there is no cache
+     */
+    CacheStatistics
+    cache_statistics() const {
+        return (this->cache != nullptr) ? this->cache->statistics() : CacheStatistics();
+    }
+
+private:
+    /**
+     * Pipeline of the strategy, k and epsilon of a request, built if needed
+     * @param request The request
+     * @param cached_filter Where to store the cached filter of the pipeline, or nullptr if there is no cache
+     * @return The pipeline
+     * @throws std::runtime_error if the request is not valid
+     */
+    PrunerFilterCompositionTest<ScoreFun> &
+    get_test(const protocol::Request &request, const CachedFilter<ScoreFun> *&cached_filter) {
+        if (request.strategy >= protocol::num_strategies) {
+            throw std::runtime_error("The given strategy is unavailable");
+        }
+        if (request.k == 0 || request.k > this->max_k) {
+            throw std::runtime_error("The parameter k must be between 1 and the max-k of the server");
+        }
+        if (request.relevances.empty()) {
+            throw std::runtime_error("The list is empty");
+        }
+        const std::string strategy = protocol::strategy_codes[request.strategy];
+        const bool use_epsilon = (strategy == "epsfiltering");
+        if (use_epsilon && (request.epsilon <= 0 || request.epsilon >= 1)) {
+            throw std::runtime_error("The parameter epsilon must be between zero and one");
+        }
+        const std::tuple<std::uint8_t, k_type, score_type> key(request.strategy, request.k, use_epsilon ? request.epsilon : 0);
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto it = this->tests.find(key);
+        if (it == this->tests.end()) {
+            if (this->tests.size() >= FilteringService::max_tests) {
+                throw std::runtime_error("Too many distinct strategies, k and epsilon");
+            }
+            std::shared_ptr<Filter<ScoreFun>> &filter = this->filters[request.k];
+            if (filter == nullptr) {
+                filter = std::make_shared<FilterSpirin<ScoreFun>>(request.k, this->score_fun);
+            }
+            it = this->tests.emplace(key, make_strategy_test<ScoreFun>(strategy, this->score_fun, filter, std::get<2>(key), 1)).first;
+            it->second->set_max_filter_cells(this->max_filter_cells);
+            if (this->cache != nullptr) {
+                this->cached_filters.emplace(key, std::make_shared<CachedFilter<ScoreFun>>(it->second, this->cache));
+            }
+        }
+        cached_filter = (this->cache != nullptr) ? this->cached_filters[key].get() : nullptr;
+        return *it->second;
+    }
+
+    const k_type max_k;
+    const std::size_t max_filter_cells;
+    const std::shared_ptr<ScoreFun> score_fun;
+    const std::shared_ptr<typename CachedFilter<ScoreFun>::cache_type> cache;
+    std::mutex mutex;
+    std::map<k_type, std::shared_ptr<Filter<ScoreFun>>> filters;
+    std::map<std::tuple<std::uint8_t, k_type, score_type>, std::shared_ptr<PrunerFilterCompositionTest<ScoreFun>>> tests;
+    std::map<std::tuple<std::uint8_t, k_type, score_type>, std::shared_ptr<CachedFilter<ScoreFun>>> cached_filters;
+};
+
+
+/**
+ * Statistics of the requests served.
+ */
+typedef struct {
+    /**
+     * Number of connections accepted
+     */
+    std::uint64_t num_connections = 0;
+    /**
+     * Number of requests served
+     */
+    std::uint64_t num_requests = 0;
+    /**
+     * Number of requests answered with an error
+     */
+    std::uint64_t num_errors = 0;
+    /**
+     * Sum of the times spent in filtering the lists, in milliseconds
+     */
+    double sum_service_time = 0;
+    /**
+     * Distribution of the times spent in filtering the lists, in nanoseconds
+     */
+    LatencyHistogram service_time;
+} ServerStatistics;
+
+
+/**
+ * Server accepting the filtering requests on a socket. A single thread runs an epoll event loop that accepts the
+ * connections, reads the request frames and writes the response frames, while the requests are filtered by a pool of
+ * workers, which hand the responses back to the event loop through an eventfd. The responses of a connection are
+ * written in the order in which they are completed, thus the clients match them to the requests by their ids.
+ */
+template <typename ScoreFun>
+class FilteringServer {
+public:
+    /**
+     * Constructor
+     * @param service The filtering service
+     * @param listen_fd The listening socket, non-blocking
+     * @param pool The pool of workers
+     * @param signal_mask The signals stopping the server, which must be blocked in all threads
+     */
+    FilteringServer(FilteringService<ScoreFun> &service, int listen_fd, WorkStealingPool &pool, const sigset_t &signal_mask) :
+            service(service),
+            listen_fd(listen_fd),
+            pool(pool),
+            worker_statistics(pool.size()) {
+        this->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        this->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        this->signal_fd = signalfd(-1, &signal_mask, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (this->epoll_fd < 0 || this->event_fd < 0 || this->signal_fd < 0) {
+            throw std::runtime_error(std::string("Unable to create the event loop: ") + std::strerror(errno));
+        }
+        this->watch(this->listen_fd, FilteringServer::listen_tag, EPOLLIN);
+        this->watch(this->event_fd, FilteringServer::completion_tag, EPOLLIN);
+        this->watch(this->signal_fd, FilteringServer::signal_tag, EPOLLIN);
+    }
+
+    FilteringServer(const FilteringServer &) = delete;
+    FilteringServer & operator=(const FilteringServer &) = delete;
+
+    ~FilteringServer() {
+        for (auto &entry: this->connections) {
+            close(entry.second.fd);
+        }
+        close(this->signal_fd);
+        close(this->event_fd);
+        close(this->epoll_fd);
+    }
+
+    /**
+     * Runs the event loop until one of the signals is received, and then drains the server: it stops accepting and
+     * reading, waits for the requests in progress, and writes their responses
+     * @return The statistics of the requests served
+     */
+    ServerStatistics
+    run() {
+        std::vector<epoll_event> events(64);
+        bool stopping = false;
+        while (!stopping) {
+            const int num_events = epoll_wait(this->epoll_fd, events.data(), static_cast<int>(events.size()), -1);
+            if (num_events < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(std::string("Unable to wait for the events: ") + std::strerror(errno));
+            }
+            for (int e = 0; e < num_events; ++e) {
+                const std::uint64_t tag = events[e].data.u64;
+                if (tag == FilteringServer::listen_tag) {
+                    this->accept_connections();
+                } else if (tag == FilteringServer::completion_tag) {
+                    this->deliver_completions();
+                } else if (tag == FilteringServer::signal_tag) {
+                    stopping = true;
+                } else {
+                    auto it = this->connections.find(tag);
+                    if (it != this->connections.end() && (events[e].events & EPOLLOUT)) {
+                        this->write_connection(tag, it->second);
+                        it = this->connections.find(tag);
+                    }
+                    if (it != this->connections.end() && (events[e].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                        this->read_connection(tag, it->second);
+                    }
+                }
+            }
+        }
+        this->drain();
+
+        ServerStatistics statistics = this->statistics;
+        for (const ServerStatistics &worker: this->worker_statistics) {
+            statistics.num_requests += worker.num_requests;
+            statistics.num_errors += worker.num_errors;
+            statistics.sum_service_time += worker.sum_service_time;
+            statistics.service_time.merge(worker.service_time);
+        }
+        return statistics;
+    }
+
+private:
+    /**
+     * State of a connection.
+     */
+    typedef struct {
+        /**
+         * The socket
+         */
+        int fd = -1;
+        /**
+         * Data read and not parsed yet
+         */
+        std::string input;
+        /**
+         * Data to write
+         */
+        std::string output;
+        /**
+         * Number of requests submitted whose response has not been queued yet
+         */
+        std::size_t num_pending = 0;
+        /**
+         * Whether the client has closed its side of the connection
+         */
+        bool read_closed = false;
+        /**
+         * Events of the socket watched by the event loop
+         */
+        std::uint32_t events = 0;
+    } Connection;
+
+    /**
+     * A response ready to be written.
+     */
+    typedef struct {
+        /**
+         * Id of the connection of the request
+         */
+        std::uint64_t connection_id;
+        /**
+         * Frame of the response
+         */
+        std::string frame;
+    } Completion;
+
+    static const std::uint64_t listen_tag = 0;
+    static const std::uint64_t completion_tag = 1;
+    static const std::uint64_t signal_tag = 2;
+    static const std::uint64_t first_connection_id = 16;
+    /**
+     * Maximum time to wait for the clients to accept the responses of the requests in progress at shutdown, in
+     * milliseconds, so that a client not reading cannot hold the server forever
+     */
+    static const int drain_timeout = 5000;
+
+    void
+    watch(int fd, std::uint64_t tag, std::uint32_t events, int operation=EPOLL_CTL_ADD) {
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = events;
+        event.data.u64 = tag;
+        if (epoll_ctl(this->epoll_fd, operation, fd, &event) != 0) {
+            throw std::runtime_error(std::string("Unable to watch a socket: ") + std::strerror(errno));
+        }
+    }
+
+    void
+    accept_connections() {
+        while (true) {
+            const int fd = accept4(this->listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                return;
+            }
+            const int no_delay = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+            const std::uint64_t id = this->next_connection_id++;
+            Connection &connection = this->connections[id];
+            connection.fd = fd;
+            connection.events = EPOLLIN | EPOLLRDHUP;
+            this->watch(fd, id, connection.events);
+            ++this->statistics.num_connections;
+        }
+    }
+
+    void
+    close_connection(std::uint64_t id, Connection &connection) {
+        epoll_ctl(this->epoll_fd, EPOLL_CTL_DEL, connection.fd, nullptr);
+        close(connection.fd);
+        this->connections.erase(id);
+    }
+
+    /**
+     * Closes the connection if it is completed, or updates the events watched: it is read until the client closes its
+     * side, and it is written while some data is left
+     */
+    void
+    update_connection(std::uint64_t id, Connection &connection) {
+        if (connection.read_closed && connection.num_pending == 0 && connection.output.empty()) {
+            this->close_connection(id, connection);
+            return;
+        }
+        const std::uint32_t events = (connection.read_closed ? 0u : static_cast<std::uint32_t>(EPOLLIN | EPOLLRDHUP)) | (connection.output.empty() ? 0u : static_cast<std::uint32_t>(EPOLLOUT));
+        if (events != connection.events) {
+            this->watch(connection.fd, id, events, EPOLL_CTL_MOD);
+            connection.events = events;
+        }
+    }
+
+    void
+    read_connection(std::uint64_t id, Connection &connection) {
+        char buffer[65536];
+        while (!connection.read_closed) {
+            const ssize_t result = recv(connection.fd, buffer, sizeof(buffer), 0);
+            if (result > 0) {
+                connection.input.append(buffer, static_cast<std::size_t>(result));
+            } else if (result == 0) {
+                connection.read_closed = true;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else {
+                this->close_connection(id, connection);
+                return;
+            }
+        }
+
+        // submit the complete frames to the workers
+        std::size_t offset = 0;
+        while (connection.input.size() - offset >= sizeof(std::uint32_t)) {
+            const std::uint32_t length = protocol::read_value<std::uint32_t>(connection.input.data() + offset);
+            if (length > protocol::max_frame_size) {
+                this->close_connection(id, connection);
+                return;
+            }
+            if (connection.input.size() - offset - sizeof(std::uint32_t) < length) {
+                break;
+            }
+            std::shared_ptr<std::string> payload = std::make_shared<std::string>(connection.input, offset + sizeof(std::uint32_t), length);
+            offset += sizeof(std::uint32_t) + length;
+            ++connection.num_pending;
+            this->pool.submit([this, id, payload](std::size_t worker_id) {
+                this->process_request(id, *payload, worker_id);
+            });
+        }
+        connection.input.erase(0, offset);
+        this->update_connection(id, connection);
+    }
+
+    void
+    write_connection(std::uint64_t id, Connection &connection) {
+        std::size_t written = 0;
+        while (written < connection.output.size()) {
+            const ssize_t result = send(connection.fd, connection.output.data() + written, connection.output.size() - written, MSG_NOSIGNAL);
+            if (result > 0) {
+                written += static_cast<std::size_t>(result);
+            } else if (result < 0 && errno == EINTR) {
+                continue;
+            } else if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                this->close_connection(id, connection);
+                return;
+            }
+        }
+        connection.output.erase(0, written);
+        this->update_connection(id, connection);
+    }
+
+    /**
+     * Stops accepting and reading, waits for the requests in progress, and writes all the responses, until every
+     * connection is completed or fails, or the clients stop accepting data for drain_timeout milliseconds
+     */
+    void
+    drain() {
+        epoll_ctl(this->epoll_fd, EPOLL_CTL_DEL, this->listen_fd, nullptr);
+        epoll_ctl(this->epoll_fd, EPOLL_CTL_DEL, this->signal_fd, nullptr);
+        this->pool.wait();
+
+        // no more requests are read, thus a connection is closed as soon as its responses are written
+        std::vector<std::uint64_t> ids;
+        for (auto &entry: this->connections) {
+            entry.second.read_closed = true;
+            ids.push_back(entry.first);
+        }
+        this->deliver_completions();
+        for (std::uint64_t id: ids) {
+            auto it = this->connections.find(id);
+            if (it != this->connections.end()) {
+                this->update_connection(id, it->second);
+            }
+        }
+
+        std::vector<epoll_event> events(64);
+        while (!this->connections.empty()) {
+            const int num_events = epoll_wait(this->epoll_fd, events.data(), static_cast<int>(events.size()), FilteringServer::drain_timeout);
+            if (num_events < 0 && errno == EINTR) {
+                continue;
+            }
+            if (num_events <= 0) {
+                break;
+            }
+            for (int e = 0; e < num_events; ++e) {
+                const std::uint64_t tag = events[e].data.u64;
+                auto it = this->connections.find(tag);
+                if (it == this->connections.end()) {
+                    continue;
+                }
+                if (events[e].events & (EPOLLHUP | EPOLLERR)) {
+                    this->close_connection(tag, it->second);
+                } else if (events[e].events & EPOLLOUT) {
+                    this->write_connection(tag, it->second);
+                }
+            }
+        }
+    }
+
+    /**
+     * Body of the task of a worker: decodes the request, filters the list and hands the response to the event loop
+     */
+    void
+    process_request(std::uint64_t connection_id, const std::string &payload, std::size_t worker_id) {
+        ServerStatistics &statistics = this->worker_statistics[worker_id];
+        protocol::Response response;
+        try {
+            protocol::Request request;
+            protocol::decode_request(payload.data(), payload.size(), request);
+            response = this->service.serve(request);
+        } catch (std::exception & e) {
+            response.request_id = (payload.size() >= sizeof(std::uint32_t)) ? protocol::read_value<std::uint32_t>(payload.data()) : 0;
+            response.status = 1;
+            response.error = e.what();
+        }
+        ++statistics.num_requests;
+        if (response.status != 0) {
+            ++statistics.num_errors;
+        } else {
+            statistics.sum_service_time += response.service_time / 1e6;
+            statistics.service_time.record(response.service_time);
+        }
+
+        Completion completion;
+        completion.connection_id = connection_id;
+        protocol::encode_response(completion.frame, response);
+        {
+            std::lock_guard<std::mutex> lock(this->completions_mutex);
+            this->completions.push_back(std::move(completion));
+        }
+        const std::uint64_t one = 1;
+        while (write(this->event_fd, &one, sizeof(one)) < 0 && errno == EINTR) {
+        }
+    }
+
+    void
+    deliver_completions() {
+        std::uint64_t counter;
+        while (read(this->event_fd, &counter, sizeof(counter)) < 0 && errno == EINTR) {
+        }
+        std::vector<Completion> completed;
+        {
+            std::lock_guard<std::mutex> lock(this->completions_mutex);
+            completed.swap(this->completions);
+        }
+        std::vector<std::uint64_t> touched;
+        for (Completion &completion: completed) {
+            auto it = this->connections.find(completion.connection_id);
+            if (it == this->connections.end()) {
+                // the connection has been closed in the meanwhile
+                continue;
+            }
+            if (it->second.output.empty()) {
+                touched.push_back(completion.connection_id);
+            }
+            it->second.output.append(completion.frame);
+            --it->second.num_pending;
+        }
+        for (std::uint64_t id: touched) {
+            auto it = this->connections.find(id);
+            if (it != this->connections.end()) {
+                this->write_connection(id, it->second);
+            }
+        }
+    }
+
+    FilteringService<ScoreFun> &service;
+    const int listen_fd;
+    WorkStealingPool &pool;
+    int epoll_fd = -1;
+    int event_fd = -1;
+    int signal_fd = -1;
+    std::uint64_t next_connection_id = FilteringServer::first_connection_id;
+    std::unordered_map<std::uint64_t, Connection> connections;
+    std::mutex completions_mutex;
+    std::vector<Completion> completions;
+    ServerStatistics statistics;
+    std::vector<ServerStatistics> worker_statistics;
+};
+
+
+template <typename ScoreFun>
+int
+server(
+        const cxxopts::ParseResult &arguments
+) {
+    // parameters
+    const std::string param_socket_path = arguments.count("socket") ? arguments["socket"].as<std::string>() : std::string();
+    const int param_port = arguments["port"].as<int>();
+    const int param_max_k = arguments["max-k"].as<int>();
+    const int param_num_threads = arguments["threads"].as<int>();
+    const double param_cache_mb = arguments["cache-mb"].as<double>();
+    const double param_max_table_mb = arguments["max-table-mb"].as<double>();
+    std::vector<int> param_cpu_list;
+    std::ofstream * param_ofstream = nullptr;
+
+    // check the command line parameters
+    try {
+        if (param_socket_path.empty() && (param_port <= 0 || param_port > 65535)) {
+            throw std::runtime_error("Either the parameter socket or a port between 1 and 65535 is required");
+        }
+        if (param_max_k <= 0 || param_max_k > 65535) {
+            throw std::runtime_error("The parameter max-k must be a number between 1 and 65535");
+        }
+        if (param_num_threads <= 0) {
+            throw std::runtime_error("The parameter threads must be a number strictly greater than 0");
+        }
+        if (param_cache_mb < 0) {
+            throw std::runtime_error("The parameter cache-mb must be a number greater or equal than 0");
+        }
+        if (param_max_table_mb < 0) {
+            throw std::runtime_error("The parameter max-table-mb must be a number greater or equal than 0");
+        }
+
+        // param cpu list
+        if (arguments.count("cpu-list")) {
+            param_cpu_list = read_parameter_list<int>(arguments["cpu-list"].as<std::string>());
+            if (!param_cpu_list.empty() && param_cpu_list.size() < static_cast<std::size_t>(param_num_threads)) {
+                throw std::runtime_error("The parameter cpu-list must contain at least one cpu per thread");
+            }
+        }
+
+        // param output
+        if (arguments.count("output")) {
+            std::string output_file_path = arguments["output"].as<std::string>();
+            param_ofstream = new std::ofstream(output_file_path);
+            if (!param_ofstream->is_open()) {
+                throw std::runtime_error(std::string("Unable to open the output file ") + output_file_path);
+            }
+        }
+    } catch (std::runtime_error & e) {
+        std::cerr << e.what() << "." << std::endl;
+        return -1;
+    }
+
+    // the signals stopping the server are blocked in all threads, and received by the event loop
+    sigset_t signal_mask;
+    sigemptyset(&signal_mask);
+    sigaddset(&signal_mask, SIGINT);
+    sigaddset(&signal_mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signal_mask, nullptr);
+
+    std::shared_ptr<typename CachedFilter<ScoreFun>::cache_type> cache;
+    if (param_cache_mb > 0) {
+        cache = std::make_shared<typename CachedFilter<ScoreFun>::cache_type>(static_cast<std::size_t>(param_cache_mb * 1024 * 1024));
+    }
+    const std::size_t max_filter_cells = static_cast<std::size_t>(param_max_table_mb * 1024 * 1024 / sizeof(score_type));
+    FilteringService<ScoreFun> service(static_cast<k_type>(param_max_k), cache, max_filter_cells);
+    const int listen_fd = protocol::listen_socket(param_socket_path, param_port);
+    ServerStatistics statistics;
+    {
+        WorkStealingPool pool(param_num_threads, param_cpu_list);
+        FilteringServer<ScoreFun> filtering_server(service, listen_fd, pool, signal_mask);
+        std::cerr << "Listening on " << (param_socket_path.empty() ? "127.0.0.1:" + std::to_string(param_port) : param_socket_path) << std::endl;
+        statistics = filtering_server.run();
+    }
+    close(listen_fd);
+    if (!param_socket_path.empty()) {
+        unlink(param_socket_path.c_str());
+    }
+
+    // WRITE the statistics
+    std::ostream & ostream = (param_ofstream != nullptr) ? *param_ofstream : std::cout;
+    const std::uint64_t num_served = statistics.num_requests - statistics.num_errors;
+    ostream << "{\"connections\": " << statistics.num_connections;
+    ostream << ", \"requests\": " << statistics.num_requests;
+    ostream << ", \"errors\": " << statistics.num_errors;
+    ostream << ", \"avg_service_time\": " << ((num_served > 0) ? statistics.sum_service_time / num_served : 0.0);
+    ostream << ", \"service_time_percentiles\": "; TestsAggregationOutcome::write_percentiles(ostream, statistics.service_time);
+    if (cache != nullptr) {
+        ostream << ", \"cache\": " << service.cache_statistics();
+    }
+    ostream << "}" << std::endl;
+
+    // close the file output stream
+    if (param_ofstream != nullptr) {
+        param_ofstream->close();
+        delete(param_ofstream);
+    }
+
+    return 0;
+}
+
+
+int main(int argc, char *argv[]) {
+    // command line options
+    cxxopts::Options options(argv[0], "Serves the filtering requests received on a Unix domain socket or on a local TCP port until it is interrupted");
+    options
+            .add_options()
+            ("h, help", "Print this help message")
+            ("m, metric", "The search quality metric to use. Available options are: dcg, dcglz", cxxopts::value<std::string>()->default_value("dcg"))
+            ("socket", "Path of the Unix domain socket where to listen", cxxopts::value<std::string>())
+            ("port", "TCP port of the loopback interface where to listen, if no socket is given", cxxopts::value<int>()->default_value("0"))
+            ("max-k", "Greatest k accepted, for which the metric is initialized", cxxopts::value<int>()->default_value("1000"))
+            ("t, threads", "Number of workers filtering the lists", cxxopts::value<int>()->default_value("1"))
+            ("cpu-list", "Comma separated list of cpus where to pin the workers, one per worker", cxxopts::value<std::string>())
+            ("max-table-mb", "Greatest memory of the table of the filter of a list, in megabytes, above which the request is rejected, or 0 for no limit", cxxopts::value<double>()->default_value("1024"))
+            ("cache-mb", "Memory of the cache of the solutions of the repeated lists, in megabytes, or 0 to disable it", cxxopts::value<double>()->default_value("0"))
+            ("o, output", "Write the statistics of the requests served to FILE instead of standard output", cxxopts::value<std::string>());
+
+    // command line parsing
+    cxxopts::ParseResult arguments = options.parse(argc, argv);
+
+    // help
+    if (arguments.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    // call the templated proxy based on the selected metric function
+    std::string param_metric = arguments["metric"].as<std::string>();
+    try {
+        if (param_metric == "dcg") {
+            return server<dcg_metric>(arguments);
+        } else if (param_metric == "dcglz") {
+            return server<dcglz_metric>(arguments);
+        } else {
+            std::cerr << "The given metric is unavailable." << std::endl;
+            return -1;
+        }
+    } catch (std::exception & e) {
+        std::cerr << e.what() << "." << std::endl;
+        return -1;
+    }
+}
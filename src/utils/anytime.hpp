@@ -0,0 +1,280 @@
+#ifndef UTILS_ANYTIME_HPP
+#define UTILS_ANYTIME_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+#include "../filtering/filter.hpp"
+#include "../filtering/pruner.hpp"
+#include "../filtering/types.hpp"
+#include "../filtering/workspace.hpp"
+#include "../pruners/pruner_epspruning.hpp"
+#include "../pruners/pruner_topk.hpp"
+#include "utils.hpp"
+
+
+/**
+ * Outcome of an anytime filtering, i.e., the best solution found before the deadline and its guarantee.
+ */
+typedef struct anytime_solution {
+    /**
+     * The best solution found
+     */
+    FilterSolution solution;
+    /**
+     * Approximation factor proven for the solution, i.e., its score is at least (1 - epsilon) times the optimal one
+     */
+    score_type epsilon = 1;
+    /**
+     * Number of stages completed
+     */
+    std::size_t num_stages = 0;
+    /**
+     * Whether the schedule was interrupted because its next stage would have exceeded the deadline
+     */
+    bool deadline_reached = false;
+    /**
+     * Time elapsed from the beginning of the filtering, in milliseconds
+     */
+    double elapsed_time = 0;
+
+    /**
+     * Writes on the output stream a json representation of the outcome, without the indices of the solution
+     * @param os the output stream where to write
+     * @param outcome the outcome to write
+     * @return the output stream
+     */
+    friend std::ostream & operator<<(std::ostream &os, const struct anytime_solution &outcome) {
+        os << "{";
+        os << "\"score\": " << outcome.solution.score;
+        os << ", \"num_elements\": " << outcome.solution.size();
+        os << ", \"epsilon\": " << outcome.epsilon;
+        os << ", \"num_stages\": " << outcome.num_stages;
+        os << ", \"deadline_reached\": " << (outcome.deadline_reached ? "true" : "false");
+        os << ", \"elapsed_time\": " << outcome.elapsed_time;
+        os << "}";
+        return os;
+    }
+} AnytimeSolution;
+
+
+/**
+ * Filtering within a time budget, which refines its solution while time remains.
+ * The first stage is Topk-OPT, which is fast and 0.5-optimal. Each of the next stages prunes the list with
+ * PrunerEpsPruning and an epsilon smaller by epsilon_ratio, down to epsilon_min, and the last one runs the optimal
+ * filter on the whole list when epsilon_min is zero. The best solution found is returned with the smallest epsilon
+ * proven by the stages completed; a stage keeping every element of the list proves the optimality.
+ * The stages cannot be interrupted, thus a stage starts only if its estimated time fits the remaining budget: the
+ * pruning is estimated from the previous one, and the filtering from the time per cell of the previous one, knowing
+ * the number of elements not pruned and charging more the cells that the workspace must allocate. The first stage
+ * always runs.
+ * It keeps no state between the calls, thus it can be used by many threads at the same time, provided that each
+ * thread passes its own workspace.
+ * @tparam ScoreFun Score function type
+ */
+template <typename ScoreFun>
+class AnytimeFilter {
+public:
+    /**
+     * Smallest epsilon pruned before the optimal filter, when epsilon_min is zero
+     */
+    static constexpr double finest_epsilon = 1.0 / 1024;
+
+    /**
+     * Cost of a cell of the table of the filter not yet allocated in the workspace, relative to a cell already
+     * allocated, i.e., the cost of its first touch
+     */
+    static constexpr double growth_cost = 4;
+
+    /**
+     * Constructor
+     * @param score_fun Score function used to score the solutions
+     * @param filter The optimal filter@k run at every stage
+     * @param epsilon_min The approximation factor of the last stage, or zero to end with the optimal filter; from 0.5
+     *                    on, only the first stage runs
+     * @param epsilon_ratio The ratio between the approximation factors of consecutive stages, in (0, 1)
+     */
+    AnytimeFilter(const std::shared_ptr<ScoreFun> score_fun, const std::shared_ptr<Filter<ScoreFun>> filter,
+                  score_type epsilon_min=0, score_type epsilon_ratio=0.5) :
+            filter(filter),
+            topk_pruner(std::make_shared<PrunerTopk<ScoreFun>>(score_fun, filter->k)),
+            exact(epsilon_min == 0) {
+        if (!(epsilon_min >= 0 && epsilon_min < 1)) {
+            throw std::invalid_argument("The parameter epsilon_min must be in [0, 1)");
+        }
+        if (!(epsilon_ratio > 0 && epsilon_ratio < 1)) {
+            throw std::invalid_argument("The parameter epsilon_ratio must be between zero and one");
+        }
+        for (double epsilon = 0.5 * epsilon_ratio;
+             epsilon > epsilon_min && epsilon >= AnytimeFilter::finest_epsilon; epsilon *= epsilon_ratio) {
+            this->eps_pruners.push_back(std::make_shared<PrunerEpsPruning<ScoreFun>>(score_fun, filter->k, epsilon));
+        }
+        if (epsilon_min > 0 && epsilon_min < 0.5) {
+            this->eps_pruners.push_back(std::make_shared<PrunerEpsPruning<ScoreFun>>(score_fun, filter->k, epsilon_min));
+        }
+    }
+
+    /**
+     * Filters the given list within a time budget, reusing the buffers of the given workspace
+     * @param rel_list List containing the relevance scores, ordered according to some attribute
+     * @param n Number of elements of rel_list
+     * @param budget The time budget, in milliseconds
+     * @param workspace The workspace of the calling thread
+     * @return The best solution found, whose indices refer to the elements of the list, and its guarantee
+     */
+    AnytimeSolution
+    operator()(const relevance_type * rel_list, const index_type n, double budget, Workspace &workspace) const {
+        const std::uint64_t start = get_time_nanoseconds();
+        const std::uint64_t deadline = start + static_cast<std::uint64_t>(std::max(budget, 0.0) * 1e6);
+        AnytimeSolution outcome;
+        if (n == 0) {
+            outcome.epsilon = 0;
+            return outcome;
+        }
+
+        // compute min and max elements of the list
+        minmax_type minmax_element;
+        minmax_element.min = minmax_element.max = rel_list[0];
+        for (index_type j = 1; j < n; ++j) {
+            if (rel_list[j] < minmax_element.min) {
+                minmax_element.min = rel_list[j];
+            } else if (rel_list[j] > minmax_element.max) {
+                minmax_element.max = rel_list[j];
+            }
+        }
+
+        // first stage, always run
+        double pruning_time = 0;
+        double filtering_time_per_cell = 0;
+        if (this->run_stage(*this->topk_pruner, 0.5, rel_list, n, minmax_element, workspace, outcome, pruning_time, filtering_time_per_cell)) {
+            outcome.elapsed_time = get_elapsed_milliseconds(start, get_time_nanoseconds());
+            return outcome;
+        }
+
+        // refinement stages
+        for (const std::shared_ptr<PrunerEpsPruning<ScoreFun>> &pruner: this->eps_pruners) {
+            if (get_time_nanoseconds() + static_cast<std::uint64_t>(pruning_time * 1e6) > deadline) {
+                outcome.deadline_reached = true;
+                break;
+            }
+            if (this->run_stage(*pruner, pruner->epsilon, rel_list, n, minmax_element, workspace, outcome, pruning_time, filtering_time_per_cell, deadline)) {
+                break;
+            }
+        }
+
+        // last stage, the optimal filter on the whole list
+        if (this->exact && outcome.epsilon > 0 && !outcome.deadline_reached) {
+            if (get_time_nanoseconds() + estimate_filtering_time(n, filtering_time_per_cell, workspace) > deadline) {
+                outcome.deadline_reached = true;
+            } else {
+                this->keep_best(this->filter->operator()(rel_list, n, workspace), 0, outcome);
+            }
+        }
+        outcome.elapsed_time = get_elapsed_milliseconds(start, get_time_nanoseconds());
+        return outcome;
+    }
+
+    /**
+     * Filters the given list within a time budget
+     * @param rel_list List containing the relevance scores, ordered according to some attribute
+     * @param n Number of elements of rel_list
+     * @param budget The time budget, in milliseconds
+     * @return The best solution found, whose indices refer to the elements of the list, and its guarantee
+     */
+    AnytimeSolution
+    operator()(const relevance_type * rel_list, const index_type n, double budget) const {
+        Workspace workspace;
+        return this->operator()(rel_list, n, budget, workspace);
+    }
+
+private:
+    /**
+     * Runs a stage, i.e., prunes the list, filters the elements not pruned if the filtering fits the deadline, and
+     * keeps the solution if it is the best one
+     * @param pruner The pruner of the stage
+     * @param epsilon The approximation factor guaranteed by the pruner
+     * @param rel_list List containing the relevance scores, ordered according to some attribute
+     * @param n Number of elements of rel_list
+     * @param minmax_element The min and maximum elements of the list
+     * @param workspace The workspace of the calling thread
+     * @param outcome The outcome to update
+     * @param pruning_time The time of the pruning, updated
+     * @param filtering_time_per_cell The time of the filtering per element not pruned and per unit of k, updated
+     * @param deadline The deadline of the filtering, in nanoseconds, or zero for the first stage
+     * @return True if the solution has been proven optimal, thus no further stage is needed
+     */
+    bool
+    run_stage(const Pruner<ScoreFun> &pruner, score_type epsilon, const relevance_type * rel_list, const index_type n,
+              const minmax_type &minmax_element, Workspace &workspace, AnytimeSolution &outcome,
+              double &pruning_time, double &filtering_time_per_cell, std::uint64_t deadline=0) const {
+        std::uint64_t start = get_time_nanoseconds();
+        const PrunerSolution pruningSolution = pruner(rel_list, n, minmax_element);
+        std::uint64_t end = get_time_nanoseconds();
+        pruning_time = get_elapsed_milliseconds(start, end);
+
+        // a pruning keeping every element makes the stage the optimal filter
+        const index_type n2 = pruningSolution.size();
+        if (deadline > 0 && end + estimate_filtering_time(n2, filtering_time_per_cell, workspace) > deadline) {
+            outcome.deadline_reached = true;
+            return true;
+        }
+
+        start = get_time_nanoseconds();
+        workspace.relevances.resize(n2);
+        for (index_type i = 0; i < n2; ++i) {
+            workspace.relevances[i] = rel_list[pruningSolution.indices[i]];
+        }
+        FilterSolution filteringSolution = this->filter->operator()(workspace.relevances.data(), n2, workspace);
+        for (index_type i = 0, i_end = filteringSolution.size(); i < i_end; ++i) {
+            filteringSolution.indices[i] = pruningSolution.indices[filteringSolution.indices[i]];
+        }
+        const double num_cells = static_cast<double>(n2) * this->filter->k;
+        filtering_time_per_cell = get_elapsed_milliseconds(start, get_time_nanoseconds()) / std::max(num_cells, 1.0);
+
+        const bool optimal = (n2 == n);
+        this->keep_best(std::move(filteringSolution), optimal ? 0 : epsilon, outcome);
+        return optimal;
+    }
+
+    /**
+     * Estimates the time of the filtering of a list
+     * @param n Number of elements of the list
+     * @param filtering_time_per_cell The time of the filtering per element and per unit of k, in milliseconds
+     * @param workspace The workspace of the calling thread
+     * @return The estimated time, in nanoseconds
+     */
+    std::uint64_t
+    estimate_filtering_time(index_type n, double filtering_time_per_cell, const Workspace &workspace) const {
+        const double num_cells = static_cast<double>(n) * this->filter->k;
+        const double num_new_cells = std::max(num_cells - static_cast<double>(workspace.table.size()), 0.0);
+        return static_cast<std::uint64_t>(filtering_time_per_cell * (num_cells + (AnytimeFilter::growth_cost - 1) * num_new_cells) * 1e6);
+    }
+
+    /**
+     * Keeps the given solution if it is better than the one of the outcome, and updates the guarantee of the outcome,
+     * i.e., the smallest approximation factor proven so far
+     * @param solution The solution of a stage
+     * @param epsilon The approximation factor guaranteed by the stage
+     * @param outcome The outcome to update
+     */
+    static void
+    keep_best(FilterSolution &&solution, score_type epsilon, AnytimeSolution &outcome) {
+        if (outcome.num_stages == 0 || solution.score > outcome.solution.score) {
+            outcome.solution = std::move(solution);
+        }
+        outcome.epsilon = std::min(outcome.epsilon, epsilon);
+        ++outcome.num_stages;
+    }
+
+private:
+    const std::shared_ptr<Filter<ScoreFun>> filter;
+    const std::shared_ptr<PrunerTopk<ScoreFun>> topk_pruner;
+    std::vector<std::shared_ptr<PrunerEpsPruning<ScoreFun>>> eps_pruners;
+    const bool exact;
+};
+
+
+#endif //UTILS_ANYTIME_HPP
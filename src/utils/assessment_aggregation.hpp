@@ -0,0 +1,673 @@
+#ifndef UTILS_ASSESSMENT_AGGREGATION_HPP
+#define UTILS_ASSESSMENT_AGGREGATION_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "composition.hpp"
+#include "json.hpp"
+
+
+/**
+ * Configuration of an assessment, needed to interpret its aggregation.
+ */
+typedef struct {
+    /**
+     * Name of the search quality metric
+     */
+    std::string metric;
+    /**
+     * Values of n_cut, in the order used by the aggregation
+     */
+    std::vector<index_type> n_cut_list;
+    /**
+     * Values of k, in the order used by the aggregation
+     */
+    std::vector<k_type> k_list;
+    /**
+     * Names of the tests performed for each pair (n_cut, k). The first one is the optimal test
+     */
+    std::vector<std::string> test_names;
+    /**
+     * Whether the report contains the average list length and the throughput of each test
+     */
+    bool report_throughput = false;
+} AssessmentConfiguration;
+
+
+/**
+ * Estimate of a mean from a sample of the lists, with the half width of its confidence interval.
+ */
+typedef struct {
+    /**
+     * Estimate of the mean
+     */
+    double estimate = 0;
+    /**
+     * Half width of the confidence interval of the mean
+     */
+    double half_width = 0;
+} IntervalEstimate;
+
+
+/**
+ * Estimates of the means of the measures of a test with a pair (n_cut, k), from a sample of the lists.
+ */
+typedef struct {
+    /**
+     * Estimate of the average score
+     */
+    IntervalEstimate score;
+    /**
+     * Estimate of the average approximation error
+     */
+    IntervalEstimate approximation_error;
+    /**
+     * Estimate of the average total time
+     */
+    IntervalEstimate total_time;
+} TestEstimates;
+
+
+/**
+ * Aggregation of the outcomes of all tests performed during an assessment, for every pair (n_cut, k).
+ * Each pair has the aggregation of the optimal test and one aggregation for each of the other tests.
+ */
+class AssessmentAggregation {
+public:
+    /**
+     * Constructor of an empty aggregation
+     * @param n_cut_list_size Number of values of n_cut
+     * @param k_list_size Number of values of k
+     * @param num_tests Number of tests performed for each pair (n_cut, k), excluding the optimal one
+     */
+    AssessmentAggregation(std::size_t n_cut_list_size, std::size_t k_list_size, std::size_t num_tests) :
+            n_cut_list_size(n_cut_list_size),
+            k_list_size(k_list_size),
+            num_tests(num_tests),
+            num_lists_assessed_(n_cut_list_size * k_list_size, 0),
+            sum_reading_time_(n_cut_list_size * k_list_size),
+            sum_list_length_(n_cut_list_size * k_list_size, 0.0),
+            outcomes_(n_cut_list_size * k_list_size * (num_tests + 1)) {
+    }
+
+    /**
+     * Number of lists assessed with the given pair (n_cut, k)
+     */
+    std::size_t &
+    num_lists_assessed(std::size_t ni, std::size_t ki) {
+        return this->num_lists_assessed_[ni * this->k_list_size + ki];
+    }
+
+    std::size_t
+    num_lists_assessed(std::size_t ni, std::size_t ki) const {
+        return this->num_lists_assessed_[ni * this->k_list_size + ki];
+    }
+
+    /**
+     * Sum of the times spent in reading the lists assessed with the given pair (n_cut, k)
+     */
+    CompensatedSum &
+    sum_reading_time(std::size_t ni, std::size_t ki) {
+        return this->sum_reading_time_[ni * this->k_list_size + ki];
+    }
+
+    double
+    sum_reading_time(std::size_t ni, std::size_t ki) const {
+        return this->sum_reading_time_[ni * this->k_list_size + ki].value();
+    }
+
+    /**
+     * Average time spent in reading the lists assessed with the given pair (n_cut, k)
+     */
+    double
+    avg_reading_time(std::size_t ni, std::size_t ki) const {
+        std::size_t num_lists = this->num_lists_assessed(ni, ki);
+        return (num_lists > 0) ? this->sum_reading_time(ni, ki) / num_lists : 0.0;
+    }
+
+    /**
+     * Sum of the lengths of the lists assessed with the given pair (n_cut, k), after the cut
+     */
+    double &
+    sum_list_length(std::size_t ni, std::size_t ki) {
+        return this->sum_list_length_[ni * this->k_list_size + ki];
+    }
+
+    double
+    sum_list_length(std::size_t ni, std::size_t ki) const {
+        return this->sum_list_length_[ni * this->k_list_size + ki];
+    }
+
+    /**
+     * Average length of the lists assessed with the given pair (n_cut, k), after the cut
+     */
+    double
+    avg_list_length(std::size_t ni, std::size_t ki) const {
+        std::size_t num_lists = this->num_lists_assessed(ni, ki);
+        return (num_lists > 0) ? this->sum_list_length(ni, ki) / num_lists : 0.0;
+    }
+
+    /**
+     * Aggregation of the optimal test with the given pair (n_cut, k)
+     */
+    TestsAggregationOutcome &
+    outcome_opt(std::size_t ni, std::size_t ki) {
+        return this->outcomes_[(ni * this->k_list_size + ki) * (this->num_tests + 1)];
+    }
+
+    const TestsAggregationOutcome &
+    outcome_opt(std::size_t ni, std::size_t ki) const {
+        return this->outcomes_[(ni * this->k_list_size + ki) * (this->num_tests + 1)];
+    }
+
+    /**
+     * Aggregation of the j-th test with the given pair (n_cut, k)
+     */
+    TestsAggregationOutcome &
+    outcome(std::size_t ni, std::size_t ki, std::size_t j) {
+        return this->outcomes_[(ni * this->k_list_size + ki) * (this->num_tests + 1) + 1 + j];
+    }
+
+    const TestsAggregationOutcome &
+    outcome(std::size_t ni, std::size_t ki, std::size_t j) const {
+        return this->outcomes_[(ni * this->k_list_size + ki) * (this->num_tests + 1) + 1 + j];
+    }
+
+    /**
+     * Merges another aggregation into this one
+     * @param other The aggregation to merge, which must have the same shape of this one
+     */
+    void
+    merge(const AssessmentAggregation &other) {
+        if (other.n_cut_list_size != this->n_cut_list_size || other.k_list_size != this->k_list_size ||
+            other.num_tests != this->num_tests) {
+            throw std::invalid_argument("Unable to merge two aggregations having different shapes");
+        }
+        for (std::size_t i = 0, i_end = this->num_lists_assessed_.size(); i < i_end; ++i) {
+            this->num_lists_assessed_[i] += other.num_lists_assessed_[i];
+            this->sum_reading_time_[i].merge(other.sum_reading_time_[i]);
+            this->sum_list_length_[i] += other.sum_list_length_[i];
+        }
+        for (std::size_t i = 0, i_end = this->outcomes_.size(); i < i_end; ++i) {
+            this->outcomes_[i].merge(other.outcomes_[i]);
+        }
+        this->peak_rss_bytes = std::max(this->peak_rss_bytes, other.peak_rss_bytes);
+    }
+
+public:
+    const std::size_t n_cut_list_size;
+    const std::size_t k_list_size;
+    const std::size_t num_tests;
+
+    /**
+     * Peak resident set size of the processes performing the assessment, in bytes, or zero if not collected
+     */
+    std::int64_t peak_rss_bytes = 0;
+
+private:
+    std::vector<std::size_t> num_lists_assessed_;
+    std::vector<CompensatedSum> sum_reading_time_;
+    std::vector<double> sum_list_length_;
+    std::vector<TestsAggregationOutcome> outcomes_;
+};
+
+
+/**
+ * Writes the json report of the assessment
+ * @param os The output stream where to write
+ * @param config The configuration of the assessment
+ * @param aggregation The aggregation of the outcomes of all tests
+ * @param estimates The estimates of each test with each pair (n_cut, k), in the order of the aggregation, when the
+ * lists have been sampled, or nullptr
+ */
+inline void
+write_assessment_report(
+        std::ostream &os,
+        const AssessmentConfiguration &config,
+        const AssessmentAggregation &aggregation,
+        const std::vector<TestEstimates> *estimates = nullptr
+) {
+    const std::size_t n_cut_list_size = config.n_cut_list.size();
+    const std::size_t k_list_size = config.k_list.size();
+
+    os << "[" << std::endl;
+    // loop over the different cuts of n
+    for (std::size_t ni = 0; ni < n_cut_list_size; ++ni) {
+        // loop over the different values of k
+        for (std::size_t ki = 0; ki < k_list_size; ++ki) {
+            // skip the combination n_cut smaller than k
+            if (config.n_cut_list[ni] > 0 && config.k_list[ki] > config.n_cut_list[ni]) {
+                continue;
+            }
+
+            os << "{" << std::endl;
+            os << "\t\"n_cut\": " << config.n_cut_list[ni];
+            os << ", \"k\": " << config.k_list[ki];
+            os << ", \"avg_reading_time\": " << aggregation.avg_reading_time(ni, ki);
+            os << ", \"num_lists_assessed\": " << aggregation.num_lists_assessed(ni, ki);
+            if (aggregation.peak_rss_bytes > 0) {
+                os << ", \"peak_rss_bytes\": " << aggregation.peak_rss_bytes;
+            }
+            if (config.report_throughput) {
+                // elements processed per second by each test
+                os << ", \"avg_list_length\": " << aggregation.avg_list_length(ni, ki);
+                os << ", \"throughput\": {";
+                for (std::size_t t = 0; t <= aggregation.num_tests; ++t) {
+                    const TestsAggregationOutcome &outcome = (t == 0) ? aggregation.outcome_opt(ni, ki) : aggregation.outcome(ni, ki, t - 1);
+                    // the lists not timed (found in the OPT cache) are excluded
+                    const double throughput = (outcome.total_time.sum() > 0) ? aggregation.avg_list_length(ni, ki) * outcome.total_time.count() / outcome.total_time.sum() * 1000 : 0.0;
+                    os << ((t > 0) ? ", " : "") << "\"" << config.test_names[t] << "\": " << throughput;
+                }
+                os << "}";
+            }
+            if (estimates != nullptr) {
+                // estimates of the means and half widths of their confidence intervals
+                os << ", \"estimates\": {";
+                for (std::size_t t = 0; t <= aggregation.num_tests; ++t) {
+                    const TestEstimates &test_estimates = (*estimates)[(ni * k_list_size + ki) * (aggregation.num_tests + 1) + t];
+                    os << ((t > 0) ? "," : "") << std::endl << "\t\t\"" << config.test_names[t] << "\": {";
+                    os << "\"avg_score\": " << test_estimates.score.estimate;
+                    os << ", \"avg_score_ci\": " << test_estimates.score.half_width;
+                    os << ", \"avg_approximation_error\": " << test_estimates.approximation_error.estimate;
+                    os << ", \"avg_approximation_error_ci\": " << test_estimates.approximation_error.half_width;
+                    os << ", \"avg_total_time\": " << test_estimates.total_time.estimate;
+                    os << ", \"avg_total_time_ci\": " << test_estimates.total_time.half_width;
+                    os << "}";
+                }
+                os << std::endl << "\t}";
+            }
+            os << ", \"strategies\": {";
+
+            // optimal filtering
+            os << std::endl << "\t\t\"" << config.test_names[0] << "\": " << aggregation.outcome_opt(ni, ki);
+            // all others
+            for (std::size_t j = 0; j < aggregation.num_tests; ++j) {
+                os << "," << std::endl << "\t\t\"" << config.test_names[j + 1] << "\": " << aggregation.outcome(ni, ki, j);
+            }
+
+            os << std::endl << "\t}" << std::endl;
+            os << "}";
+            if (ki < (k_list_size-1) || ni < (n_cut_list_size-1)) {
+                os << ",";
+            }
+            os << std::endl;
+        }
+    }
+    os << "]" << std::endl;
+}
+
+
+/**
+ * Writes a latency histogram as a json object containing its minimum and maximum values and the list of its
+ * non-empty buckets, as pairs [bucket index, count]
+ * @param os The output stream where to write
+ * @param histogram The histogram to write
+ */
+inline void
+write_partial_histogram(std::ostream &os, const LatencyHistogram &histogram) {
+    os << "{\"min\": " << histogram.min() << ", \"max\": " << histogram.max() << ", \"buckets\": [";
+    bool first = true;
+    for (const auto &bucket: histogram.buckets()) {
+        os << (first ? "" : ", ") << "[" << bucket.first << ", " << bucket.second << "]";
+        first = false;
+    }
+    os << "]}";
+}
+
+
+/**
+ * Reads a latency histogram written by write_partial_histogram
+ * @param value The json object to read
+ * @return The histogram
+ */
+inline LatencyHistogram
+read_partial_histogram(const JsonValue &value) {
+    std::vector<std::pair<std::size_t, std::uint64_t>> buckets;
+    for (const JsonValue &bucket: value["buckets"].as_array()) {
+        buckets.emplace_back(static_cast<std::size_t>(bucket[0].as_number()), static_cast<std::uint64_t>(bucket[1].as_number()));
+    }
+    return LatencyHistogram::from_buckets(buckets,
+                                          static_cast<std::uint64_t>(value["min"].as_number()),
+                                          static_cast<std::uint64_t>(value["max"].as_number()));
+}
+
+
+/**
+ * Writes the sums of the hardware performance counters as a json object containing the lists of sums and counts
+ * @param os The output stream where to write
+ * @param counters The sums of the counters to write
+ */
+inline void
+write_partial_counters(std::ostream &os, const PerfCounterSums &counters) {
+    os << "{\"sums\": [";
+    for (std::size_t i = 0; i < PerfCounterValues::num_counters; ++i) {
+        os << ((i > 0) ? ", " : "") << counters.sums[i];
+    }
+    os << "], \"counts\": [";
+    for (std::size_t i = 0; i < PerfCounterValues::num_counters; ++i) {
+        os << ((i > 0) ? ", " : "") << counters.counts[i];
+    }
+    os << "]}";
+}
+
+
+/**
+ * Reads the sums of the hardware performance counters written by write_partial_counters
+ * @param value The json object to read
+ * @return The sums of the counters
+ */
+inline PerfCounterSums
+read_partial_counters(const JsonValue &value) {
+    PerfCounterSums counters;
+    if (value["sums"].size() != PerfCounterValues::num_counters || value["counts"].size() != PerfCounterValues::num_counters) {
+        throw std::runtime_error("The number of hardware performance counters of the partial aggregation is wrong");
+    }
+    for (std::size_t i = 0; i < PerfCounterValues::num_counters; ++i) {
+        counters.sums[i] = value["sums"][i].as_number();
+        counters.counts[i] = static_cast<std::size_t>(value["counts"][i].as_number());
+    }
+    return counters;
+}
+
+
+/**
+ * Writes the sums of the heap memory allocated as a json object
+ * @param os The output stream where to write
+ * @param memory The sums of the memory to write
+ */
+inline void
+write_partial_memory(std::ostream &os, const MemoryUsageSums &memory) {
+    os << "{\"count\": " << memory.count;
+    os << ", \"sum_peak_bytes\": " << memory.sum_peak_bytes;
+    os << ", \"max_peak_bytes\": " << memory.max_peak_bytes;
+    os << ", \"sum_allocations\": " << memory.sum_allocations;
+    os << "}";
+}
+
+
+/**
+ * Reads the sums of the heap memory allocated written by write_partial_memory
+ * @param value The json object to read
+ * @return The sums of the memory
+ */
+inline MemoryUsageSums
+read_partial_memory(const JsonValue &value) {
+    MemoryUsageSums memory;
+    memory.count = static_cast<std::size_t>(value["count"].as_number());
+    memory.sum_peak_bytes = value["sum_peak_bytes"].as_number();
+    memory.max_peak_bytes = static_cast<std::int64_t>(value["max_peak_bytes"].as_number());
+    memory.sum_allocations = value["sum_allocations"].as_number();
+    return memory;
+}
+
+
+/**
+ * Writes the sums of the internal statistics as a json object
+ * @param os The output stream where to write
+ * @param stats The sums of the statistics to write
+ */
+inline void
+write_partial_stats(std::ostream &os, const FilteringStatsSums &stats) {
+    os << "{\"count\": " << stats.count << ", \"sums\": [";
+    for (std::size_t i = 0; i < FilteringStats::NUM_COUNTERS; ++i) {
+        os << ((i > 0) ? ", " : "") << stats.sums.counters[i];
+    }
+    os << "], \"epspruning_candidates_per_interval\": [";
+    for (std::size_t i = 0, i_end = stats.sums.epspruning_candidates_per_interval.size(); i < i_end; ++i) {
+        os << ((i > 0) ? ", " : "") << stats.sums.epspruning_candidates_per_interval[i];
+    }
+    os << "]}";
+}
+
+
+/**
+ * Reads the sums of the internal statistics written by write_partial_stats
+ * @param value The json object to read
+ * @return The sums of the statistics
+ */
+inline FilteringStatsSums
+read_partial_stats(const JsonValue &value) {
+    FilteringStatsSums stats;
+    if (value["sums"].size() != FilteringStats::NUM_COUNTERS) {
+        throw std::runtime_error("The number of internal statistics of the partial aggregation is wrong");
+    }
+    stats.count = static_cast<std::size_t>(value["count"].as_number());
+    for (std::size_t i = 0; i < FilteringStats::NUM_COUNTERS; ++i) {
+        stats.sums.counters[i] = static_cast<std::uint64_t>(value["sums"][i].as_number());
+    }
+    for (const JsonValue &candidates: value["epspruning_candidates_per_interval"].as_array()) {
+        stats.sums.epspruning_candidates_per_interval.push_back(static_cast<std::uint64_t>(candidates.as_number()));
+    }
+    return stats;
+}
+
+
+/**
+ * Writes the sums of the given aggregation as a json object, with full precision
+ * @param os The output stream where to write
+ * @param outcome The aggregation to write
+ */
+inline void
+write_partial_outcome(std::ostream &os, const TestsAggregationOutcome &outcome) {
+    os << "{";
+    os << "\"num_lists\": " << outcome.num_lists;
+    os << ", \"num_scored_lists\": " << outcome.score.count();
+    os << ", \"sum_score\": " << outcome.score.sum();
+    os << ", \"m2_score\": " << outcome.score.m2();
+    os << ", \"max_approximation_error\": " << outcome.max_approximation_error;
+    os << ", \"sum_approximation_error\": " << outcome.approximation_error.sum();
+    os << ", \"m2_approximation_error\": " << outcome.approximation_error.m2();
+    os << ", \"num_certified_lists\": " << outcome.certified_error.count();
+    os << ", \"max_certified_error\": " << outcome.max_certified_error;
+    os << ", \"sum_certified_error\": " << outcome.certified_error.sum();
+    os << ", \"m2_certified_error\": " << outcome.certified_error.m2();
+    os << ", \"sum_num_elements_pruned\": " << outcome.sum_num_elements_pruned.value();
+    os << ", \"sum_num_elements_not_pruned\": " << outcome.sum_num_elements_not_pruned.value();
+    os << ", \"sum_num_intervals\": " << outcome.sum_num_intervals.value();
+    os << ", \"sum_first_stage_time\": " << outcome.sum_first_stage_time.value();
+    os << ", \"sum_second_stage_time\": " << outcome.sum_second_stage_time.value();
+    os << ", \"sum_total_time\": " << outcome.total_time.sum();
+    os << ", \"m2_total_time\": " << outcome.total_time.m2();
+    os << ", \"first_stage_latency\": "; write_partial_histogram(os, outcome.first_stage_latency);
+    os << ", \"second_stage_latency\": "; write_partial_histogram(os, outcome.second_stage_latency);
+    os << ", \"total_latency\": "; write_partial_histogram(os, outcome.total_latency);
+    os << ", \"first_stage_counters\": "; write_partial_counters(os, outcome.first_stage_counters);
+    os << ", \"second_stage_counters\": "; write_partial_counters(os, outcome.second_stage_counters);
+    os << ", \"first_stage_memory\": "; write_partial_memory(os, outcome.first_stage_memory);
+    os << ", \"second_stage_memory\": "; write_partial_memory(os, outcome.second_stage_memory);
+    os << ", \"stats\": "; write_partial_stats(os, outcome.stats);
+    os << "}";
+}
+
+
+/**
+ * Reads the sums of an aggregation written by write_partial_outcome
+ * @param value The json object to read
+ * @return The aggregation
+ */
+inline TestsAggregationOutcome
+read_partial_outcome(const JsonValue &value) {
+    TestsAggregationOutcome outcome;
+    outcome.num_lists = static_cast<std::size_t>(value["num_lists"].as_number());
+    outcome.max_approximation_error = value["max_approximation_error"].as_number();
+    const std::size_t num_scored_lists = value.has("num_scored_lists") ? static_cast<std::size_t>(value["num_scored_lists"].as_number()) : outcome.num_lists;
+    outcome.score.assign(num_scored_lists, value["sum_score"].as_number(), value["m2_score"].as_number());
+    outcome.approximation_error.assign(num_scored_lists, value["sum_approximation_error"].as_number(), value["m2_approximation_error"].as_number());
+    if (value.has("num_certified_lists")) {
+        const std::size_t num_certified_lists = static_cast<std::size_t>(value["num_certified_lists"].as_number());
+        outcome.max_certified_error = value["max_certified_error"].as_number();
+        outcome.certified_error.assign(num_certified_lists, value["sum_certified_error"].as_number(), value["m2_certified_error"].as_number());
+    }
+    outcome.sum_num_elements_pruned.assign(value["sum_num_elements_pruned"].as_number());
+    outcome.sum_num_elements_not_pruned.assign(value["sum_num_elements_not_pruned"].as_number());
+    outcome.sum_num_intervals.assign(value["sum_num_intervals"].as_number());
+    outcome.sum_first_stage_time.assign(value["sum_first_stage_time"].as_number());
+    outcome.sum_second_stage_time.assign(value["sum_second_stage_time"].as_number());
+    outcome.total_time.assign(outcome.num_lists, value["sum_total_time"].as_number(), value["m2_total_time"].as_number());
+    outcome.first_stage_latency = read_partial_histogram(value["first_stage_latency"]);
+    outcome.second_stage_latency = read_partial_histogram(value["second_stage_latency"]);
+    outcome.total_latency = read_partial_histogram(value["total_latency"]);
+    outcome.first_stage_counters = read_partial_counters(value["first_stage_counters"]);
+    outcome.second_stage_counters = read_partial_counters(value["second_stage_counters"]);
+    if (value.has("first_stage_memory")) {
+        outcome.first_stage_memory = read_partial_memory(value["first_stage_memory"]);
+        outcome.second_stage_memory = read_partial_memory(value["second_stage_memory"]);
+    }
+    if (value.has("stats")) {
+        outcome.stats = read_partial_stats(value["stats"]);
+    }
+    return outcome;
+}
+
+
+/**
+ * Writes the partial aggregation computed by a shard of the assessment, in a json format that can be merged
+ * with the other shards
+ * @param os The output stream where to write
+ * @param config The configuration of the assessment
+ * @param aggregation The aggregation of the outcomes of the tests performed by the shard
+ * @param shard_id The id of the shard, in the range [0, num_shards)
+ * @param num_shards The total number of shards
+ */
+inline void
+write_assessment_partial(
+        std::ostream &os,
+        const AssessmentConfiguration &config,
+        const AssessmentAggregation &aggregation,
+        std::size_t shard_id,
+        std::size_t num_shards
+) {
+    const std::streamsize precision = os.precision(std::numeric_limits<double>::max_digits10);
+
+    os << "{" << std::endl;
+    os << "\t\"format\": \"assessment-partial\"";
+    os << ", \"version\": 1";
+    os << ", \"metric\": "; write_json_string(os, config.metric);
+    os << ", \"shard\": " << shard_id;
+    os << ", \"num_shards\": " << num_shards;
+    os << ", \"peak_rss_bytes\": " << aggregation.peak_rss_bytes;
+    os << ", \"report_throughput\": " << (config.report_throughput ? "true" : "false") << "," << std::endl;
+
+    os << "\t\"n_cut_list\": [";
+    for (std::size_t ni = 0; ni < config.n_cut_list.size(); ++ni) {
+        os << ((ni > 0) ? ", " : "") << config.n_cut_list[ni];
+    }
+    os << "]," << std::endl << "\t\"k_list\": [";
+    for (std::size_t ki = 0; ki < config.k_list.size(); ++ki) {
+        os << ((ki > 0) ? ", " : "") << config.k_list[ki];
+    }
+    os << "]," << std::endl << "\t\"test_names\": [";
+    for (std::size_t t = 0; t < config.test_names.size(); ++t) {
+        os << ((t > 0) ? ", " : "");
+        write_json_string(os, config.test_names[t]);
+    }
+    os << "]," << std::endl;
+
+    os << "\t\"cells\": [";
+    for (std::size_t ni = 0; ni < aggregation.n_cut_list_size; ++ni) {
+        for (std::size_t ki = 0; ki < aggregation.k_list_size; ++ki) {
+            os << ((ni > 0 || ki > 0) ? "," : "") << std::endl;
+            os << "\t\t{\"num_lists_assessed\": " << aggregation.num_lists_assessed(ni, ki);
+            os << ", \"sum_reading_time\": " << aggregation.sum_reading_time(ni, ki);
+            os << ", \"sum_list_length\": " << aggregation.sum_list_length(ni, ki);
+            os << ", \"tests\": [" << std::endl << "\t\t\t";
+            write_partial_outcome(os, aggregation.outcome_opt(ni, ki));
+            for (std::size_t j = 0; j < aggregation.num_tests; ++j) {
+                os << "," << std::endl << "\t\t\t";
+                write_partial_outcome(os, aggregation.outcome(ni, ki, j));
+            }
+            os << "]}";
+        }
+    }
+    os << std::endl << "\t]" << std::endl;
+    os << "}" << std::endl;
+
+    os.precision(precision);
+}
+
+
+/**
+ * Reads the partial aggregation written by write_assessment_partial
+ * @param value The json document to read
+ * @param config Where to store the configuration of the assessment
+ * @param shard_id Where to store the id of the shard
+ * @param num_shards Where to store the total number of shards
+ * @return The partial aggregation
+ */
+inline std::unique_ptr<AssessmentAggregation>
+read_assessment_partial(
+        const JsonValue &value,
+        AssessmentConfiguration &config,
+        std::size_t &shard_id,
+        std::size_t &num_shards
+) {
+    if (!value.has("format") || value["format"].as_string() != "assessment-partial") {
+        throw std::runtime_error("The document is not a partial aggregation of an assessment");
+    }
+    if (value["version"].as_number() != 1) {
+        throw std::runtime_error("Unsupported version of the partial aggregation");
+    }
+
+    config.metric = value["metric"].as_string();
+    shard_id = static_cast<std::size_t>(value["shard"].as_number());
+    num_shards = static_cast<std::size_t>(value["num_shards"].as_number());
+    config.n_cut_list.clear();
+    for (const JsonValue &n_cut: value["n_cut_list"].as_array()) {
+        config.n_cut_list.push_back(static_cast<index_type>(n_cut.as_number()));
+    }
+    config.k_list.clear();
+    for (const JsonValue &k: value["k_list"].as_array()) {
+        config.k_list.push_back(static_cast<k_type>(k.as_number()));
+    }
+    config.test_names.clear();
+    for (const JsonValue &name: value["test_names"].as_array()) {
+        config.test_names.push_back(name.as_string());
+    }
+    if (config.test_names.empty()) {
+        throw std::runtime_error("The partial aggregation does not contain any test");
+    }
+    config.report_throughput = value.has("report_throughput") && value["report_throughput"].as_bool();
+
+    const std::size_t num_tests = config.test_names.size() - 1;
+    std::unique_ptr<AssessmentAggregation> aggregation(
+            new AssessmentAggregation(config.n_cut_list.size(), config.k_list.size(), num_tests));
+
+    if (value.has("peak_rss_bytes")) {
+        aggregation->peak_rss_bytes = static_cast<std::int64_t>(value["peak_rss_bytes"].as_number());
+    }
+
+    const JsonValue &cells = value["cells"];
+    if (cells.size() != config.n_cut_list.size() * config.k_list.size()) {
+        throw std::runtime_error("The number of cells of the partial aggregation does not match its configuration");
+    }
+    for (std::size_t ni = 0; ni < config.n_cut_list.size(); ++ni) {
+        for (std::size_t ki = 0; ki < config.k_list.size(); ++ki) {
+            const JsonValue &cell = cells[ni * config.k_list.size() + ki];
+            aggregation->num_lists_assessed(ni, ki) = static_cast<std::size_t>(cell["num_lists_assessed"].as_number());
+            aggregation->sum_reading_time(ni, ki).assign(cell["sum_reading_time"].as_number());
+            if (cell.has("sum_list_length")) {
+                aggregation->sum_list_length(ni, ki) = cell["sum_list_length"].as_number();
+            }
+
+            const JsonValue &tests = cell["tests"];
+            if (tests.size() != num_tests + 1) {
+                throw std::runtime_error("The number of tests of the partial aggregation does not match its configuration");
+            }
+            aggregation->outcome_opt(ni, ki) = read_partial_outcome(tests[0]);
+            for (std::size_t j = 0; j < num_tests; ++j) {
+                aggregation->outcome(ni, ki, j) = read_partial_outcome(tests[j + 1]);
+            }
+        }
+    }
+
+    return aggregation;
+}
+
+
+#endif //UTILS_ASSESSMENT_AGGREGATION_HPP
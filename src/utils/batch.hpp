@@ -0,0 +1,177 @@
+#ifndef UTILS_BATCH_HPP
+#define UTILS_BATCH_HPP
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "../filtering/filter.hpp"
+#include "../filtering/pruner.hpp"
+#include "../filtering/types.hpp"
+#include "../filtering/workspace.hpp"
+#include "composition.hpp"
+#include "thread_pool.hpp"
+
+
+/**
+ * List of relevances owned by the caller of a batch.
+ */
+typedef struct {
+    /**
+     * Relevances of the elements of the list, ordered according to some attribute
+     */
+    const relevance_type *relevances;
+    /**
+     * Number of elements of the list
+     */
+    index_type n;
+} BatchList;
+
+
+/**
+ * Filters batches of independent lists concurrently on a work-stealing pool.
+ * The lists of a batch are scheduled from the longest to the shortest, so that the longest lists do not end up last on
+ * a single worker, and the shortest ones are grouped into tasks of at least grain_size elements, so that the cost of
+ * the scheduling is negligible. Every worker owns a workspace reused across the lists, thus the filter does not
+ * allocate its dynamic programming table for each list.
+ * The pipelines are only read, thus the same pipelines can be shared by many batch filters and threads.
+ * @tparam ScoreFun Score function type
+ */
+template <typename ScoreFun>
+class BatchFilter {
+public:
+    /**
+     * Type of the pipelines, i.e., the pruner and the filter of a composition test
+     */
+    typedef std::shared_ptr<PrunerFilterCompositionTest<ScoreFun>> pipeline_type;
+
+    /**
+     * Minimum number of elements filtered by a task
+     */
+    static const std::size_t grain_size = 16384;
+
+    /**
+     * Constructor
+     * @param num_threads Number of worker threads
+     * @param cpu_list List of cpus where to pin the workers, the i-th worker is pinned to cpu_list[i]. When empty, the
+     * workers are not pinned
+     */
+    explicit BatchFilter(std::size_t num_threads, const std::vector<int> &cpu_list = std::vector<int>()) :
+            pool(num_threads, cpu_list),
+            workspaces(num_threads) {
+    }
+
+    /**
+     * Number of worker threads
+     * @return The number of worker threads
+     */
+    std::size_t
+    size() const {
+        return this->pool.size();
+    }
+
+    /**
+     * Filters a batch of lists. The batches submitted by different threads are filtered one after the other.
+     * @param lists The lists to filter
+     * @param configs The pipelines, either one used for all lists or one per list
+     * @param results Where to store the solution of each list, whose indices refer to the elements of the list
+     * @throws std::invalid_argument if the number of pipelines does not match the number of lists
+     */
+    void
+    filter_batch(const std::vector<BatchList> &lists, const std::vector<pipeline_type> &configs, std::vector<FilterSolution> &results) {
+        if (configs.size() != 1 && configs.size() != lists.size()) {
+            throw std::invalid_argument("The parameter configs must contain one pipeline, or one pipeline per list");
+        }
+        for (const pipeline_type &config: configs) {
+            if (config == nullptr) {
+                throw std::invalid_argument("The parameter configs must not contain null pipelines");
+            }
+        }
+        results.assign(lists.size(), FilterSolution());
+
+        // schedule the longest lists first
+        std::vector<std::size_t> order(lists.size());
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&lists](std::size_t l, std::size_t r) {
+            return lists[l].n > lists[r].n;
+        });
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::size_t begin = 0;
+        while (begin < order.size()) {
+            std::size_t end = begin;
+            std::size_t num_elements = 0;
+            while (end < order.size() && num_elements < BatchFilter::grain_size) {
+                num_elements += lists[order[end++]].n;
+            }
+            this->pool.submit([this, &lists, &configs, &results, &order, begin, end](std::size_t worker_id) {
+                Workspace &workspace = this->workspaces[worker_id];
+                for (std::size_t i = begin; i < end; ++i) {
+                    const std::size_t list_id = order[i];
+                    const PrunerFilterCompositionTest<ScoreFun> &config = *configs[(configs.size() == 1) ? 0 : list_id];
+                    results[list_id] = filter_list(config, lists[list_id], workspace);
+                }
+            });
+            begin = end;
+        }
+        this->pool.wait();
+    }
+
+    /**
+     * Filters a list with the pruner and the filter of a pipeline, reusing the buffers of a workspace
+     * @param config The pipeline
+     * @param list The list to filter
+     * @param workspace The workspace of the calling thread
+     * @return The solution, whose indices refer to the elements of the list
+     */
+    static FilterSolution
+    filter_list(const PrunerFilterCompositionTest<ScoreFun> &config, const BatchList &list, Workspace &workspace) {
+        const relevance_type *rel_list = list.relevances;
+        const index_type n = list.n;
+        if (n == 0) {
+            return FilterSolution();
+        }
+        if (config.pruner == nullptr) {
+            config.check_filter_cells(n);
+            return config.filter->operator()(rel_list, n, workspace);
+        }
+
+        // compute min and max elements of the list
+        minmax_type minmax_element;
+        minmax_element.min = minmax_element.max = rel_list[0];
+        for (index_type j = 1; j < n; ++j) {
+            if (rel_list[j] < minmax_element.min) {
+                minmax_element.min = rel_list[j];
+            } else if (rel_list[j] > minmax_element.max) {
+                minmax_element.max = rel_list[j];
+            }
+        }
+
+        // first stage, and copy of the elements not pruned into the workspace
+        const PrunerSolution pruningSolution = config.pruner->operator()(rel_list, n, minmax_element);
+        const index_type n2 = pruningSolution.size();
+        config.check_filter_cells(n2);
+        workspace.relevances.resize(n2);
+        for (index_type i = 0; i < n2; ++i) {
+            workspace.relevances[i] = rel_list[pruningSolution.indices[i]];
+        }
+
+        // second stage, and update of the indices according to the results of the first stage
+        FilterSolution filteringSolution = config.filter->operator()(workspace.relevances.data(), n2, workspace);
+        for (index_type i = 0, i_end = filteringSolution.size(); i < i_end; ++i) {
+            filteringSolution.indices[i] = pruningSolution.indices[filteringSolution.indices[i]];
+        }
+        return filteringSolution;
+    }
+
+private:
+    WorkStealingPool pool;
+    std::vector<Workspace> workspaces;
+    std::mutex mutex;
+};
+
+
+#endif //UTILS_BATCH_HPP
@@ -0,0 +1,246 @@
+#ifndef UTILS_BENCHMARK_SCHEDULE_HPP
+#define UTILS_BENCHMARK_SCHEDULE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "composition.hpp"
+#include "utils.hpp"
+
+
+/**
+ * How the runs of a group of tests on the same list are scheduled.
+ * With the default values the runs of each test are executed back-to-back and averaged, as done by the test itself.
+ */
+typedef struct {
+    /**
+     * Number of untimed runs of each test executed before the timed ones
+     */
+    int warmup_runs = 0;
+    /**
+     * Whether to evict the caches before each timed run
+     */
+    bool cold_cache = false;
+    /**
+     * Size in bytes of the buffer written to evict the caches (it should be larger than the last level cache)
+     */
+    std::size_t flush_size = 64 * 1024 * 1024;
+    /**
+     * Whether to run the tests in a random order at each run, instead of running all the runs of a test back-to-back
+     */
+    bool interleave = false;
+    /**
+     * Runs whose total time is farther than outlier_threshold scaled median absolute deviations from the median are
+     * discarded (zero to keep all runs)
+     */
+    double outlier_threshold = 0;
+
+    /**
+     * Checks whether the runs are executed back-to-back as done by the tests themselves
+     */
+    bool
+    is_back_to_back() const {
+        return this->warmup_runs == 0 && !this->cold_cache && !this->interleave && this->outlier_threshold <= 0;
+    }
+} BenchmarkSchedule;
+
+
+/**
+ * Evicts the caches of the calling thread by writing every cache line of a buffer larger than the caches.
+ */
+class CacheFlusher {
+public:
+    /**
+     * Constructor
+     * @param size The size in bytes of the buffer
+     */
+    explicit CacheFlusher(std::size_t size) :
+            buffer(std::max<std::size_t>(size, CacheFlusher::line_size), 0) {
+    }
+
+    /**
+     * Writes every cache line of the buffer
+     */
+    void
+    flush() {
+        unsigned char *data = this->buffer.data();
+        for (std::size_t i = 0, i_end = this->buffer.size(); i < i_end; i += CacheFlusher::line_size) {
+            data[i] += 1;
+        }
+        doNotOptimizeAway(data[this->buffer.size() - 1]);
+    }
+
+    /**
+     * Gets the flusher of the calling thread, allocating its buffer at the first call
+     * @param size The size in bytes of the buffer
+     * @return The flusher of the calling thread
+     */
+    static CacheFlusher &
+    thread_instance(std::size_t size) {
+        static thread_local CacheFlusher flusher(size);
+        return flusher;
+    }
+
+private:
+    /**
+     * Size of a cache line, as an enumerator so that binding it to a reference (e.g., by std::max) needs no definition
+     */
+    enum : std::size_t { line_size = 64 };
+
+    std::vector<unsigned char> buffer;
+};
+
+
+/**
+ * Averages the outcomes of the runs of a test, keeping the solution of the first run
+ * @param runs The outcomes of the runs
+ * @param keep Whether each run is kept in the average
+ * @return The averaged outcome
+ */
+inline TestOutcome
+average_test_runs(const std::vector<TestOutcome> &runs, const std::vector<bool> &keep) {
+    TestOutcome result = runs[0];
+    result.first_stage_time = result.second_stage_time = result.total_time = 0;
+    PerfCounterValues first_stage_counters, second_stage_counters;
+    for (std::size_t c = 0; c < PerfCounterValues::num_counters; ++c) {
+        first_stage_counters.valid[c] = second_stage_counters.valid[c] = true;
+    }
+
+    std::size_t num_kept = 0;
+    for (std::size_t r = 0; r < runs.size(); ++r) {
+        if (!keep[r]) {
+            continue;
+        }
+        result.first_stage_time += runs[r].first_stage_time;
+        result.second_stage_time += runs[r].second_stage_time;
+        result.total_time += runs[r].total_time;
+        for (std::size_t c = 0; c < PerfCounterValues::num_counters; ++c) {
+            first_stage_counters.valid[c] = first_stage_counters.valid[c] && runs[r].first_stage_counters.valid[c];
+            first_stage_counters.values[c] += runs[r].first_stage_counters.values[c];
+            second_stage_counters.valid[c] = second_stage_counters.valid[c] && runs[r].second_stage_counters.valid[c];
+            second_stage_counters.values[c] += runs[r].second_stage_counters.values[c];
+        }
+        ++num_kept;
+    }
+
+    result.first_stage_time /= num_kept;
+    result.second_stage_time /= num_kept;
+    result.total_time /= num_kept;
+    for (std::size_t c = 0; c < PerfCounterValues::num_counters; ++c) {
+        first_stage_counters.values[c] = first_stage_counters.valid[c] ? first_stage_counters.values[c] / num_kept : 0;
+        second_stage_counters.values[c] = second_stage_counters.valid[c] ? second_stage_counters.values[c] / num_kept : 0;
+    }
+    result.first_stage_counters = first_stage_counters;
+    result.second_stage_counters = second_stage_counters;
+    return result;
+}
+
+
+/**
+ * Selects the runs whose total time is within threshold scaled median absolute deviations from the median
+ * @param runs The outcomes of the runs
+ * @param threshold The number of scaled median absolute deviations (zero to keep all runs)
+ * @return Whether each run is kept
+ */
+inline std::vector<bool>
+reject_outlier_runs(const std::vector<TestOutcome> &runs, double threshold) {
+    std::vector<bool> keep(runs.size(), true);
+    if (threshold <= 0 || runs.size() < 3) {
+        return keep;
+    }
+
+    auto median = [](std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        const std::size_t m = values.size() / 2;
+        return (values.size() % 2) ? values[m] : (values[m - 1] + values[m]) / 2;
+    };
+
+    std::vector<double> times;
+    for (const TestOutcome &run: runs) {
+        times.push_back(run.total_time);
+    }
+    const double median_time = median(times);
+    std::vector<double> deviations;
+    for (double time: times) {
+        deviations.push_back(std::fabs(time - median_time));
+    }
+    // scale factor making the median absolute deviation a consistent estimator of the standard deviation
+    const double scaled_mad = 1.4826 * median(deviations);
+    if (scaled_mad <= 0) {
+        return keep;
+    }
+    for (std::size_t r = 0; r < runs.size(); ++r) {
+        keep[r] = std::fabs(times[r] - median_time) <= threshold * scaled_mad;
+    }
+    return keep;
+}
+
+
+/**
+ * Runs a group of tests on the same list according to the given schedule
+ * @param tests The tests to run
+ * @param rel_list List containing the relevance scores, ordered according to some attribute
+ * @param n Number of elements of rel_list
+ * @param minmax_element The minimum and maximum elements of rel_list
+ * @param num_runs The number of timed runs of each test
+ * @param schedule The schedule of the runs
+ * @param random_engine The random engine used to interleave the tests
+ * @param outcomes Array where to write the outcome of each test
+ * @param list_id The id of the list, which tags the spans of the trace, or -1 for the current list of the thread
+ */
+template <typename ScoreFun>
+void
+run_scheduled_tests(
+        const std::vector<PrunerFilterCompositionTest<ScoreFun> *> &tests,
+        const relevance_type *rel_list,
+        const index_type n,
+        const minmax_type &minmax_element,
+        const int num_runs,
+        const BenchmarkSchedule &schedule,
+        std::mt19937 &random_engine,
+        TestOutcome *outcomes,
+        const std::int64_t list_id=-1
+) {
+    const std::size_t num_tests = tests.size();
+    if (schedule.is_back_to_back()) {
+        for (std::size_t t = 0; t < num_tests; ++t) {
+            outcomes[t] = tests[t]->operator()(rel_list, n, minmax_element, list_id);
+        }
+        return;
+    }
+
+    // warm up the caches and the branch predictors, discarding the outcomes
+    for (int run = 0; run < schedule.warmup_runs; ++run) {
+        for (std::size_t t = 0; t < num_tests; ++t) {
+            tests[t]->run_once(rel_list, n, minmax_element, list_id);
+        }
+    }
+
+    std::vector<std::vector<TestOutcome>> runs(num_tests);
+    std::vector<std::size_t> order(num_tests);
+    for (std::size_t t = 0; t < num_tests; ++t) {
+        order[t] = t;
+        runs[t].reserve(num_runs);
+    }
+    for (int run = 0; run < num_runs; ++run) {
+        if (schedule.interleave) {
+            std::shuffle(order.begin(), order.end(), random_engine);
+        }
+        for (std::size_t t: order) {
+            if (schedule.cold_cache) {
+                CacheFlusher::thread_instance(schedule.flush_size).flush();
+            }
+            runs[t].push_back(tests[t]->run_once(rel_list, n, minmax_element, list_id));
+        }
+    }
+
+    for (std::size_t t = 0; t < num_tests; ++t) {
+        outcomes[t] = average_test_runs(runs[t], reject_outlier_runs(runs[t], schedule.outlier_threshold));
+    }
+}
+
+
+#endif //UTILS_BENCHMARK_SCHEDULE_HPP
@@ -0,0 +1,135 @@
+#ifndef UTILS_CACHED_FILTER_HPP
+#define UTILS_CACHED_FILTER_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "../data_structures/hash.hpp"
+#include "../data_structures/lru_cache.hpp"
+#include "../filtering/filter.hpp"
+#include "../filtering/types.hpp"
+#include "../filtering/workspace.hpp"
+#include "batch.hpp"
+#include "composition.hpp"
+
+
+/**
+ * Pipeline whose solutions are cached by the content of the lists, so that repeated lists (popular queries, retries,
+ * pagination) are filtered only once.
+ * The key of a list is the 64-bit hash of its relevances, seeded with the metric, the name of the pipeline, k and
+ * epsilon, thus the same cache can be shared by the cached filters of different pipelines. Two distinct lists
+ * colliding on the same key, with probability about 2^-64 per pair, would share their solution.
+ * It can be used by many threads at the same time.
+ * @tparam ScoreFun Score function type
+ */
+template <typename ScoreFun>
+class CachedFilter {
+public:
+    /**
+     * Type of the pipelines, i.e., the pruner and the filter of a composition test
+     */
+    typedef std::shared_ptr<PrunerFilterCompositionTest<ScoreFun>> pipeline_type;
+    /**
+     * Type of the cache of the solutions
+     */
+    typedef ShardedLRUCache<FilterSolution> cache_type;
+
+    /**
+     * Memory charged to each entry of the cache in addition to its indices, which approximates the nodes of its list
+     * and of its index
+     */
+    static const std::size_t entry_overhead = 96;
+
+    /**
+     * Constructor
+     * @param config The pipeline
+     * @param cache The cache of the solutions, possibly shared with other cached filters
+     */
+    CachedFilter(pipeline_type config, std::shared_ptr<cache_type> cache) :
+            config(std::move(config)),
+            cache(std::move(cache)) {
+        if (this->config == nullptr || this->cache == nullptr) {
+            throw std::invalid_argument("The parameters config and cache must not be null");
+        }
+        const k_type k = this->config->filter->k;
+        const double epsilon = this->config->epsilon_below;
+        std::uint64_t seed = hash64::hash(std::string(ScoreFun::name()));
+        seed = hash64::hash(this->config->name, seed);
+        seed = hash64::hash(&k, sizeof(k), seed);
+        seed = hash64::hash(&epsilon, sizeof(epsilon), seed);
+        this->seed = seed;
+    }
+
+    /**
+     * Key of a list in the cache
+     * @param rel_list List containing the relevance scores, ordered according to some attribute
+     * @param n Number of elements of rel_list
+     * @return The key
+     */
+    std::uint64_t
+    key(const relevance_type * rel_list, const index_type n) const {
+        return hash64::hash(rel_list, static_cast<std::size_t>(n) * sizeof(relevance_type), this->seed);
+    }
+
+    /**
+     * Filters the given list, or returns its cached solution
+     * @param rel_list List containing the relevance scores, ordered according to some attribute
+     * @param n Number of elements of rel_list
+     * @param workspace The workspace of the calling thread, used on a miss
+     * @param hit Where to store whether the solution was cached, or nullptr
+     * @return The filtering solution, whose indices refer to the elements of the list
+     */
+    FilterSolution
+    operator()(const relevance_type * rel_list, const index_type n, Workspace &workspace, bool *hit=nullptr) const {
+        const std::uint64_t list_key = this->key(rel_list, n);
+        FilterSolution solution;
+        const bool found = this->cache->lookup(list_key, solution);
+        if (hit != nullptr) {
+            *hit = found;
+        }
+        if (!found) {
+            BatchList list;
+            list.relevances = rel_list;
+            list.n = n;
+            solution = BatchFilter<ScoreFun>::filter_list(*this->config, list, workspace);
+            this->cache->insert(list_key, solution, CachedFilter::entry_overhead + solution.size() * sizeof(index_type));
+        }
+        return solution;
+    }
+
+    /**
+     * Filters the given list, or returns its cached solution
+     * @param rel_list List containing the relevance scores, ordered according to some attribute
+     * @param n Number of elements of rel_list
+     * @return The filtering solution, whose indices refer to the elements of the list
+     */
+    FilterSolution
+    operator()(const relevance_type * rel_list, const index_type n) const {
+        Workspace workspace;
+        return this->operator()(rel_list, n, workspace);
+    }
+
+    /**
+     * Counters of the cache, including the lookups of the other cached filters sharing it
+     * @return The counters
+     */
+    CacheStatistics
+    statistics() const {
+        return this->cache->statistics();
+    }
+
+public:
+    /**
+     * The pipeline
+     */
+    const pipeline_type config;
+
+private:
+    const std::shared_ptr<cache_type> cache;
+    std::uint64_t seed;
+};
+
+
+#endif //UTILS_CACHED_FILTER_HPP
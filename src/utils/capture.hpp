@@ -0,0 +1,270 @@
+#ifndef UTILS_CAPTURE_HPP
+#define UTILS_CAPTURE_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+#include "../data_structures/latency_histogram.hpp"
+#include "composition.hpp"
+#include "json.hpp"
+#include "utils.hpp"
+
+
+/**
+ * Description of a list captured because a strategy was too slow on it, stored in a json file next to the tsv file
+ * containing the list.
+ */
+typedef struct {
+    /**
+     * Name of the search quality metric
+     */
+    std::string metric;
+    /**
+     * Name of the test
+     */
+    std::string test_name;
+    /**
+     * Approximation factor of the strategy
+     */
+    score_type epsilon = 0;
+    /**
+     * Number of elements assessed
+     */
+    index_type n = 0;
+    /**
+     * Number of elements to select
+     */
+    k_type k = 0;
+    /**
+     * Id of the list in the assessment
+     */
+    std::size_t list_id = 0;
+    /**
+     * File containing the list in the assessment, if any
+     */
+    std::string source;
+    /**
+     * Path of the tsv file of the captured list, relative to the json file
+     */
+    std::string list_file;
+    /**
+     * Outcome of the test on the list
+     */
+    TestOutcome outcome;
+} CapturedList;
+
+
+/**
+ * Writes the description of a captured list as a json object
+ * @param os The output stream where to write
+ * @param captured The captured list
+ */
+inline void
+write_captured_list(std::ostream &os, const CapturedList &captured) {
+    const std::streamsize precision = os.precision(std::numeric_limits<double>::max_digits10);
+    os << "{\"format\": \"captured-list\", \"version\": 1";
+    os << ", \"metric\": "; write_json_string(os, captured.metric);
+    os << ", \"test\": "; write_json_string(os, captured.test_name);
+    os << ", \"epsilon\": " << captured.epsilon;
+    os << ", \"n\": " << captured.n;
+    os << ", \"k\": " << captured.k;
+    os << ", \"list_id\": " << captured.list_id;
+    os << ", \"source\": "; write_json_string(os, captured.source);
+    os << ", \"list_file\": "; write_json_string(os, captured.list_file);
+    os << ", \"score\": " << captured.outcome.score;
+    os << ", \"num_elements_not_pruned\": " << captured.outcome.num_elements_not_pruned;
+    os << ", \"first_stage_time\": " << captured.outcome.first_stage_time;
+    os << ", \"second_stage_time\": " << captured.outcome.second_stage_time;
+    os << ", \"total_time\": " << captured.outcome.total_time;
+    os << "}" << std::endl;
+    os.precision(precision);
+}
+
+
+/**
+ * Reads the description of a captured list written by write_captured_list
+ * @param value The json object to read
+ * @return The captured list
+ */
+inline CapturedList
+read_captured_list(const JsonValue &value) {
+    if (!value.has("format") || value["format"].as_string() != "captured-list") {
+        throw std::runtime_error("The document is not the description of a captured list");
+    }
+    CapturedList captured;
+    captured.metric = value["metric"].as_string();
+    captured.test_name = value["test"].as_string();
+    captured.epsilon = static_cast<score_type>(value["epsilon"].as_number());
+    captured.n = static_cast<index_type>(value["n"].as_number());
+    captured.k = static_cast<k_type>(value["k"].as_number());
+    captured.list_id = static_cast<std::size_t>(value["list_id"].as_number());
+    captured.source = value["source"].as_string();
+    captured.list_file = value["list_file"].as_string();
+    captured.outcome.score = static_cast<score_type>(value["score"].as_number());
+    captured.outcome.num_elements_not_pruned = static_cast<index_type>(value["num_elements_not_pruned"].as_number());
+    captured.outcome.first_stage_time = value["first_stage_time"].as_number();
+    captured.outcome.second_stage_time = value["second_stage_time"].as_number();
+    captured.outcome.total_time = value["total_time"].as_number();
+    return captured;
+}
+
+
+/**
+ * Writes the first n elements of a list in the tsv format read by read_results_list, with full precision. The lists
+ * without ids use the position as id and attribute
+ * @param os The output stream where to write
+ * @param list The list to write
+ * @param n The number of elements to write
+ */
+inline void
+write_results_list_tsv(std::ostream &os, const ResultsList &list, std::size_t n) {
+    const std::streamsize precision = os.precision(std::numeric_limits<double>::max_digits10);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (list.has_ids()) {
+            os << list.ids[i] << "\t" << list.attributes[i];
+        } else {
+            os << "d" << i << "\t" << i;
+        }
+        os << "\t" << list.relevances[i] << "\n";
+    }
+    os.precision(precision);
+}
+
+
+/**
+ * Captures the lists on which a test is slower than an absolute threshold or than a percentile of the times observed
+ * so far for the same test, writing them in a directory. It can be shared among threads.
+ */
+class OutlierCapture {
+public:
+    /**
+     * Minimum number of times observed for a test before using its percentile
+     */
+    static const std::uint64_t min_observations = 100;
+
+    /**
+     * Constructor, which creates the capture directory if it does not exist
+     * @param directory The capture directory
+     * @param metric The name of the search quality metric
+     * @param num_tests The number of distinct tests, i.e., of pairs (n_cut, k) times the strategies
+     * @param threshold The absolute threshold on the total time in milliseconds, or zero
+     * @param percentile The percentile of the total times observed, in the range (0, 100), or zero
+     * @param limit The maximum number of lists to capture
+     */
+    OutlierCapture(std::string directory, std::string metric, std::size_t num_tests, double threshold, double percentile, std::size_t limit) :
+            directory(std::move(directory)),
+            metric(std::move(metric)),
+            threshold(threshold),
+            percentile(percentile),
+            limit(limit),
+            histograms(num_tests) {
+        if (this->threshold <= 0 && this->percentile <= 0) {
+            throw std::runtime_error("The capture requires a positive threshold or percentile");
+        }
+        if (this->percentile >= 100) {
+            throw std::runtime_error("The capture percentile must be smaller than 100");
+        }
+        struct stat s;
+        if (stat(this->directory.c_str(), &s) != 0) {
+            if (mkdir(this->directory.c_str(), 0755) != 0) {
+                throw std::runtime_error(std::string("Unable to create the capture directory ") + this->directory + ": " + std::strerror(errno));
+            }
+        } else if (!(s.st_mode & S_IFDIR)) {
+            throw std::runtime_error(std::string("The capture path is not a directory: ") + this->directory);
+        }
+    }
+
+    /**
+     * Observes the outcome of a test and checks whether the list must be captured
+     * @param test_id The id of the test, in the range [0, num_tests)
+     * @param outcome The outcome of the test
+     * @return True if the list must be captured
+     */
+    bool
+    observe(std::size_t test_id, const TestOutcome &outcome) {
+        if (this->num_captured.load() >= this->limit) {
+            return false;
+        }
+        bool slow = (this->threshold > 0 && outcome.total_time > this->threshold);
+        if (this->percentile > 0) {
+            const std::uint64_t time = static_cast<std::uint64_t>(outcome.total_time * 1e6 + 0.5);
+            std::lock_guard<std::mutex> lock(this->histograms_mutex);
+            LatencyHistogram &histogram = this->histograms[test_id];
+            if (histogram.count() >= OutlierCapture::min_observations && time > histogram.value_at_percentile(this->percentile)) {
+                slow = true;
+            }
+            histogram.record(time);
+        }
+        return slow;
+    }
+
+    /**
+     * Writes the list and the description of the test in the capture directory, unless the limit has been reached
+     * @param list The list
+     * @param n The number of elements of the list assessed
+     * @param k The number of elements to select
+     * @param list_id The id of the list in the assessment
+     * @param source The file containing the list, or an empty string
+     * @param test The test
+     * @param outcome The outcome of the test
+     */
+    template <typename ScoreFun>
+    void
+    capture(const ResultsList &list, index_type n, k_type k, std::size_t list_id, const std::string &source,
+            const PrunerFilterCompositionTest<ScoreFun> &test, const TestOutcome &outcome) {
+        const std::size_t capture_id = this->num_captured++;
+        if (capture_id >= this->limit) {
+            return;
+        }
+
+        std::ostringstream base_name;
+        base_name << "capture-" << capture_id << "-list" << list_id << "-n" << n << "-k" << k;
+        CapturedList captured;
+        captured.metric = this->metric;
+        captured.test_name = test.name;
+        captured.epsilon = static_cast<score_type>(test.epsilon_below);
+        captured.n = n;
+        captured.k = k;
+        captured.list_id = list_id;
+        captured.source = source;
+        captured.list_file = base_name.str() + ".tsv";
+        captured.outcome = outcome;
+
+        std::ofstream list_stream(this->directory + "/" + captured.list_file);
+        write_results_list_tsv(list_stream, list, n);
+        std::ofstream description_stream(this->directory + "/" + base_name.str() + ".json");
+        write_captured_list(description_stream, captured);
+        if (!list_stream || !description_stream) {
+            throw std::runtime_error(std::string("Unable to write the captured list ") + base_name.str());
+        }
+    }
+
+    /**
+     * Number of lists captured
+     */
+    std::size_t
+    size() const {
+        return std::min(this->num_captured.load(), this->limit);
+    }
+
+private:
+    const std::string directory;
+    const std::string metric;
+    const double threshold;
+    const double percentile;
+    const std::size_t limit;
+    std::atomic<std::size_t> num_captured{0};
+    std::mutex histograms_mutex;
+    std::vector<LatencyHistogram> histograms;
+};
+
+
+#endif //UTILS_CAPTURE_HPP
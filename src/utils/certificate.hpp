@@ -0,0 +1,59 @@
+#ifndef UTILS_CERTIFICATE_HPP
+#define UTILS_CERTIFICATE_HPP
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include "../filtering/types.hpp"
+#include "../pruners/pruner_epspruning.hpp"
+
+
+/**
+ * Computes an upper bound on the optimal score of a list pruned by the epsilon pruning, given the score of the
+ * optimal solution of its elements not pruned.
+ * The gain of each element of the list is bounded by its own gain, if it was not pruned, or by the gain of the
+ * threshold of its level, if it was pruned, and the score of any solution is at most the sum of the k largest bounds,
+ * in decreasing order, times the discounts in increasing position. The bound is also at most score / (1 - epsilon),
+ * the guarantee of the pruning.
+ * It costs O((m + l k) log k), where m is the number of elements not pruned and l the number of levels.
+ * @tparam ScoreFun Score function type
+ * @param score_fun The score function
+ * @param k Maximum number of elements of the solutions
+ * @param epsilon The maximum approximation error of the pruning
+ * @param score The score of the optimal solution of the elements not pruned
+ * @param candidates The relevances of the elements not pruned
+ * @param num_candidates The number of elements not pruned
+ * @param levels The thresholds applied by the pruning
+ * @param minmax_element The pair containing the min and maximum elements of the list
+ * @return The upper bound
+ */
+template <typename ScoreFun>
+score_type
+certified_upper_bound(const ScoreFun &score_fun, k_type k, score_type epsilon, score_type score,
+                      const relevance_type *candidates, index_type num_candidates, const PruningLevels &levels,
+                      const minmax_type &minmax_element) {
+    // the k largest relevances, with the threshold of a level repeated up to k times
+    std::vector<relevance_type> bounds(candidates, candidates + num_candidates);
+    for (std::size_t l = 0; l < levels.thresholds.size(); ++l) {
+        const relevance_type threshold = std::min(levels.thresholds[l], minmax_element.max);
+        bounds.insert(bounds.end(), std::min<std::size_t>(levels.num_pruned[l], k), threshold);
+    }
+    const std::size_t num_bounds = std::min<std::size_t>(bounds.size(), k);
+    std::partial_sort(bounds.begin(), bounds.begin() + num_bounds, bounds.end(), std::greater<relevance_type>());
+
+    double upper_bound = 0;
+    for (std::size_t j = 0; j < num_bounds; ++j) {
+        const score_type gain = score_fun.gain_factor(bounds[j]);
+        if (gain <= 0) {
+            break;
+        }
+        upper_bound += gain * score_fun.discount_factor(j + 1);
+    }
+    if (epsilon < 1) {
+        upper_bound = std::min(upper_bound, static_cast<double>(score) / (1 - epsilon));
+    }
+    return static_cast<score_type>(std::max(upper_bound, static_cast<double>(score)));
+}
+
+
+#endif //UTILS_CERTIFICATE_HPP
@@ -1,12 +1,25 @@
 #ifndef FILTERING_UTILS_ASSESSMENT_HPP
 #define FILTERING_UTILS_ASSESSMENT_HPP
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <memory>
+#include <ostream>
+#include <stdexcept>
 #include <string>
 #include <vector>
+#include "../data_structures/compensated_sum.hpp"
+#include "../data_structures/latency_histogram.hpp"
 #include "../filtering/filter.hpp"
+#include "../filtering/filtering_stats.hpp"
 #include "../filtering/pruner.hpp"
 #include "../filtering/types.hpp"
+#include "../pruners/pruner_epspruning.hpp"
+#include "../utils/certificate.hpp"
+#include "../utils/memory_accounting.hpp"
+#include "../utils/perf_counters.hpp"
+#include "../utils/trace.hpp"
 #include "../utils/utils.hpp"
 
 
@@ -30,6 +43,10 @@ typedef struct {
      * Num elements not pruned in the first stage
      */
     index_type num_elements_not_pruned = 0;
+    /**
+     * Number of intervals into which the epsilon pruning split the gains of the list, or zero for the other pruners
+     */
+    std::size_t num_intervals = 0;
     /**
      * Time spent in the first stage (pruning)
      */
@@ -42,55 +59,131 @@ typedef struct {
      * Time spent in filtering the list (pruning + filtering)
      */
     double total_time = 0;
+    /**
+     * Certified upper bound on the optimal score, if collected, or -1
+     */
+    score_type upper_bound = -1;
+    /**
+     * Hardware performance counters of the first stage (pruning), if collected
+     */
+    PerfCounterValues first_stage_counters;
+    /**
+     * Hardware performance counters of the second stage (filtering), if collected
+     */
+    PerfCounterValues second_stage_counters;
+    /**
+     * Heap memory allocated by the first stage (pruning and copy of the elements not pruned), if collected
+     */
+    MemoryUsage first_stage_memory;
+    /**
+     * Heap memory allocated by the second stage (filtering), if collected
+     */
+    MemoryUsage second_stage_memory;
+    /**
+     * Internal statistics of the pruner and of the filter, collected only when FILTERING_STATS is defined
+     */
+    FilteringStats stats;
 } TestOutcome;
 
 
 /**
  * Representation of a test on multiple lists.
+ * The aggregation keeps the number of lists and the sums of their outcomes, so that two aggregations computed
+ * independently (e.g., by different threads) can be merged together. The sums are compensated and the variances are
+ * computed with the algorithm of Welford, so that they stay accurate over billions of lists.
  */
 typedef struct tests_aggregation_outcome {
     /**
-     * Average score
+     * Number of lists aggregated, whose times have been measured
+     */
+    std::size_t num_lists = 0;
+    /**
+     * Mean and variance of the scores, including those of the lists whose test has not been run
      */
-    double avg_score = 0;
+    RunningMoments score;
     /**
      * Maximum approximation error
      */
     double max_approximation_error = 0;
     /**
-     * Average approximation error
+     * Mean and variance of the approximation errors
      */
-    double avg_approximation_error = 0;
+    RunningMoments approximation_error;
     /**
-     * Average number of elements pruned in the first stage
+     * Maximum certified error, i.e., one minus the ratio between the score and its certified upper bound
      */
-    double avg_num_elements_pruned = 0;
+    double max_certified_error = 0;
     /**
-     * Average number of elements not pruned in the first stage
+     * Mean and variance of the certified errors, over the lists whose upper bound has been certified
      */
-    double avg_num_elements_not_pruned = 0;
+    RunningMoments certified_error;
     /**
-     * Average time spent in the first stage (pruning)
+     * Sum of the number of elements pruned in the first stage
      */
-    double avg_first_stage_time = 0;
+    CompensatedSum sum_num_elements_pruned;
     /**
-     * Average time spent in the second stage (filtering)
+     * Sum of the number of elements not pruned in the first stage
      */
-    double avg_second_stage_time = 0;
+    CompensatedSum sum_num_elements_not_pruned;
     /**
-     * Average time spent in filtering the lists (pruning + filtering)
+     * Sum of the number of intervals of the epsilon pruning, which measures the spread of the gains of the lists
      */
-    double avg_total_time = 0;
+    CompensatedSum sum_num_intervals;
+    /**
+     * Sum of the times spent in the first stage (pruning)
+     */
+    CompensatedSum sum_first_stage_time;
+    /**
+     * Sum of the times spent in the second stage (filtering)
+     */
+    CompensatedSum sum_second_stage_time;
+    /**
+     * Mean and variance of the times spent in filtering the lists (pruning + filtering)
+     */
+    RunningMoments total_time;
+    /**
+     * Distribution of the times spent in the first stage (pruning), in nanoseconds
+     */
+    LatencyHistogram first_stage_latency;
+    /**
+     * Distribution of the times spent in the second stage (filtering), in nanoseconds
+     */
+    LatencyHistogram second_stage_latency;
+    /**
+     * Distribution of the times spent in filtering the lists (pruning + filtering), in nanoseconds
+     */
+    LatencyHistogram total_latency;
+    /**
+     * Sums of the hardware performance counters of the first stage (pruning)
+     */
+    PerfCounterSums first_stage_counters;
+    /**
+     * Sums of the hardware performance counters of the second stage (filtering)
+     */
+    PerfCounterSums second_stage_counters;
+    /**
+     * Sums of the heap memory allocated by the first stage (pruning)
+     */
+    MemoryUsageSums first_stage_memory;
+    /**
+     * Sums of the heap memory allocated by the second stage (filtering)
+     */
+    MemoryUsageSums second_stage_memory;
+    /**
+     * Sums of the internal statistics of the pruner and of the filter
+     */
+    FilteringStatsSums stats;
 
+    /**
+     * Adds the outcome of a test on a single list to the aggregation
+     * @param test_outcome The outcome of the test
+     * @param optimal_score The optimal score of the list, if available, used to compute the approximation error
+     */
     void
     update_aggregation(
             const TestOutcome &test_outcome,
-            const std::size_t num_lists_previously_assessed,
             const score_type optimal_score=-1
     ) {
-        double new_multiplier = 1.0 / (num_lists_previously_assessed + 1.0);
-        double old_multiplier = num_lists_previously_assessed * new_multiplier;
-
         double approximation_error = 0;
         if (optimal_score >= 0) {
             approximation_error = 1.0 - (test_outcome.score / optimal_score);
@@ -98,15 +191,95 @@ typedef struct tests_aggregation_outcome {
         if (approximation_error > this->max_approximation_error) {
             this->max_approximation_error = approximation_error;
         }
-        // This kind of averaging introduces some error in the computation, but guarantees to not overflow with a huge number of updates
-        this->avg_score = new_multiplier * test_outcome.score + old_multiplier * this->avg_score;
-        this->avg_approximation_error = new_multiplier * approximation_error + old_multiplier * this->avg_approximation_error;
-
-        this->avg_num_elements_pruned = new_multiplier * test_outcome.num_elements_pruned + old_multiplier * this->avg_num_elements_pruned;
-        this->avg_num_elements_not_pruned = new_multiplier * test_outcome.num_elements_not_pruned + old_multiplier * this->avg_num_elements_not_pruned;
-        this->avg_first_stage_time = new_multiplier * test_outcome.first_stage_time + old_multiplier * this->avg_first_stage_time;
-        this->avg_second_stage_time = new_multiplier * test_outcome.second_stage_time + old_multiplier * this->avg_second_stage_time;
-        this->avg_total_time = new_multiplier * test_outcome.total_time + old_multiplier * this->avg_total_time;
+
+        this->num_lists += 1;
+        this->score.add(test_outcome.score);
+        this->approximation_error.add(approximation_error);
+        if (test_outcome.upper_bound >= 0) {
+            const double certified_error = (test_outcome.upper_bound > 0) ? std::max(0.0, 1.0 - (test_outcome.score / test_outcome.upper_bound)) : 0.0;
+            if (certified_error > this->max_certified_error) {
+                this->max_certified_error = certified_error;
+            }
+            this->certified_error.add(certified_error);
+        }
+        this->sum_num_elements_pruned.add(test_outcome.num_elements_pruned);
+        this->sum_num_elements_not_pruned.add(test_outcome.num_elements_not_pruned);
+        this->sum_num_intervals.add(test_outcome.num_intervals);
+        this->sum_first_stage_time.add(test_outcome.first_stage_time);
+        this->sum_second_stage_time.add(test_outcome.second_stage_time);
+        this->total_time.add(test_outcome.total_time);
+        this->first_stage_latency.record(to_nanoseconds(test_outcome.first_stage_time));
+        this->second_stage_latency.record(to_nanoseconds(test_outcome.second_stage_time));
+        this->total_latency.record(to_nanoseconds(test_outcome.total_time));
+        this->first_stage_counters.add(test_outcome.first_stage_counters);
+        this->second_stage_counters.add(test_outcome.second_stage_counters);
+        this->first_stage_memory.add(test_outcome.first_stage_memory);
+        this->second_stage_memory.add(test_outcome.second_stage_memory);
+        this->stats.add(test_outcome.stats);
+    }
+
+    /**
+     * Adds the score of a list whose test has not been run, e.g., because its optimal solution has been found in the
+     * OPT cache, leaving untouched the aggregations of the times, of the pruning, of the memory, and of the counters
+     * @param score The score of the list
+     */
+    void
+    update_score(const score_type score) {
+        this->score.add(score);
+        this->approximation_error.add(0);
+    }
+
+    /**
+     * Merges another aggregation into this one.
+     * The floating point sums are not associative, thus the merge order must be fixed to obtain reproducible results.
+     * @param other The aggregation to merge
+     */
+    void
+    merge(const struct tests_aggregation_outcome &other) {
+        if (other.max_approximation_error > this->max_approximation_error) {
+            this->max_approximation_error = other.max_approximation_error;
+        }
+
+        this->num_lists += other.num_lists;
+        this->score.merge(other.score);
+        this->approximation_error.merge(other.approximation_error);
+        if (other.max_certified_error > this->max_certified_error) {
+            this->max_certified_error = other.max_certified_error;
+        }
+        this->certified_error.merge(other.certified_error);
+        this->sum_num_elements_pruned.merge(other.sum_num_elements_pruned);
+        this->sum_num_elements_not_pruned.merge(other.sum_num_elements_not_pruned);
+        this->sum_num_intervals.merge(other.sum_num_intervals);
+        this->sum_first_stage_time.merge(other.sum_first_stage_time);
+        this->sum_second_stage_time.merge(other.sum_second_stage_time);
+        this->total_time.merge(other.total_time);
+        this->first_stage_latency.merge(other.first_stage_latency);
+        this->second_stage_latency.merge(other.second_stage_latency);
+        this->total_latency.merge(other.total_latency);
+        this->first_stage_counters.merge(other.first_stage_counters);
+        this->second_stage_counters.merge(other.second_stage_counters);
+        this->first_stage_memory.merge(other.first_stage_memory);
+        this->second_stage_memory.merge(other.second_stage_memory);
+        this->stats.merge(other.stats);
+    }
+
+    /**
+     * Averages the given sum over the number of lists aggregated
+     * @param sum One of the sums of the aggregation
+     * @return The average value, or zero if no list has been aggregated
+     */
+    double
+    average(double sum) const {
+        return (this->num_lists > 0) ? sum / this->num_lists : 0.0;
+    }
+
+    /**
+     * Sample standard deviation of the times spent in filtering the lists
+     * @return The standard deviation, or zero if less than two lists have been aggregated
+     */
+    double
+    stddev_total_time() const {
+        return std::sqrt(this->total_time.variance());
     }
 
     /**
@@ -118,18 +291,78 @@ typedef struct tests_aggregation_outcome {
     friend std::ostream & operator<<(std::ostream &os, const struct tests_aggregation_outcome &outcome) {
         os << "{";
 
-        os << "\"avg_score\": " << outcome.avg_score;
+        os << "\"avg_score\": " << outcome.score.mean();
+        if (outcome.num_lists == 0 && outcome.score.count() > 0) {
+            // no list has been timed, e.g., all optimal solutions have been found in the OPT cache
+            os << ", \"max_approximation_error\": " << outcome.max_approximation_error;
+            os << ", \"avg_approximation_error\": " << outcome.approximation_error.mean();
+            os << ", \"num_timed_lists\": 0";
+            os << "}";
+            return os;
+        }
         os << ", \"max_approximation_error\": " << outcome.max_approximation_error;
-        os << ", \"avg_approximation_error\": " << outcome.avg_approximation_error;
-        os << ", \"avg_num_elements_pruned\": " << outcome.avg_num_elements_pruned;
-        os << ", \"avg_num_elements_not_pruned\": " << outcome.avg_num_elements_not_pruned;
-        os << ", \"avg_first_stage_time\": " << outcome.avg_first_stage_time;
-        os << ", \"avg_second_stage_time\": " << outcome.avg_second_stage_time;
-        os << ", \"avg_total_time\": " << outcome.avg_total_time;
+        os << ", \"avg_approximation_error\": " << outcome.approximation_error.mean();
+        if (outcome.certified_error.count() > 0) {
+            os << ", \"max_certified_error\": " << outcome.max_certified_error;
+            os << ", \"avg_certified_error\": " << outcome.certified_error.mean();
+        }
+        os << ", \"avg_num_elements_pruned\": " << outcome.average(outcome.sum_num_elements_pruned.value());
+        os << ", \"avg_num_elements_not_pruned\": " << outcome.average(outcome.sum_num_elements_not_pruned.value());
+        if (outcome.sum_num_intervals.value() > 0) {
+            os << ", \"avg_num_intervals\": " << outcome.average(outcome.sum_num_intervals.value());
+        }
+        os << ", \"avg_first_stage_time\": " << outcome.average(outcome.sum_first_stage_time.value());
+        os << ", \"avg_second_stage_time\": " << outcome.average(outcome.sum_second_stage_time.value());
+        os << ", \"avg_total_time\": " << outcome.total_time.mean();
+        os << ", \"stddev_total_time\": " << outcome.stddev_total_time();
+        os << ", \"first_stage_time_percentiles\": "; write_percentiles(os, outcome.first_stage_latency);
+        os << ", \"second_stage_time_percentiles\": "; write_percentiles(os, outcome.second_stage_latency);
+        os << ", \"total_time_percentiles\": "; write_percentiles(os, outcome.total_latency);
+        if (!outcome.first_stage_memory.empty()) {
+            os << ", \"first_stage_memory\": " << outcome.first_stage_memory;
+        }
+        if (!outcome.second_stage_memory.empty()) {
+            os << ", \"second_stage_memory\": " << outcome.second_stage_memory;
+        }
+        if (!outcome.stats.empty()) {
+            os << ", \"stats\": " << outcome.stats;
+        }
+        if (!outcome.first_stage_counters.empty()) {
+            os << ", \"avg_first_stage_counters\": " << outcome.first_stage_counters;
+        }
+        if (!outcome.second_stage_counters.empty()) {
+            os << ", \"avg_second_stage_counters\": " << outcome.second_stage_counters;
+        }
 
         os << "}";
         return os;
     }
+
+    /**
+     * Converts a time in milliseconds into nanoseconds
+     * @param milliseconds The time in milliseconds
+     * @return The time in nanoseconds
+     */
+    static std::uint64_t
+    to_nanoseconds(double milliseconds) {
+        return (milliseconds > 0) ? static_cast<std::uint64_t>(std::llround(milliseconds * 1000000.0)) : 0;
+    }
+
+    /**
+     * Writes on the output stream a json object with the main percentiles of a latency distribution, in milliseconds
+     * @param os the output stream where to write
+     * @param histogram the latency distribution, in nanoseconds
+     */
+    static void
+    write_percentiles(std::ostream &os, const LatencyHistogram &histogram) {
+        os << "{";
+        os << "\"p50\": " << histogram.value_at_percentile(50.0) / 1000000.0;
+        os << ", \"p90\": " << histogram.value_at_percentile(90.0) / 1000000.0;
+        os << ", \"p99\": " << histogram.value_at_percentile(99.0) / 1000000.0;
+        os << ", \"p99.9\": " << histogram.value_at_percentile(99.9) / 1000000.0;
+        os << ", \"max\": " << histogram.max() / 1000000.0;
+        os << "}";
+    }
 } TestsAggregationOutcome;
 
 
@@ -199,6 +432,10 @@ public:
         if (epsilon_above < 0) {
             throw std::invalid_argument("The parameter epsilon_above must be a positive floating number");
         }
+        this->eps_pruner = dynamic_cast<const PrunerEpsPruning<ScoreFun> *>(this->pruner.get());
+        if (this->eps_pruner != nullptr) {
+            this->trace_epsilon = this->eps_pruner->epsilon;
+        }
     }
 
     /**
@@ -207,47 +444,205 @@ public:
     virtual
     ~PrunerFilterCompositionTest() {}
 
+    /**
+     * Enables or disables the collection of the hardware performance counters of each stage
+     * @param enabled True to collect the counters
+     */
+    void
+    set_collect_perf_counters(bool enabled) {
+        this->collect_perf_counters = enabled;
+    }
+
+    /**
+     * Enables or disables the accounting of the heap memory allocated by each stage, during the first run
+     * @param enabled True to account the memory
+     */
+    void
+    set_collect_memory_usage(bool enabled) {
+        this->collect_memory_usage = enabled;
+    }
+
+    /**
+     * Enables or disables the certification of an upper bound on the optimal score of each list, derived from the
+     * guarantee of the pruner and, for the epsilon pruning, from the thresholds it applied
+     * @param enabled True to certify the upper bounds
+     */
+    void
+    set_collect_certificates(bool enabled) {
+        this->collect_certificates = enabled;
+    }
+
+    /**
+     * Sets the greatest number of cells of the table of the filter, i.e., the elements not pruned times k, above which
+     * a list is rejected before the filter allocates its table
+     * @param max_cells The greatest number of cells, or zero for no limit
+     */
+    void
+    set_max_filter_cells(std::size_t max_cells) {
+        this->max_filter_cells = max_cells;
+    }
+
+    /**
+     * Checks that the table of the filter on the given number of elements is within the limit set by set_max_filter_cells
+     * @param n Number of elements to filter
+     * @throws std::runtime_error if the table exceeds the limit
+     */
+    void
+    check_filter_cells(index_type n) const {
+        if (this->max_filter_cells > 0 && static_cast<std::size_t>(n) * this->filter->k > this->max_filter_cells) {
+            throw std::runtime_error("The table of the filter exceeds the memory limit, too many elements times k");
+        }
+    }
+
     /**
      * Filters the given list of relevances and returns a the outcome of the filtering@k.
+     * Each stage is repeated num_runs times back-to-back and its time is averaged over the runs.
      * @param rel_list List containing the relevance scores, ordered according to some attribute
      * @param n Number of elements of rel_list
+     * @param list_id The id of the list, which tags the spans of the trace, or -1 for the current list of the thread
      * @return The filtering solution built on top of the given list of relevances
      */
     virtual TestOutcome
-    operator()(const relevance_type * rel_list, const index_type n, const minmax_type &minmax_element) {
+    operator()(const relevance_type * rel_list, const index_type n, const minmax_type &minmax_element, std::int64_t list_id=-1) {
+        return this->run_stages(rel_list, n, minmax_element, this->num_runs, list_id);
+    }
+
+    /**
+     * Filters the given list of relevances and returns a the outcome of the filtering@k, running each stage once.
+     * @param rel_list List containing the relevance scores, ordered according to some attribute
+     * @param n Number of elements of rel_list
+     * @param list_id The id of the list, which tags the spans of the trace, or -1 for the current list of the thread
+     * @return The filtering solution built on top of the given list of relevances
+     */
+    TestOutcome
+    run_once(const relevance_type * rel_list, const index_type n, const minmax_type &minmax_element, std::int64_t list_id=-1) {
+        return this->run_stages(rel_list, n, minmax_element, 1, list_id);
+    }
+
+protected:
+    /**
+     * Filters the given list of relevances and returns a the outcome of the filtering@k.
+     * @param rel_list List containing the relevance scores, ordered according to some attribute
+     * @param n Number of elements of rel_list
+     * @param num_runs The number of times each stage is repeated back-to-back
+     * @param list_id The id of the list, which tags the spans of the trace, or -1 for the current list of the thread
+     * @return The filtering solution built on top of the given list of relevances
+     */
+    TestOutcome
+    run_stages(const relevance_type * rel_list, const index_type n, const minmax_type &minmax_element, const int num_runs, std::int64_t list_id) {
         TestOutcome solution;
         FilterSolution filteringSolution;
+        const PerfCounterGroup *counters = this->collect_perf_counters ? &PerfCounterGroup::thread_instance() : nullptr;
+        PerfCounterValues counters_start;
 
         if (this->pruner.get() != nullptr) {
-            // First stage
-            solution.first_stage_time = get_time_milliseconds();
-
-            PrunerSolution pruningSolution = this->pruner->operator()(rel_list, n, minmax_element);
-            for (int run = 1; run < this->num_runs; ++run) {
+            // the thresholds of the epsilon pruning certify the upper bound; with a single run, as when serving, they
+            // are recorded by the timed run, otherwise by a further run outside of the timed ones
+            const PrunerEpsPruning<ScoreFun> *certifying_pruner = this->collect_certificates ? this->eps_pruner : nullptr;
+            PruningLevels levels;
+            PruningLevels *timed_levels = (certifying_pruner != nullptr && num_runs == 1) ? &levels : nullptr;
+
+            // First stage, each run is timed on its own to subtract the overhead of every time measurement
+            TraceSpan prune_span("prune", n, this->filter->k, this->trace_epsilon, this->name.c_str(), list_id);
+            if (counters != nullptr) {
+                counters_start = counters->read();
+            }
+            if (this->collect_memory_usage) {
+                MemoryAccounting::start();
+            }
+#ifdef FILTERING_STATS
+            FilteringStats::thread_instance().clear();
+#endif
+            std::uint64_t start = get_time_nanoseconds();
+            PrunerSolution pruningSolution = (timed_levels != nullptr) ? certifying_pruner->operator()(rel_list, n, minmax_element, timed_levels)
+                                                                       : this->pruner->operator()(rel_list, n, minmax_element);
+            solution.first_stage_time = get_elapsed_milliseconds(start, get_time_nanoseconds());
+#ifdef FILTERING_STATS
+            solution.stats.merge(FilteringStats::thread_instance());
+#endif
+            if (this->collect_memory_usage) {
+                // paused during the other runs, and resumed for the copy of the elements not pruned
+                MemoryAccounting::stop();
+            }
+            for (int run = 1; run < num_runs; ++run) {
+                start = get_time_nanoseconds();
                 doNotOptimizeAway(this->pruner->operator()(rel_list, n, minmax_element).size());
+                solution.first_stage_time += get_elapsed_milliseconds(start, get_time_nanoseconds());
             }
 
-            solution.first_stage_time = (get_time_milliseconds() - solution.first_stage_time) / this->num_runs;
+            if (counters != nullptr) {
+                solution.first_stage_counters = counters->read() - counters_start;
+                solution.first_stage_counters /= num_runs;
+            }
+            solution.first_stage_time /= num_runs;
+            prune_span.end();
 
             index_type n2 = pruningSolution.size();
             solution.num_elements_pruned = n - n2;
             solution.num_elements_not_pruned = n2;
+            if (this->eps_pruner != nullptr) {
+                solution.num_intervals = this->eps_pruner->num_intervals(minmax_element);
+            }
+            this->check_filter_cells(n2);
 
             // create the list for the second stage
+            TraceSpan gather_span("gather", n2, this->filter->k, this->trace_epsilon, this->name.c_str(), list_id);
+            if (this->collect_memory_usage) {
+                MemoryAccounting::resume();
+            }
             relevance_type *new_rel_list = new relevance_type[n2];
             for (index_type i = 0; i < n2; ++i) {
                 new_rel_list[i] = rel_list[pruningSolution.indices[i]];
             }
+            if (this->collect_memory_usage) {
+                solution.first_stage_memory = MemoryAccounting::stop();
+            }
+            gather_span.end();
 
             // Second stage
-            solution.second_stage_time = get_time_milliseconds();
-
+            TraceSpan filter_span("filter", n2, this->filter->k, this->trace_epsilon, this->name.c_str(), list_id);
+            if (counters != nullptr) {
+                counters_start = counters->read();
+            }
+            if (this->collect_memory_usage) {
+                MemoryAccounting::start();
+            }
+#ifdef FILTERING_STATS
+            FilteringStats::thread_instance().clear();
+#endif
+            start = get_time_nanoseconds();
             filteringSolution = this->filter->operator()(new_rel_list, n2);
-            for (int run=1; run < this->num_runs; ++run) {
+            solution.second_stage_time = get_elapsed_milliseconds(start, get_time_nanoseconds());
+#ifdef FILTERING_STATS
+            solution.stats.merge(FilteringStats::thread_instance());
+#endif
+            if (this->collect_memory_usage) {
+                solution.second_stage_memory = MemoryAccounting::stop();
+            }
+            for (int run=1; run < num_runs; ++run) {
+                start = get_time_nanoseconds();
                 doNotOptimizeAway(this->filter->operator()(new_rel_list, n2).size());
+                solution.second_stage_time += get_elapsed_milliseconds(start, get_time_nanoseconds());
             }
 
-            solution.second_stage_time = (get_time_milliseconds() - solution.second_stage_time) / this->num_runs;
+            if (counters != nullptr) {
+                solution.second_stage_counters = counters->read() - counters_start;
+                solution.second_stage_counters /= num_runs;
+            }
+            solution.second_stage_time /= num_runs;
+            filter_span.end();
+
+            if (this->collect_certificates) {
+                if (certifying_pruner != nullptr) {
+                    if (timed_levels == nullptr) {
+                        certifying_pruner->operator()(rel_list, n, minmax_element, &levels);
+                    }
+                    solution.upper_bound = certified_upper_bound(*certifying_pruner->score_fun, certifying_pruner->k, certifying_pruner->epsilon,
+                                                                 filteringSolution.score, new_rel_list, n2, levels, minmax_element);
+                } else if (this->epsilon_below < 1) {
+                    solution.upper_bound = filteringSolution.score / (1 - this->epsilon_below);
+                }
+            }
             delete[](new_rel_list);
 
             // update the indices according to the results of the first stage
@@ -255,15 +650,44 @@ public:
                 filteringSolution.indices[i] = pruningSolution.indices[filteringSolution.indices[i]];
             }
         } else {
-            // Second stage
-            solution.second_stage_time = get_time_milliseconds();
+            this->check_filter_cells(n);
 
+            // Second stage
+            TraceSpan filter_span("filter", n, this->filter->k, this->trace_epsilon, this->name.c_str(), list_id);
+            if (counters != nullptr) {
+                counters_start = counters->read();
+            }
+            if (this->collect_memory_usage) {
+                MemoryAccounting::start();
+            }
+#ifdef FILTERING_STATS
+            FilteringStats::thread_instance().clear();
+#endif
+            std::uint64_t start = get_time_nanoseconds();
             filteringSolution = this->filter->operator()(rel_list, n);
-            for (int run=1; run < this->num_runs; ++run) {
+            solution.second_stage_time = get_elapsed_milliseconds(start, get_time_nanoseconds());
+#ifdef FILTERING_STATS
+            solution.stats.merge(FilteringStats::thread_instance());
+#endif
+            if (this->collect_memory_usage) {
+                solution.second_stage_memory = MemoryAccounting::stop();
+            }
+            for (int run=1; run < num_runs; ++run) {
+                start = get_time_nanoseconds();
                 doNotOptimizeAway(this->filter->operator()(rel_list, n).size());
+                solution.second_stage_time += get_elapsed_milliseconds(start, get_time_nanoseconds());
+            }
+
+            if (counters != nullptr) {
+                solution.second_stage_counters = counters->read() - counters_start;
+                solution.second_stage_counters /= num_runs;
             }
+            solution.second_stage_time /= num_runs;
 
-            solution.second_stage_time = (get_time_milliseconds() - solution.second_stage_time) / this->num_runs;
+            // the filter is optimal
+            if (this->collect_certificates) {
+                solution.upper_bound = filteringSolution.score;
+            }
         }
 
         // fill the remaining properties
@@ -273,6 +697,32 @@ public:
 
         return solution;
     }
+
+private:
+    /**
+     * Whether to collect the hardware performance counters of each stage
+     */
+    bool collect_perf_counters = false;
+    /**
+     * Whether to account the heap memory allocated by each stage
+     */
+    bool collect_memory_usage = false;
+    /**
+     * Whether to certify an upper bound on the optimal score of each list
+     */
+    bool collect_certificates = false;
+    /**
+     * Approximation factor tagging the spans of the trace, only for the epsilon pruning, or a negative number
+     */
+    double trace_epsilon = -1;
+    /**
+     * The pruner, if it is the epsilon pruning, or nullptr
+     */
+    const PrunerEpsPruning<ScoreFun> *eps_pruner = nullptr;
+    /**
+     * Greatest number of cells of the table of the filter, or zero for no limit
+     */
+    std::size_t max_filter_cells = 0;
 };
 
 
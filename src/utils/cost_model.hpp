@@ -0,0 +1,603 @@
+#ifndef UTILS_COST_MODEL_HPP
+#define UTILS_COST_MODEL_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../filtering/types.hpp"
+#include "../pruners/pruner_epspruning.hpp"
+#include "json.hpp"
+#include "strategies.hpp"
+
+
+/**
+ * Cost model of a filtering strategy, i.e., the linear models of its number of elements not pruned, of its total
+ * time, and of its memory usage.
+ * The elements not pruned m are predicted as n for opt, as a fraction of n for cutoff, as a multiple of k for topk,
+ * and as a multiple of k times the number of intervals of the epsilon pruning for epsfiltering, with a multiple fitted
+ * for each epsilon, since the fraction of the intervals filled by the lists depends on it. The intervals are those of
+ * the list, given its minimum and maximum gains, if the reports contain their averages, and those of the worst case
+ * otherwise. The total time is
+ * predicted as time[0] + time[1] * n + time[2] * m * k, i.e., a constant, the scan of the list, and the table of the
+ * filter, and the memory as memory[0] + memory[1] * m + memory[2] * m * k.
+ */
+typedef struct strategy_cost_model {
+    /**
+     * The strategy: opt, cutoff, topk, or epsfiltering
+     */
+    std::string strategy;
+    /**
+     * Coefficient of the prediction of the elements not pruned
+     */
+    double candidates = 1;
+    /**
+     * Coefficient of the prediction of the elements not pruned for each epsilon of epsfiltering, used instead of
+     * candidates, with the predictions interpolated between the epsilons fitted
+     */
+    std::map<score_type, double> epsilon_candidates;
+    /**
+     * Whether the elements not pruned by epsfiltering have been fitted on the intervals of the lists, thus are
+     * predicted on the intervals of the list to plan, or on the intervals of the worst case
+     */
+    bool list_intervals = false;
+    /**
+     * Coefficients of the prediction of the total time, in milliseconds
+     */
+    double time[3] = {0, 0, 0};
+    /**
+     * Coefficients of the prediction of the memory usage, in bytes
+     */
+    double memory[3] = {0, 0, 0};
+    /**
+     * Whether the memory usage has been fitted, i.e., the reports contained it
+     */
+    bool has_memory = false;
+    /**
+     * Number of pairs (n_cut, k) and epsilons the model has been fitted on
+     */
+    std::size_t num_samples = 0;
+    /**
+     * Root mean square of the relative errors of the predicted times on the samples
+     */
+    double time_error = 0;
+
+    /**
+     * Writes on the output stream a json representation of the model
+     * @param os the output stream where to write
+     * @param model the model to write
+     * @return the output stream
+     */
+    friend std::ostream & operator<<(std::ostream &os, const struct strategy_cost_model &model) {
+        os << "{";
+        os << "\"candidates\": " << model.candidates;
+        if (!model.epsilon_candidates.empty()) {
+            os << ", \"epsilon_candidates\": [";
+            for (auto it = model.epsilon_candidates.begin(); it != model.epsilon_candidates.end(); ++it) {
+                os << (it == model.epsilon_candidates.begin() ? "" : ", ") << "[" << it->first << ", " << it->second << "]";
+            }
+            os << "]";
+        }
+        if (model.list_intervals) {
+            os << ", \"list_intervals\": true";
+        }
+        os << ", \"time\": [" << model.time[0] << ", " << model.time[1] << ", " << model.time[2] << "]";
+        if (model.has_memory) {
+            os << ", \"memory\": [" << model.memory[0] << ", " << model.memory[1] << ", " << model.memory[2] << "]";
+        }
+        os << ", \"num_samples\": " << model.num_samples;
+        os << ", \"time_error\": " << model.time_error;
+        os << "}";
+        return os;
+    }
+} StrategyCostModel;
+
+
+/**
+ * Strategy chosen for a list by the cost model.
+ */
+typedef struct strategy_plan {
+    /**
+     * The strategy: opt, cutoff, topk, or epsfiltering
+     */
+    std::string strategy;
+    /**
+     * The approximation factor of the strategy, used only by epsfiltering
+     */
+    score_type epsilon = 0;
+    /**
+     * Predicted number of elements not pruned
+     */
+    double predicted_candidates = 0;
+    /**
+     * Predicted total time, in milliseconds
+     */
+    double predicted_time = 0;
+    /**
+     * Predicted memory usage, in bytes, or zero if the model does not predict it
+     */
+    double predicted_memory = 0;
+    /**
+     * Whether the strategy is predicted to meet the latency and memory targets
+     */
+    bool meets_targets = true;
+
+    /**
+     * Writes on the output stream a json representation of the plan
+     * @param os the output stream where to write
+     * @param plan the plan to write
+     * @return the output stream
+     */
+    friend std::ostream & operator<<(std::ostream &os, const struct strategy_plan &plan) {
+        os << "{";
+        os << "\"strategy\": ";
+        write_json_string(os, strategy_test_name(plan.strategy, plan.epsilon));
+        os << ", \"predicted_candidates\": " << plan.predicted_candidates;
+        os << ", \"predicted_time\": " << plan.predicted_time;
+        os << ", \"predicted_memory\": " << plan.predicted_memory;
+        os << ", \"meets_targets\": " << (plan.meets_targets ? "true" : "false");
+        os << "}";
+        return os;
+    }
+} StrategyPlan;
+
+
+/**
+ * Cost models of the filtering strategies for a metric, fitted on assessment reports, which choose the cheapest
+ * strategy for a list that guarantees a given approximation factor and is predicted to meet latency and memory
+ * targets.
+ * The elements not pruned by epsfiltering are fitted on the average number of intervals of the epsilon pruning on the
+ * lists of the reports, and predicted on the intervals of the list to plan, given by its minimum and maximum gains.
+ * The reports written before the number of intervals was recorded are fitted and predicted on the intervals of the
+ * worst case, which depend only on k and epsilon, thus assume that the lists to plan span the range of gains of the
+ * lists of the reports.
+ * @tparam ScoreFun Score function type
+ */
+template <typename ScoreFun>
+class CostModel {
+public:
+    /**
+     * Fits the cost models on assessment reports
+     * @param reports The json reports written by assessment or merge
+     * @throws std::runtime_error if the reports are not valid or do not contain the lengths of the lists
+     */
+    static CostModel
+    fit(const std::vector<JsonValue> &reports) {
+        std::map<std::string, std::vector<sample>> samples;
+        for (const JsonValue &report: reports) {
+            for (const JsonValue &cell: report.as_array()) {
+                const double n_cut = cell["n_cut"].as_number();
+                const double n = cell.has("avg_list_length") ? cell["avg_list_length"].as_number() : n_cut;
+                if (n <= 0) {
+                    throw std::runtime_error("The assessment report does not contain the lengths of the lists, which requires --scaling when n_cut is zero");
+                }
+                const k_type k = static_cast<k_type>(cell["k"].as_number());
+                for (const auto &test: cell["strategies"].as_object()) {
+                    // a strategy never timed, e.g., OPT with all solutions found in the OPT cache
+                    if (!test.second.has("avg_total_time")) {
+                        continue;
+                    }
+                    // a strategy whose times are below the resolution of the clock, which no linear model fits
+                    if (test.second["avg_total_time"].as_number() <= 0) {
+                        continue;
+                    }
+                    sample s;
+                    s.n = n;
+                    s.k = k;
+                    s.epsilon = test_epsilon(test.first);
+                    s.candidates = (test.second["avg_num_elements_not_pruned"].as_number() > 0) ? test.second["avg_num_elements_not_pruned"].as_number() : n;
+                    s.intervals = test.second.has("avg_num_intervals") ? test.second["avg_num_intervals"].as_number() : 0;
+                    s.time = test.second["avg_total_time"].as_number();
+                    s.memory = -1;
+                    for (const char *stage: {"first_stage_memory", "second_stage_memory"}) {
+                        if (test.second.has(stage)) {
+                            s.memory = std::max(s.memory, 0.0) + test.second[stage]["avg_peak_bytes"].as_number();
+                        }
+                    }
+                    samples[strategy_of_test_name(test.first)].push_back(s);
+                }
+            }
+        }
+        if (samples.empty()) {
+            throw std::runtime_error("The assessment reports contain no strategy with a positive total time");
+        }
+
+        CostModel cost_model;
+        for (auto &strategy_samples: samples) {
+            StrategyCostModel &model = cost_model.models[strategy_samples.first];
+            model.strategy = strategy_samples.first;
+            model.num_samples = strategy_samples.second.size();
+            model.list_intervals = (model.strategy == "epsfiltering");
+            for (const sample &s: strategy_samples.second) {
+                model.list_intervals = model.list_intervals && s.intervals > 0;
+            }
+
+            // ratio estimators of the elements not pruned, overall and for each epsilon of epsfiltering
+            double sum_candidates = 0, sum_features = 0;
+            std::map<score_type, std::pair<double, double>> epsilon_sums;
+            for (const sample &s: strategy_samples.second) {
+                const double intervals = (model.strategy != "epsfiltering") ? 0 : model.list_intervals ? s.intervals :
+                                         CostModel::num_intervals(s.k, s.epsilon, CostModel::worst_case(s.k));
+                const double feature = CostModel::candidates_feature(model.strategy, s.n, s.k, intervals);
+                sum_candidates += s.candidates;
+                sum_features += feature;
+                if (model.strategy == "epsfiltering") {
+                    epsilon_sums[s.epsilon].first += s.candidates;
+                    epsilon_sums[s.epsilon].second += feature;
+                }
+            }
+            model.candidates = (model.strategy == "opt" || sum_features <= 0) ? 1 : sum_candidates / sum_features;
+            for (const auto &sums: epsilon_sums) {
+                if (sums.second.second > 0) {
+                    model.epsilon_candidates[sums.first] = sums.second.first / sums.second.second;
+                }
+            }
+
+            // least squares of the times and of the memory usages, on the elements not pruned observed
+            std::vector<std::vector<double>> time_features, memory_features;
+            std::vector<double> times, memories;
+            for (const sample &s: strategy_samples.second) {
+                time_features.push_back({1.0, s.n, s.candidates * s.k});
+                times.push_back(s.time);
+                if (s.memory >= 0) {
+                    memory_features.push_back({1.0, s.candidates, s.candidates * s.k});
+                    memories.push_back(s.memory);
+                }
+            }
+            nonnegative_least_squares(time_features, times, model.time);
+            model.has_memory = !memories.empty();
+            if (model.has_memory) {
+                nonnegative_least_squares(memory_features, memories, model.memory);
+            }
+
+            double sum_errors = 0;
+            for (std::size_t i = 0; i < times.size(); ++i) {
+                const double predicted = dot(model.time, time_features[i]);
+                const double error = (times[i] > 0) ? (predicted - times[i]) / times[i] : 0;
+                sum_errors += error * error;
+            }
+            model.time_error = std::sqrt(sum_errors / times.size());
+        }
+        return cost_model;
+    }
+
+    /**
+     * Constructor, which reads the cost models written by operator<<
+     * @param document The json document
+     * @throws std::runtime_error if the document is not a cost model of the metric
+     */
+    explicit CostModel(const JsonValue &document) {
+        if (!document.has("format") || document["format"].as_string() != "cost_model") {
+            throw std::runtime_error("The json document is not a cost model");
+        }
+        if (document["metric"].as_string() != ScoreFun::name()) {
+            throw std::runtime_error(std::string("The cost model has been fitted with the metric ") + document["metric"].as_string());
+        }
+        for (const auto &strategy: document["strategies"].as_object()) {
+            StrategyCostModel &model = this->models[strategy.first];
+            model.strategy = strategy.first;
+            model.candidates = strategy.second["candidates"].as_number();
+            if (strategy.second.has("epsilon_candidates")) {
+                for (const JsonValue &pair: strategy.second["epsilon_candidates"].as_array()) {
+                    model.epsilon_candidates[static_cast<score_type>(pair[0].as_number())] = pair[1].as_number();
+                }
+            }
+            model.list_intervals = strategy.second.has("list_intervals") && strategy.second["list_intervals"].as_bool();
+            for (std::size_t i = 0; i < 3; ++i) {
+                model.time[i] = strategy.second["time"][i].as_number();
+            }
+            model.has_memory = strategy.second.has("memory");
+            if (model.has_memory) {
+                for (std::size_t i = 0; i < 3; ++i) {
+                    model.memory[i] = strategy.second["memory"][i].as_number();
+                }
+            }
+            model.num_samples = static_cast<std::size_t>(strategy.second["num_samples"].as_number());
+            model.time_error = strategy.second["time_error"].as_number();
+        }
+    }
+
+    /**
+     * Predicts the cost of a strategy on a list
+     * @param strategy The strategy: opt, cutoff, topk, or epsfiltering
+     * @param epsilon The approximation factor, used only by epsfiltering
+     * @param n Number of elements of the list
+     * @param minmax_element The pair containing the min and maximum elements of the list
+     * @param k Maximum number of elements to select
+     * @return The plan of the strategy, which meets no target
+     * @throws std::runtime_error if the strategy has not been fitted
+     */
+    StrategyPlan
+    predict(const std::string &strategy, score_type epsilon, index_type n, const minmax_type &minmax_element, k_type k) const {
+        auto it = this->models.find(strategy);
+        if (it == this->models.end()) {
+            throw std::runtime_error(std::string("The cost model does not contain the strategy ") + strategy);
+        }
+        const StrategyCostModel &model = it->second;
+        StrategyPlan plan;
+        plan.strategy = strategy;
+        plan.epsilon = (strategy == "epsfiltering") ? epsilon : 0;
+        plan.predicted_candidates = std::min(static_cast<double>(n), this->predict_candidates(model, n, minmax_element, k, epsilon));
+        plan.predicted_time = dot(model.time, {1.0, static_cast<double>(n), plan.predicted_candidates * k});
+        if (model.has_memory) {
+            plan.predicted_memory = dot(model.memory, {1.0, plan.predicted_candidates, plan.predicted_candidates * k});
+        }
+        return plan;
+    }
+
+    /**
+     * Chooses the strategy for a list: the fastest among those guaranteeing the approximation factor and predicted to
+     * meet the targets, or the fastest among those guaranteeing the approximation factor if none meets the targets.
+     * The guarantees are 0 for opt, epsilon for epsfiltering, 0.5 for topk and none for cutoff, and epsfiltering is
+     * planned with the largest epsilon allowed.
+     * @param n Number of elements of the list
+     * @param minmax_element The pair containing the min and maximum elements of the list
+     * @param k Maximum number of elements to select
+     * @param epsilon The maximum approximation factor allowed, in [0, 1]
+     * @param latency The latency target, in milliseconds, or zero for none
+     * @param memory The memory target, in bytes, or zero for none
+     * @return The plan
+     * @throws std::runtime_error if no strategy fitted guarantees the approximation factor
+     */
+    StrategyPlan
+    plan(index_type n, const minmax_type &minmax_element, k_type k, score_type epsilon, double latency=0, double memory=0) const {
+        std::vector<StrategyPlan> candidates;
+        for (const auto &model: this->models) {
+            const std::string &strategy = model.first;
+            if ((strategy == "epsfiltering" && epsilon > 0 && epsilon < 1) || (strategy == "topk" && epsilon >= 0.5)
+                    || (strategy == "cutoff" && epsilon >= 1) || strategy == "opt") {
+                candidates.push_back(this->predict(strategy, epsilon, n, minmax_element, k));
+            }
+        }
+        if (candidates.empty()) {
+            throw std::runtime_error("The cost model contains no strategy guaranteeing the approximation factor");
+        }
+        for (StrategyPlan &candidate: candidates) {
+            candidate.meets_targets = (latency <= 0 || candidate.predicted_time <= latency)
+                                      && (memory <= 0 || candidate.predicted_memory <= memory);
+        }
+        return *std::min_element(candidates.begin(), candidates.end(), [](const StrategyPlan &l, const StrategyPlan &r) {
+            if (l.meets_targets != r.meets_targets) {
+                return l.meets_targets;
+            }
+            return l.predicted_time < r.predicted_time;
+        });
+    }
+
+    /**
+     * Writes on the output stream a json representation of the cost models
+     * @param os the output stream where to write
+     * @param cost_model the cost models to write
+     * @return the output stream
+     */
+    friend std::ostream & operator<<(std::ostream &os, const CostModel &cost_model) {
+        os << "{\"format\": \"cost_model\", \"metric\": \"" << ScoreFun::name() << "\", \"strategies\": {";
+        bool first = true;
+        for (const auto &model: cost_model.models) {
+            os << (first ? "" : ", ");
+            write_json_string(os, model.first) << ": " << model.second;
+            first = false;
+        }
+        os << "}}";
+        return os;
+    }
+
+private:
+    /**
+     * Statistics of a strategy on a pair (n_cut, k) of a report
+     */
+    struct sample {
+        double n;
+        k_type k;
+        score_type epsilon;
+        double candidates;
+        double intervals;
+        double time;
+        double memory;
+    };
+
+    CostModel() = default;
+
+    /**
+     * Gets the epsilon of a test from its name
+     * @param name The name of the test, as returned by strategy_test_name
+     * @return The epsilon of epsfiltering, or zero
+     */
+    static score_type
+    test_epsilon(const std::string &name) {
+        const std::size_t pos = name.find("epsilon=");
+        return (pos != std::string::npos) ? std::stof(name.substr(pos + 8)) : 0;
+    }
+
+    /**
+     * Predicts the elements not pruned by a strategy. For epsfiltering fitted for several epsilons, the predictions of
+     * the nearest epsilons fitted below and above are interpolated linearly in log(epsilon), and outside their range
+     * the prediction of the nearest one is used, since the multiple of the feature fitted for an epsilon does not hold
+     * for the others
+     * @param model The cost model of the strategy
+     * @param n Number of elements of the list
+     * @param minmax_element The pair containing the min and maximum elements of the list
+     * @param k Maximum number of elements to select
+     * @param epsilon The approximation factor, used only by epsfiltering
+     * @return The predicted elements not pruned
+     */
+    double
+    predict_candidates(const StrategyCostModel &model, double n, const minmax_type &minmax_element, k_type k, score_type epsilon) const {
+        // the intervals of a list without gains are undefined, thus it is planned as the worst case
+        const bool list_intervals = model.list_intervals && ScoreFun(k).gain_factor(minmax_element.max) > 0;
+        auto predict = [&](score_type fitted_epsilon, double multiple) {
+            const double intervals = (model.strategy != "epsfiltering") ? 0 :
+                                     this->num_intervals(k, fitted_epsilon, list_intervals ? minmax_element : this->worst_case(k));
+            return multiple * this->candidates_feature(model.strategy, n, k, intervals);
+        };
+        if (model.epsilon_candidates.empty()) {
+            return predict(epsilon, model.candidates);
+        }
+        const auto upper = model.epsilon_candidates.lower_bound(epsilon);
+        if (upper == model.epsilon_candidates.end()) {
+            return predict(std::prev(upper)->first, std::prev(upper)->second);
+        }
+        if (upper == model.epsilon_candidates.begin() || upper->first == epsilon) {
+            return predict(upper->first, upper->second);
+        }
+        const auto lower = std::prev(upper);
+        const double t = std::log(epsilon / lower->first) / std::log(upper->first / lower->first);
+        const double lower_prediction = predict(lower->first, lower->second);
+        return lower_prediction + t * (predict(upper->first, upper->second) - lower_prediction);
+    }
+
+    /**
+     * Feature whose multiple predicts the elements not pruned by a strategy, the same when fitting and predicting
+     * @param strategy The strategy
+     * @param n Number of elements of the list
+     * @param k Maximum number of elements to select
+     * @param intervals The number of intervals of the epsilon pruning, used only by epsfiltering
+     * @return The feature
+     */
+    static double
+    candidates_feature(const std::string &strategy, double n, k_type k, double intervals) {
+        if (strategy == "topk") {
+            return k;
+        } else if (strategy == "epsfiltering") {
+            return (k < 2) ? k : k * intervals;
+        }
+        return n;
+    }
+
+    /**
+     * Number of intervals of the epsilon pruning on a list
+     * @param k Maximum number of elements to select
+     * @param epsilon The approximation factor
+     * @param minmax_element The pair containing the min and maximum elements of the list
+     * @return The number of intervals
+     */
+    static double
+    num_intervals(k_type k, score_type epsilon, const minmax_type &minmax_element) {
+        if (k < 2) {
+            return 1;
+        }
+        const PrunerEpsPruning<ScoreFun> pruner(std::make_shared<ScoreFun>(k), k, epsilon);
+        return static_cast<double>(pruner.num_intervals(minmax_element));
+    }
+
+    /**
+     * Minimum and maximum elements of the worst case of the epsilon pruning, a list whose minimum gain is zero
+     * @param k Maximum number of elements to select
+     * @return The pair of the worst case
+     */
+    static minmax_type
+    worst_case(k_type k) {
+        const ScoreFun score_fun(k);
+        minmax_type worst_case;
+        worst_case.min = score_fun.gain_factor_inverse(0);
+        worst_case.max = score_fun.gain_factor_inverse(1);
+        return worst_case;
+    }
+
+    static double
+    dot(const double coefficients[3], const std::vector<double> &features) {
+        return coefficients[0] * features[0] + coefficients[1] * features[1] + coefficients[2] * features[2];
+    }
+
+    /**
+     * Fits the nonnegative coefficients of a linear model with three features by least squares, removing the features
+     * whose coefficient would be negative, or that make the problem singular, and fitting again
+     * @param features The features of each sample
+     * @param values The value of each sample
+     * @param coefficients Where to store the coefficients
+     */
+    static void
+    nonnegative_least_squares(const std::vector<std::vector<double>> &features, const std::vector<double> &values, double coefficients[3]) {
+        bool active[3] = {true, true, true};
+        for (std::size_t iteration = 0; iteration < 4; ++iteration) {
+            // normal equations of the active features, scaled to avoid the cancellation among features of different magnitude
+            double scale[3];
+            for (std::size_t j = 0; j < 3; ++j) {
+                scale[j] = 0;
+                for (const std::vector<double> &f: features) {
+                    scale[j] = std::max(scale[j], std::fabs(f[j]));
+                }
+                scale[j] = (scale[j] > 0) ? scale[j] : 1;
+            }
+            double a[3][4] = {{0}};
+            for (std::size_t i = 0; i < features.size(); ++i) {
+                for (std::size_t r = 0; r < 3; ++r) {
+                    for (std::size_t c = 0; c < 3; ++c) {
+                        a[r][c] += (features[i][r] / scale[r]) * (features[i][c] / scale[c]);
+                    }
+                    a[r][3] += (features[i][r] / scale[r]) * values[i];
+                }
+            }
+            for (std::size_t j = 0; j < 3; ++j) {
+                if (!active[j]) {
+                    for (std::size_t c = 0; c < 4; ++c) {
+                        a[j][c] = 0;
+                        if (c < 3) {
+                            a[c][j] = 0;
+                        }
+                    }
+                    a[j][j] = 1;
+                }
+            }
+
+            // gaussian elimination with partial pivoting, dropping the features that make the problem singular
+            bool solved = true;
+            for (std::size_t c = 0; c < 3 && solved; ++c) {
+                std::size_t pivot = c;
+                for (std::size_t r = c + 1; r < 3; ++r) {
+                    if (std::fabs(a[r][c]) > std::fabs(a[pivot][c])) {
+                        pivot = r;
+                    }
+                }
+                if (std::fabs(a[pivot][c]) < 1e-12) {
+                    active[c] = false;
+                    solved = false;
+                    break;
+                }
+                std::swap(a[c], a[pivot]);
+                for (std::size_t r = 0; r < 3; ++r) {
+                    if (r != c) {
+                        const double factor = a[r][c] / a[c][c];
+                        for (std::size_t c2 = c; c2 < 4; ++c2) {
+                            a[r][c2] -= factor * a[c][c2];
+                        }
+                    }
+                }
+            }
+            if (!solved) {
+                continue;
+            }
+
+            bool nonnegative = true;
+            for (std::size_t j = 0; j < 3; ++j) {
+                coefficients[j] = active[j] ? a[j][3] / a[j][j] / scale[j] : 0;
+                if (coefficients[j] < 0) {
+                    active[j] = false;
+                    nonnegative = false;
+                }
+            }
+            if (nonnegative) {
+                return;
+            }
+        }
+
+        // fallback: the average value as a constant
+        double sum = 0;
+        for (double value: values) {
+            sum += value;
+        }
+        coefficients[0] = values.empty() ? 0 : sum / values.size();
+        coefficients[1] = coefficients[2] = 0;
+    }
+
+private:
+    std::map<std::string, StrategyCostModel> models;
+};
+
+
+#endif //UTILS_COST_MODEL_HPP
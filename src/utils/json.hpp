@@ -0,0 +1,402 @@
+#ifndef UTILS_JSON_HPP
+#define UTILS_JSON_HPP
+
+#include <cstdlib>
+#include <iomanip>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/**
+ * Minimal representation of a json value, used to read back the reports written by the tools of this project.
+ * The parser is lenient on the numbers and accepts also nan, inf and -inf, which are written by std::ostream.
+ */
+class JsonValue {
+public:
+    enum Type {
+        NULL_VALUE,
+        BOOLEAN,
+        NUMBER,
+        STRING,
+        ARRAY,
+        OBJECT
+    };
+
+    typedef std::vector<std::pair<std::string, JsonValue>> object_type;
+    typedef std::vector<JsonValue> array_type;
+
+public:
+    JsonValue() :
+            type_(NULL_VALUE) {
+    }
+
+    /**
+     * Parses a json document from the given input stream
+     * @param istream The input stream to read
+     * @return The json value
+     */
+    static JsonValue
+    parse(std::istream &istream) {
+        std::string text((std::istreambuf_iterator<char>(istream)), std::istreambuf_iterator<char>());
+        return JsonValue::parse(text);
+    }
+
+    /**
+     * Parses a json document from the given string
+     * @param text The string to parse
+     * @return The json value
+     */
+    static JsonValue
+    parse(const std::string &text) {
+        std::size_t pos = 0;
+        JsonValue value = JsonValue::parse_value(text, pos);
+        JsonValue::skip_spaces(text, pos);
+        if (pos != text.size()) {
+            throw std::runtime_error("Unable to parse the json document. Unexpected characters after the value");
+        }
+        return value;
+    }
+
+    Type
+    type() const {
+        return this->type_;
+    }
+
+    bool
+    is_null() const {
+        return this->type_ == NULL_VALUE;
+    }
+
+    bool
+    is_number() const {
+        return this->type_ == NUMBER;
+    }
+
+    bool
+    is_string() const {
+        return this->type_ == STRING;
+    }
+
+    bool
+    is_array() const {
+        return this->type_ == ARRAY;
+    }
+
+    bool
+    is_object() const {
+        return this->type_ == OBJECT;
+    }
+
+    bool
+    as_bool() const {
+        this->check_type(BOOLEAN, "boolean");
+        return this->boolean_;
+    }
+
+    double
+    as_number() const {
+        this->check_type(NUMBER, "number");
+        return this->number_;
+    }
+
+    const std::string &
+    as_string() const {
+        this->check_type(STRING, "string");
+        return this->string_;
+    }
+
+    const array_type &
+    as_array() const {
+        this->check_type(ARRAY, "array");
+        return this->array_;
+    }
+
+    const object_type &
+    as_object() const {
+        this->check_type(OBJECT, "object");
+        return this->object_;
+    }
+
+    /**
+     * Checks whether the object contains the given key
+     * @param key The key to search
+     * @return True if the value is an object containing the key
+     */
+    bool
+    has(const std::string &key) const {
+        if (this->type_ != OBJECT) {
+            return false;
+        }
+        for (const auto &member: this->object_) {
+            if (member.first == key) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Gets the value associated to the given key of the object
+     * @param key The key to search
+     * @return The value associated to the key
+     */
+    const JsonValue &
+    operator[](const std::string &key) const {
+        for (const auto &member: this->as_object()) {
+            if (member.first == key) {
+                return member.second;
+            }
+        }
+        throw std::runtime_error(std::string("The json object does not contain the key ") + key);
+    }
+
+    /**
+     * Gets the i-th element of the array
+     * @param i The position of the element
+     * @return The i-th element of the array
+     */
+    const JsonValue &
+    operator[](std::size_t i) const {
+        const array_type &array = this->as_array();
+        if (i >= array.size()) {
+            throw std::runtime_error("The json array index is out of range");
+        }
+        return array[i];
+    }
+
+    /**
+     * Number of elements of an array or of members of an object
+     */
+    std::size_t
+    size() const {
+        if (this->type_ == ARRAY) {
+            return this->array_.size();
+        }
+        return this->as_object().size();
+    }
+
+private:
+    void
+    check_type(Type type, const char *type_name) const {
+        if (this->type_ != type) {
+            throw std::runtime_error(std::string("The json value is not a ") + type_name);
+        }
+    }
+
+    static void
+    skip_spaces(const std::string &text, std::size_t &pos) {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) {
+            ++pos;
+        }
+    }
+
+    static bool
+    consume(const std::string &text, std::size_t &pos, const char *token) {
+        std::size_t len = std::char_traits<char>::length(token);
+        if (text.compare(pos, len, token) == 0) {
+            pos += len;
+            return true;
+        }
+        return false;
+    }
+
+    static JsonValue
+    parse_value(const std::string &text, std::size_t &pos) {
+        JsonValue::skip_spaces(text, pos);
+        if (pos >= text.size()) {
+            throw std::runtime_error("Unable to parse the json document. Unexpected end of the document");
+        }
+
+        JsonValue value;
+        const char c = text[pos];
+        if (c == '{') {
+            value.type_ = OBJECT;
+            ++pos;
+            JsonValue::skip_spaces(text, pos);
+            if (pos < text.size() && text[pos] == '}') {
+                ++pos;
+                return value;
+            }
+            while (true) {
+                JsonValue::skip_spaces(text, pos);
+                if (pos >= text.size() || text[pos] != '"') {
+                    throw std::runtime_error("Unable to parse the json document. An object key is missing");
+                }
+                std::string key = JsonValue::parse_string(text, pos);
+                JsonValue::skip_spaces(text, pos);
+                if (!JsonValue::consume(text, pos, ":")) {
+                    throw std::runtime_error("Unable to parse the json document. A colon is missing after the key " + key);
+                }
+                value.object_.emplace_back(std::move(key), JsonValue::parse_value(text, pos));
+                JsonValue::skip_spaces(text, pos);
+                if (JsonValue::consume(text, pos, ",")) {
+                    // allow the trailing comma
+                    JsonValue::skip_spaces(text, pos);
+                    if (JsonValue::consume(text, pos, "}")) {
+                        return value;
+                    }
+                    continue;
+                }
+                if (JsonValue::consume(text, pos, "}")) {
+                    return value;
+                }
+                throw std::runtime_error("Unable to parse the json document. A comma or a closed brace is missing");
+            }
+        } else if (c == '[') {
+            value.type_ = ARRAY;
+            ++pos;
+            JsonValue::skip_spaces(text, pos);
+            if (JsonValue::consume(text, pos, "]")) {
+                return value;
+            }
+            while (true) {
+                value.array_.push_back(JsonValue::parse_value(text, pos));
+                JsonValue::skip_spaces(text, pos);
+                if (JsonValue::consume(text, pos, ",")) {
+                    // allow the trailing comma
+                    JsonValue::skip_spaces(text, pos);
+                    if (JsonValue::consume(text, pos, "]")) {
+                        return value;
+                    }
+                    continue;
+                }
+                if (JsonValue::consume(text, pos, "]")) {
+                    return value;
+                }
+                throw std::runtime_error("Unable to parse the json document. A comma or a closed bracket is missing");
+            }
+        } else if (c == '"') {
+            value.type_ = STRING;
+            value.string_ = JsonValue::parse_string(text, pos);
+        } else if (JsonValue::consume(text, pos, "true")) {
+            value.type_ = BOOLEAN;
+            value.boolean_ = true;
+        } else if (JsonValue::consume(text, pos, "false")) {
+            value.type_ = BOOLEAN;
+            value.boolean_ = false;
+        } else if (JsonValue::consume(text, pos, "null")) {
+            value.type_ = NULL_VALUE;
+        } else {
+            value.type_ = NUMBER;
+            value.number_ = JsonValue::parse_number(text, pos);
+        }
+        return value;
+    }
+
+    static double
+    parse_number(const std::string &text, std::size_t &pos) {
+        if (JsonValue::consume(text, pos, "nan") || JsonValue::consume(text, pos, "-nan")) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        if (JsonValue::consume(text, pos, "inf")) {
+            return std::numeric_limits<double>::infinity();
+        }
+        if (JsonValue::consume(text, pos, "-inf")) {
+            return -std::numeric_limits<double>::infinity();
+        }
+        const char *begin = text.c_str() + pos;
+        char *end = nullptr;
+        double number = std::strtod(begin, &end);
+        if (end == begin) {
+            throw std::runtime_error("Unable to parse the json document. Unexpected character");
+        }
+        pos += end - begin;
+        return number;
+    }
+
+    static std::string
+    parse_string(const std::string &text, std::size_t &pos) {
+        std::string result;
+        ++pos;  // skip the opening quote
+        while (pos < text.size() && text[pos] != '"') {
+            char c = text[pos++];
+            if (c != '\\') {
+                result.push_back(c);
+                continue;
+            }
+            if (pos >= text.size()) {
+                break;
+            }
+            c = text[pos++];
+            switch (c) {
+                case 'b': result.push_back('\b'); break;
+                case 'f': result.push_back('\f'); break;
+                case 'n': result.push_back('\n'); break;
+                case 'r': result.push_back('\r'); break;
+                case 't': result.push_back('\t'); break;
+                case 'u': {
+                    if (pos + 4 > text.size()) {
+                        throw std::runtime_error("Unable to parse the json document. Invalid unicode escape");
+                    }
+                    unsigned long code = std::strtoul(text.substr(pos, 4).c_str(), nullptr, 16);
+                    pos += 4;
+                    // encode the code point in utf-8 (surrogate pairs are not supported)
+                    if (code < 0x80) {
+                        result.push_back(static_cast<char>(code));
+                    } else if (code < 0x800) {
+                        result.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                        result.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    } else {
+                        result.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                        result.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                        result.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    }
+                    break;
+                }
+                default: result.push_back(c); break;
+            }
+        }
+        if (pos >= text.size()) {
+            throw std::runtime_error("Unable to parse the json document. A string is not terminated");
+        }
+        ++pos;  // skip the closing quote
+        return result;
+    }
+
+private:
+    Type type_;
+    bool boolean_ = false;
+    double number_ = 0;
+    std::string string_;
+    array_type array_;
+    object_type object_;
+};
+
+
+/**
+ * Writes the given string as a json string, escaping the special characters
+ * @param os The output stream where to write
+ * @param str The string to write
+ * @return The output stream
+ */
+inline std::ostream &
+write_json_string(std::ostream &os, const std::string &str) {
+    os << '"';
+    for (char c: str) {
+        switch (c) {
+            case '"': os << "\\\""; break;
+            case '\\': os << "\\\\"; break;
+            case '\n': os << "\\n"; break;
+            case '\r': os << "\\r"; break;
+            case '\t': os << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+                } else {
+                    os << c;
+                }
+        }
+    }
+    os << '"';
+    return os;
+}
+
+
+#endif //UTILS_JSON_HPP
@@ -0,0 +1,276 @@
+#ifndef UTILS_LIST_LOG_HPP
+#define UTILS_LIST_LOG_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../filtering/types.hpp"
+#include "composition.hpp"
+#include "json.hpp"
+
+
+/**
+ * Writer of a file on a background thread. The producers, possibly many threads, append their data to a pending
+ * buffer, which is swapped with the one being written whenever it is full, so that they never wait for the disk
+ * unless the writer falls behind by more than a few buffers.
+ */
+class BackgroundWriter {
+public:
+    /**
+     * Number of full buffers that can be pending before the producers are blocked
+     */
+    static const std::size_t max_pending_buffers = 4;
+
+    /**
+     * Constructor, which opens the file and starts the writing thread
+     * @param file_path The path of the file
+     * @param buffer_size The number of bytes written at once
+     */
+    BackgroundWriter(const std::string &file_path, std::size_t buffer_size) :
+            file_path(file_path),
+            ostream(file_path, std::ios::out | std::ios::binary | std::ios::trunc),
+            buffer_size(buffer_size) {
+        if (!this->ostream.is_open()) {
+            throw std::runtime_error(std::string("Unable to open the file ") + file_path);
+        }
+        this->pending.reserve(this->buffer_size);
+        this->thread = std::thread(&BackgroundWriter::run, this);
+    }
+
+    BackgroundWriter(const BackgroundWriter &) = delete;
+    BackgroundWriter &operator=(const BackgroundWriter &) = delete;
+
+    ~BackgroundWriter() {
+        try {
+            this->close();
+        } catch (std::runtime_error &) {
+            // the errors can be reported only by an explicit close
+        }
+    }
+
+    /**
+     * Appends data to the file. The data of a single call are never interleaved with the ones of other threads
+     * @param data The data to append
+     */
+    void
+    append(const std::string &data) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->space_available.wait(lock, [this] {
+            return this->pending.size() < BackgroundWriter::max_pending_buffers * this->buffer_size || this->closed;
+        });
+        this->pending.append(data);
+        if (this->pending.size() >= this->buffer_size) {
+            this->data_available.notify_one();
+        }
+    }
+
+    /**
+     * Writes the pending data, waits for the writing thread and closes the file
+     * @throws std::runtime_error if the file could not be written
+     */
+    void
+    close() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->closed = true;
+        }
+        this->data_available.notify_one();
+        this->space_available.notify_all();
+        if (this->thread.joinable()) {
+            this->thread.join();
+            this->ostream.close();
+        }
+        if (this->failed) {
+            throw std::runtime_error(std::string("Unable to write the file ") + this->file_path);
+        }
+    }
+
+private:
+    /**
+     * Body of the writing thread
+     */
+    void
+    run() {
+        std::string buffer;
+        buffer.reserve(this->buffer_size);
+        std::unique_lock<std::mutex> lock(this->mutex);
+        bool done = false;
+        while (!done) {
+            this->data_available.wait(lock, [this] { return this->pending.size() >= this->buffer_size || this->closed; });
+            buffer.swap(this->pending);
+            done = this->closed;
+            lock.unlock();
+            this->space_available.notify_all();
+            this->ostream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+            lock.lock();
+        }
+        this->ostream.flush();
+        this->failed = !this->ostream;
+    }
+
+    const std::string file_path;
+    std::ofstream ostream;
+    const std::size_t buffer_size;
+    std::string pending;
+    std::mutex mutex;
+    std::condition_variable data_available;
+    std::condition_variable space_available;
+    bool closed = false;
+    bool failed = false;
+    std::thread thread;
+};
+
+
+/**
+ * Log of the outcomes of all tests on every list assessed, one record per list and pair (n_cut, k), so that the
+ * results can be analyzed afterwards without repeating the assessment. The records are written by a background
+ * writer in the order in which the lists are completed, which depends on the scheduling of the threads.
+ * Two formats are available:
+ * - jsonl: a json object per line, with the list id, n_cut, n, k, and for each strategy its score, approximation
+ *   error, number of elements pruned and not pruned, and the times of the two stages and their total;
+ * - binary: a header with the magic string "FALISTLG", the version (uint32) and the number of strategies (uint32),
+ *   each one followed by its name (uint32 length and characters), then one record per list and pair (n_cut, k) with
+ *   the list id (uint64), n_cut, n, k (uint32) and, for each strategy, the score (float32), the approximation error
+ *   (float64), the elements pruned and not pruned (uint32) and the three times (float64), in native byte order.
+ */
+class ListLog {
+public:
+    /**
+     * Version of the binary format
+     */
+    static const std::uint32_t binary_version = 1;
+
+    /**
+     * Constructor, which writes the header of the binary format
+     * @param file_path The path of the log
+     * @param format The format of the log: jsonl or binary
+     * @param test_names The names of the tests, the optimal one first
+     * @param buffer_size The number of bytes written at once
+     */
+    ListLog(const std::string &file_path, const std::string &format, std::vector<std::string> test_names, std::size_t buffer_size=1 << 20) :
+            binary(ListLog::parse_format(format)),
+            test_names(std::move(test_names)),
+            writer(file_path, buffer_size) {
+        if (this->binary) {
+            std::string header("FALISTLG");
+            ListLog::append_binary(header, ListLog::binary_version);
+            ListLog::append_binary(header, static_cast<std::uint32_t>(this->test_names.size()));
+            for (const std::string &name: this->test_names) {
+                ListLog::append_binary(header, static_cast<std::uint32_t>(name.size()));
+                header.append(name);
+            }
+            this->writer.append(header);
+        }
+    }
+
+    /**
+     * Formats the record of a list with a pair (n_cut, k), to be written later with write
+     * @param records Where to append the record
+     * @param list_id The id of the list
+     * @param n_cut The cut of the list
+     * @param n The number of elements assessed
+     * @param k The number of elements to select
+     * @param outcomes The outcomes of the tests, the optimal one first
+     */
+    void
+    format_record(std::string &records, std::size_t list_id, index_type n_cut, std::size_t n, k_type k, const TestOutcome *outcomes) const {
+        const score_type optimal_score = outcomes[0].score;
+        if (this->binary) {
+            ListLog::append_binary(records, static_cast<std::uint64_t>(list_id));
+            ListLog::append_binary(records, static_cast<std::uint32_t>(n_cut));
+            ListLog::append_binary(records, static_cast<std::uint32_t>(n));
+            ListLog::append_binary(records, static_cast<std::uint32_t>(k));
+            for (std::size_t t = 0; t < this->test_names.size(); ++t) {
+                const TestOutcome &outcome = outcomes[t];
+                ListLog::append_binary(records, static_cast<float>(outcome.score));
+                ListLog::append_binary(records, ListLog::approximation_error(outcome, t, optimal_score));
+                ListLog::append_binary(records, static_cast<std::uint32_t>(outcome.num_elements_pruned));
+                ListLog::append_binary(records, static_cast<std::uint32_t>(outcome.num_elements_not_pruned));
+                ListLog::append_binary(records, outcome.first_stage_time);
+                ListLog::append_binary(records, outcome.second_stage_time);
+                ListLog::append_binary(records, outcome.total_time);
+            }
+            return;
+        }
+
+        std::ostringstream os;
+        os.precision(std::numeric_limits<double>::max_digits10);
+        os << "{\"list\": " << list_id << ", \"n_cut\": " << n_cut << ", \"n\": " << n << ", \"k\": " << k << ", \"strategies\": {";
+        for (std::size_t t = 0; t < this->test_names.size(); ++t) {
+            const TestOutcome &outcome = outcomes[t];
+            os << ((t > 0) ? ", " : "");
+            write_json_string(os, this->test_names[t]);
+            os << ": {\"score\": " << outcome.score;
+            os << ", \"approximation_error\": " << ListLog::approximation_error(outcome, t, optimal_score);
+            os << ", \"num_elements_pruned\": " << outcome.num_elements_pruned;
+            os << ", \"num_elements_not_pruned\": " << outcome.num_elements_not_pruned;
+            os << ", \"first_stage_time\": " << outcome.first_stage_time;
+            os << ", \"second_stage_time\": " << outcome.second_stage_time;
+            os << ", \"total_time\": " << outcome.total_time;
+            if (outcome.upper_bound >= 0) {
+                os << ", \"upper_bound\": " << outcome.upper_bound;
+            }
+            os << "}";
+        }
+        os << "}}\n";
+        records.append(os.str());
+    }
+
+    /**
+     * Writes the records formatted with format_record. It can be called by many threads
+     * @param records The records
+     */
+    void
+    write(const std::string &records) {
+        if (!records.empty()) {
+            this->writer.append(records);
+        }
+    }
+
+    /**
+     * Writes the pending records and closes the log
+     * @throws std::runtime_error if the log could not be written
+     */
+    void
+    close() {
+        this->writer.close();
+    }
+
+private:
+    static bool
+    parse_format(const std::string &format) {
+        if (format != "jsonl" && format != "binary") {
+            throw std::runtime_error(std::string("The format of the list log is unavailable: ") + format);
+        }
+        return format == "binary";
+    }
+
+    static double
+    approximation_error(const TestOutcome &outcome, std::size_t t, score_type optimal_score) {
+        return (t > 0 && optimal_score > 0) ? 1.0 - (outcome.score / optimal_score) : 0.0;
+    }
+
+    template <typename T>
+    static void
+    append_binary(std::string &records, T value) {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        records.append(bytes, sizeof(T));
+    }
+
+    const bool binary;
+    const std::vector<std::string> test_names;
+    BackgroundWriter writer;
+};
+
+
+#endif //UTILS_LIST_LOG_HPP
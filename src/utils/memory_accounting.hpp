@@ -0,0 +1,249 @@
+#ifndef UTILS_MEMORY_ACCOUNTING_HPP
+#define UTILS_MEMORY_ACCOUNTING_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <sys/resource.h>
+
+
+/**
+ * Memory allocated on the heap by a region of code.
+ */
+typedef struct {
+    /**
+     * Peak number of bytes allocated by the region and not yet released, as reported by malloc_usable_size
+     */
+    std::int64_t peak_bytes = 0;
+    /**
+     * Number of allocations performed by the region
+     */
+    std::uint64_t num_allocations = 0;
+    /**
+     * Whether the memory usage has been collected
+     */
+    bool valid = false;
+} MemoryUsage;
+
+
+/**
+ * Sums of the memory used by many regions of code.
+ */
+typedef struct memory_usage_sums {
+    /**
+     * Number of regions summed
+     */
+    std::size_t count = 0;
+    /**
+     * Sum of the peak bytes
+     */
+    double sum_peak_bytes = 0;
+    /**
+     * Maximum of the peak bytes
+     */
+    std::int64_t max_peak_bytes = 0;
+    /**
+     * Sum of the number of allocations
+     */
+    double sum_allocations = 0;
+
+    /**
+     * Adds the given memory usage, if collected
+     * @param usage The memory usage to add
+     */
+    void
+    add(const MemoryUsage &usage) {
+        if (!usage.valid) {
+            return;
+        }
+        this->count += 1;
+        this->sum_peak_bytes += usage.peak_bytes;
+        this->max_peak_bytes = std::max(this->max_peak_bytes, usage.peak_bytes);
+        this->sum_allocations += usage.num_allocations;
+    }
+
+    /**
+     * Merges other sums into these ones
+     * @param other The sums to merge
+     */
+    void
+    merge(const struct memory_usage_sums &other) {
+        this->count += other.count;
+        this->sum_peak_bytes += other.sum_peak_bytes;
+        this->max_peak_bytes = std::max(this->max_peak_bytes, other.max_peak_bytes);
+        this->sum_allocations += other.sum_allocations;
+    }
+
+    /**
+     * Checks whether no memory usage has been summed
+     */
+    bool
+    empty() const {
+        return this->count == 0;
+    }
+
+    /**
+     * Writes on the output stream a json object with the average and maximum peak bytes and the average number of
+     * allocations
+     * @param os the output stream where to write
+     * @param sums the sums to write
+     * @return the output stream
+     */
+    friend std::ostream & operator<<(std::ostream &os, const struct memory_usage_sums &sums) {
+        os << "{";
+        if (sums.count > 0) {
+            os << "\"avg_peak_bytes\": " << sums.sum_peak_bytes / sums.count;
+            os << ", \"max_peak_bytes\": " << sums.max_peak_bytes;
+            os << ", \"avg_allocations\": " << sums.sum_allocations / sums.count;
+        }
+        os << "}";
+        return os;
+    }
+} MemoryUsageSums;
+
+
+/**
+ * Accounting of the heap memory allocated by the calling thread within a region of code.
+ * The allocations are counted by the replacements of the global operators new and delete defined in
+ * memory_hooks.hpp, which must be included by the executable; otherwise no allocation is counted and the usage
+ * collected is not valid. Until the accounting is enabled in the process, the replacements only test a flag that is
+ * never written, a single predictable branch before malloc and free.
+ */
+class MemoryAccounting {
+public:
+    /**
+     * Enables the accounting in the process. It must be called before starting the threads to account
+     */
+    static void
+    enable() {
+        MemoryAccounting::enabled_flag() = true;
+    }
+
+    /**
+     * Checks whether the accounting is enabled in the process
+     */
+    static bool
+    enabled() {
+        return MemoryAccounting::enabled_flag();
+    }
+
+    /**
+     * Starts counting the allocations of the calling thread
+     */
+    static void
+    start() {
+        MemoryAccounting::state &s = MemoryAccounting::thread_state();
+        s.current_bytes = 0;
+        s.peak_bytes = 0;
+        s.num_allocations = 0;
+        s.active = true;
+    }
+
+    /**
+     * Resumes counting the allocations of the calling thread after a stop, without resetting the counts
+     */
+    static void
+    resume() {
+        MemoryAccounting::thread_state().active = true;
+    }
+
+    /**
+     * Stops counting the allocations of the calling thread
+     * @return The memory allocated since the last call to start()
+     */
+    static MemoryUsage
+    stop() {
+        MemoryAccounting::state &s = MemoryAccounting::thread_state();
+        s.active = false;
+        MemoryUsage usage;
+        usage.peak_bytes = s.peak_bytes;
+        usage.num_allocations = s.num_allocations;
+        usage.valid = MemoryAccounting::hooks_installed() && MemoryAccounting::enabled();
+        return usage;
+    }
+
+    /**
+     * Records an allocation of the calling thread, if the accounting is active
+     * @param size The usable size of the block allocated
+     */
+    static void
+    record_allocation(std::size_t size) {
+        MemoryAccounting::state &s = MemoryAccounting::thread_state();
+        if (s.active) {
+            s.current_bytes += size;
+            s.peak_bytes = std::max(s.peak_bytes, s.current_bytes);
+            s.num_allocations += 1;
+        }
+    }
+
+    /**
+     * Records a deallocation of the calling thread, if the accounting is active.
+     * The blocks allocated before the start are released too, thus the current bytes can become negative.
+     * @param size The usable size of the block released
+     */
+    static void
+    record_deallocation(std::size_t size) {
+        MemoryAccounting::state &s = MemoryAccounting::thread_state();
+        if (s.active) {
+            s.current_bytes -= size;
+        }
+    }
+
+    /**
+     * Checks whether the accounting is active on the calling thread
+     */
+    static bool
+    active() {
+        return MemoryAccounting::thread_state().active;
+    }
+
+    /**
+     * Whether the replacements of the operators new and delete are linked in the executable
+     */
+    static bool &
+    hooks_installed() {
+        static bool installed = false;
+        return installed;
+    }
+
+    /**
+     * Gets the peak resident set size of the process
+     * @return The peak resident set size in bytes, or zero if unavailable
+     */
+    static std::int64_t
+    peak_rss_bytes() {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0;
+        }
+#ifdef __APPLE__
+        return static_cast<std::int64_t>(usage.ru_maxrss);
+#else
+        // kilobytes on linux
+        return static_cast<std::int64_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+
+private:
+    static bool &
+    enabled_flag() {
+        static bool enabled = false;
+        return enabled;
+    }
+
+    typedef struct {
+        std::int64_t current_bytes;
+        std::int64_t peak_bytes;
+        std::uint64_t num_allocations;
+        bool active;
+    } state;
+
+    static state &
+    thread_state() {
+        static thread_local state s = {0, 0, 0, false};
+        return s;
+    }
+};
+
+
+#endif //UTILS_MEMORY_ACCOUNTING_HPP
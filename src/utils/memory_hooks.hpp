@@ -0,0 +1,113 @@
+#ifndef UTILS_MEMORY_HOOKS_HPP
+#define UTILS_MEMORY_HOOKS_HPP
+
+#include <cstdlib>
+#include <new>
+#ifdef __APPLE__
+#include <malloc/malloc.h>
+#define malloc_usable_size malloc_size
+#else
+#include <malloc.h>
+#endif
+#include "memory_accounting.hpp"
+
+/*
+ * Replacements of the global operators new and delete, which report the usable size of every block to
+ * MemoryAccounting once it is enabled. Since they replace the operators of the whole program, this file must be
+ * included by exactly one translation unit of an executable, only when built with FILTERING_MEMORY_HOOKS.
+ */
+
+
+// the operators below forward to malloc and free by design
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+
+namespace memory_hooks {
+
+inline void *
+allocate(std::size_t size) {
+    void *ptr = std::malloc(size > 0 ? size : 1);
+    if (ptr != nullptr && MemoryAccounting::enabled() && MemoryAccounting::active()) {
+        MemoryAccounting::record_allocation(malloc_usable_size(ptr));
+    }
+    return ptr;
+}
+
+inline void
+deallocate(void *ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    if (MemoryAccounting::enabled() && MemoryAccounting::active()) {
+        MemoryAccounting::record_deallocation(malloc_usable_size(ptr));
+    }
+    std::free(ptr);
+}
+
+static const bool installed = (MemoryAccounting::hooks_installed() = true);
+
+}  // namespace memory_hooks
+
+
+void *
+operator new(std::size_t size) {
+    void *ptr = memory_hooks::allocate(size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *
+operator new[](std::size_t size) {
+    void *ptr = memory_hooks::allocate(size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *
+operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return memory_hooks::allocate(size);
+}
+
+void *
+operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return memory_hooks::allocate(size);
+}
+
+void
+operator delete(void *ptr) noexcept {
+    memory_hooks::deallocate(ptr);
+}
+
+void
+operator delete[](void *ptr) noexcept {
+    memory_hooks::deallocate(ptr);
+}
+
+void
+operator delete(void *ptr, std::size_t) noexcept {
+    memory_hooks::deallocate(ptr);
+}
+
+void
+operator delete[](void *ptr, std::size_t) noexcept {
+    memory_hooks::deallocate(ptr);
+}
+
+void
+operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    memory_hooks::deallocate(ptr);
+}
+
+void
+operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    memory_hooks::deallocate(ptr);
+}
+
+
+#endif //UTILS_MEMORY_HOOKS_HPP
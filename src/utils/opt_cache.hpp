@@ -0,0 +1,321 @@
+#ifndef UTILS_OPT_CACHE_HPP
+#define UTILS_OPT_CACHE_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+#include "../data_structures/hash.hpp"
+#include "../filtering/filter.hpp"
+#include "../filtering/types.hpp"
+
+
+/**
+ * On-disk cache of the optimal solutions of the lists, so that repeated assessment sweeps over the same lists skip
+ * the optimal filter for the combinations of list, n and k already computed.
+ * A solution is keyed by the 64-bit hash of the first n relevances of the list, seeded with the metric, by n and by k.
+ * The file is made of a header, the records sorted by key, and the indices of all solutions; it is mapped in memory
+ * and searched in place, thus opening a large cache costs nothing. The solutions computed during a run are kept in
+ * memory, and save rewrites the file with the old and the new records.
+ * It can be used by many threads at the same time.
+ */
+class OptCache {
+public:
+    /**
+     * Identifier of the format, at the beginning of the file
+     * @return The identifier, 8 characters long
+     */
+    static const char *
+    magic() {
+        return "FAFOPTC1";
+    }
+
+    /**
+     * Constructor, which maps the file, if it exists
+     * @param file_path The path of the file
+     * @param metric The name of the metric of the solutions
+     * @throws std::runtime_error if the file exists but it is not a valid cache
+     */
+    OptCache(const std::string &file_path, const std::string &metric) :
+            file_path(file_path),
+            seed(hash64::hash(metric)) {
+        const int fd = open(file_path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            if (errno == ENOENT) {
+                return;
+            }
+            throw std::runtime_error(std::string("Unable to open the OPT cache ") + file_path);
+        }
+        struct stat s;
+        if (fstat(fd, &s) != 0) {
+            close(fd);
+            throw std::runtime_error(std::string("Unable to access the stats of the OPT cache ") + file_path);
+        }
+        this->mapping_size = static_cast<std::size_t>(s.st_size);
+        if (this->mapping_size > 0) {
+            void *mapping = mmap(nullptr, this->mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapping == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error(std::string("Unable to map the OPT cache ") + file_path);
+            }
+            this->mapping = static_cast<const char *>(mapping);
+        }
+        close(fd);
+
+        // validate the header and the sizes of the sections
+        file_header header;
+        if (this->mapping_size < sizeof(header) || std::memcmp(this->mapping, OptCache::magic(), sizeof(header.magic)) != 0) {
+            this->unmap();
+            throw std::runtime_error(std::string("The file is not an OPT cache: ") + file_path);
+        }
+        std::memcpy(&header, this->mapping, sizeof(header));
+        if (header.seed != this->seed) {
+            this->unmap();
+            throw std::runtime_error(std::string("The OPT cache has been computed with another metric: ") + file_path);
+        }
+        if (header.num_records > this->mapping_size / sizeof(record) || header.num_indices > this->mapping_size / sizeof(std::uint32_t) ||
+            this->mapping_size != sizeof(header) + header.num_records * sizeof(record) + header.num_indices * sizeof(std::uint32_t)) {
+            this->unmap();
+            throw std::runtime_error(std::string("The OPT cache is truncated: ") + file_path);
+        }
+        this->records = reinterpret_cast<const record *>(this->mapping + sizeof(header));
+        this->num_records = header.num_records;
+        this->indices = reinterpret_cast<const std::uint32_t *>(this->records + this->num_records);
+
+        // every solution must lie within the indices section, so that lookup never reads past the mapping
+        for (std::size_t i = 0; i < this->num_records; ++i) {
+            if (this->records[i].offset > header.num_indices || this->records[i].num_indices > header.num_indices - this->records[i].offset) {
+                this->unmap();
+                throw std::runtime_error(std::string("The OPT cache is corrupted: ") + file_path);
+            }
+        }
+    }
+
+    /**
+     * Destructor, which unmaps the file without saving the new solutions
+     */
+    ~OptCache() {
+        this->unmap();
+    }
+
+    OptCache(const OptCache &) = delete;
+    OptCache & operator=(const OptCache &) = delete;
+
+    /**
+     * Hash of the first n relevances of a list
+     * @param rel_list List containing the relevance scores, ordered according to some attribute
+     * @param n Number of elements of rel_list
+     * @return The hash
+     */
+    std::uint64_t
+    list_hash(const relevance_type * rel_list, const index_type n) const {
+        return hash64::hash(rel_list, static_cast<std::size_t>(n) * sizeof(relevance_type), this->seed);
+    }
+
+    /**
+     * Looks up the optimal solution of a list
+     * @param list_hash The hash of the first n relevances of the list
+     * @param n Number of elements of the list
+     * @param k Maximum number of elements of the solution
+     * @param solution Where to store the solution, if found
+     * @return True if the solution has been found, false otherwise
+     */
+    bool
+    lookup(std::uint64_t list_hash, index_type n, k_type k, FilterSolution &solution) {
+        const record key = make_record(list_hash, n, k);
+        const record *end = this->records + this->num_records;
+        const record *it = std::lower_bound(this->records, end, key, record_less);
+        if (it != end && !record_less(key, *it)) {
+            solution.score = it->score;
+            solution.indices.assign(this->indices + it->offset, this->indices + it->offset + it->num_indices);
+            std::lock_guard<std::mutex> lock(this->mutex);
+            ++this->num_hits;
+            return true;
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto added = this->added_solutions.find(std::make_tuple(list_hash, n, k));
+        if (added != this->added_solutions.end()) {
+            solution = added->second;
+            ++this->num_hits;
+            return true;
+        }
+        ++this->num_misses;
+        return false;
+    }
+
+    /**
+     * Adds the optimal solution of a list, kept in memory until save
+     * @param list_hash The hash of the first n relevances of the list
+     * @param n Number of elements of the list
+     * @param k Maximum number of elements of the solution
+     * @param solution The solution
+     */
+    void
+    insert(std::uint64_t list_hash, index_type n, k_type k, const FilterSolution &solution) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->added_solutions.emplace(std::make_tuple(list_hash, n, k), solution);
+    }
+
+    /**
+     * Number of lookups that found their solution
+     * @return The number of hits
+     */
+    std::uint64_t
+    hits() const {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->num_hits;
+    }
+
+    /**
+     * Number of lookups that did not find their solution
+     * @return The number of misses
+     */
+    std::uint64_t
+    misses() const {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->num_misses;
+    }
+
+    /**
+     * Writes the file with the old and the new solutions, if there are new solutions. The file is written aside and
+     * then renamed, so that a concurrent reader sees either the old or the new file.
+     * @throws std::runtime_error if the file could not be written
+     */
+    void
+    save() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->added_solutions.empty()) {
+            return;
+        }
+
+        // merge the old records with the new ones, both sorted by key
+        std::vector<record> merged_records;
+        std::vector<std::uint32_t> merged_indices;
+        merged_records.reserve(this->num_records + this->added_solutions.size());
+        auto append = [&](const record &key, score_type score, const std::uint32_t *solution_indices, std::size_t num_indices) {
+            record r = key;
+            r.score = score;
+            r.num_indices = static_cast<std::uint32_t>(num_indices);
+            r.offset = merged_indices.size();
+            merged_indices.insert(merged_indices.end(), solution_indices, solution_indices + num_indices);
+            merged_records.push_back(r);
+        };
+        std::size_t i = 0;
+        for (const auto &added: this->added_solutions) {
+            const record key = make_record(std::get<0>(added.first), std::get<1>(added.first), std::get<2>(added.first));
+            for (; i < this->num_records && record_less(this->records[i], key); ++i) {
+                append(this->records[i], this->records[i].score, this->indices + this->records[i].offset, this->records[i].num_indices);
+            }
+            if (i < this->num_records && !record_less(key, this->records[i])) {
+                continue;
+            }
+            const FilterSolution &solution = added.second;
+            std::vector<std::uint32_t> solution_indices(solution.indices.begin(), solution.indices.end());
+            append(key, solution.score, solution_indices.data(), solution_indices.size());
+        }
+        for (; i < this->num_records; ++i) {
+            append(this->records[i], this->records[i].score, this->indices + this->records[i].offset, this->records[i].num_indices);
+        }
+
+        file_header header;
+        std::memcpy(header.magic, OptCache::magic(), sizeof(header.magic));
+        header.seed = this->seed;
+        header.num_records = merged_records.size();
+        header.num_indices = merged_indices.size();
+
+        const std::string temporary_path = this->file_path + ".tmp";
+        {
+            std::ofstream ostream(temporary_path, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!ostream.is_open()) {
+                throw std::runtime_error(std::string("Unable to open the file ") + temporary_path);
+            }
+            ostream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            ostream.write(reinterpret_cast<const char *>(merged_records.data()), merged_records.size() * sizeof(record));
+            ostream.write(reinterpret_cast<const char *>(merged_indices.data()), merged_indices.size() * sizeof(std::uint32_t));
+            ostream.close();
+            if (!ostream) {
+                throw std::runtime_error(std::string("Unable to write the file ") + temporary_path);
+            }
+        }
+        if (std::rename(temporary_path.c_str(), this->file_path.c_str()) != 0) {
+            throw std::runtime_error(std::string("Unable to replace the OPT cache ") + this->file_path);
+        }
+    }
+
+private:
+    /**
+     * Header of the file
+     */
+    struct file_header {
+        char magic[8];
+        std::uint64_t seed;
+        std::uint64_t num_records;
+        std::uint64_t num_indices;
+    };
+
+    /**
+     * Record of a solution, whose indices are num_indices consecutive entries of the indices section from offset
+     */
+    struct record {
+        std::uint64_t list_hash;
+        std::uint32_t n;
+        std::uint32_t k;
+        score_type score;
+        std::uint32_t num_indices;
+        std::uint64_t offset;
+    };
+
+    static record
+    make_record(std::uint64_t list_hash, index_type n, k_type k) {
+        record r;
+        std::memset(&r, 0, sizeof(r));
+        r.list_hash = list_hash;
+        r.n = n;
+        r.k = k;
+        return r;
+    }
+
+    static bool
+    record_less(const record &l, const record &r) {
+        return std::tie(l.list_hash, l.n, l.k) < std::tie(r.list_hash, r.n, r.k);
+    }
+
+    void
+    unmap() {
+        if (this->mapping != nullptr) {
+            munmap(const_cast<char *>(this->mapping), this->mapping_size);
+            this->mapping = nullptr;
+        }
+    }
+
+private:
+    const std::string file_path;
+    const std::uint64_t seed;
+    const char *mapping = nullptr;
+    std::size_t mapping_size = 0;
+    const record *records = nullptr;
+    std::size_t num_records = 0;
+    const std::uint32_t *indices = nullptr;
+
+    // the following members are protected by mutex
+    mutable std::mutex mutex;
+    std::map<std::tuple<std::uint64_t, index_type, k_type>, FilterSolution> added_solutions;
+    std::uint64_t num_hits = 0;
+    std::uint64_t num_misses = 0;
+};
+
+
+#endif //UTILS_OPT_CACHE_HPP
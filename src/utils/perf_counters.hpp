@@ -0,0 +1,314 @@
+#ifndef UTILS_PERF_COUNTERS_HPP
+#define UTILS_PERF_COUNTERS_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+/**
+ * Values of the hardware performance counters collected on a region of code, or raw reading of the counters.
+ */
+typedef struct perf_counter_values {
+    /**
+     * Number of counters
+     */
+    static const std::size_t num_counters = 5;
+
+    /**
+     * Values of the counters, in the order given by name()
+     */
+    double values[num_counters] = {0, 0, 0, 0, 0};
+    /**
+     * Whether each counter has been collected
+     */
+    bool valid[num_counters] = {false, false, false, false, false};
+    /**
+     * Time during which the counters have been enabled, in nanoseconds
+     */
+    double time_enabled = 0;
+    /**
+     * Time during which the counters have been counting, in nanoseconds, which is smaller than time_enabled when the
+     * counters are multiplexed with other events
+     */
+    double time_running = 0;
+
+    /**
+     * Name of the i-th counter
+     * @param i The position of the counter
+     * @return The name of the counter
+     */
+    static const char *
+    name(std::size_t i) {
+        static const char *names[num_counters] = {"cycles", "instructions", "l1d_read_misses", "llc_misses", "branch_misses"};
+        return names[i];
+    }
+
+    /**
+     * Checks whether at least one counter has been collected
+     */
+    bool
+    any_valid() const {
+        for (std::size_t i = 0; i < num_counters; ++i) {
+            if (this->valid[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Computes the difference between two raw readings of the counters, scaled by the fraction of the time between
+     * the readings during which the counters have been counting, in case of multiplexing.
+     * A counter that has not been counting at all between the readings is not valid.
+     * @param end The second reading
+     * @param start The first reading
+     * @return The values collected between the two readings
+     */
+    friend struct perf_counter_values
+    operator-(const struct perf_counter_values &end, const struct perf_counter_values &start) {
+        struct perf_counter_values result;
+        result.time_enabled = end.time_enabled - start.time_enabled;
+        result.time_running = end.time_running - start.time_running;
+        const bool running = (result.time_running > 0 || result.time_enabled == 0);
+        const double scaling = (result.time_running > 0 && result.time_running < result.time_enabled) ? result.time_enabled / result.time_running : 1.0;
+        for (std::size_t i = 0; i < num_counters; ++i) {
+            result.valid[i] = end.valid[i] && start.valid[i] && running;
+            result.values[i] = result.valid[i] ? (end.values[i] - start.values[i]) * scaling : 0;
+        }
+        return result;
+    }
+
+    /**
+     * Divides all values by the given number (e.g., the number of runs)
+     * @param divisor The divisor
+     * @return This object
+     */
+    struct perf_counter_values &
+    operator/=(double divisor) {
+        for (std::size_t i = 0; i < num_counters; ++i) {
+            this->values[i] /= divisor;
+        }
+        return *this;
+    }
+} PerfCounterValues;
+
+
+/**
+ * Sums of the values of the hardware performance counters collected on many regions of code.
+ */
+typedef struct perf_counter_sums {
+    /**
+     * Sums of the values of each counter
+     */
+    double sums[PerfCounterValues::num_counters] = {0, 0, 0, 0, 0};
+    /**
+     * Number of values summed for each counter
+     */
+    std::size_t counts[PerfCounterValues::num_counters] = {0, 0, 0, 0, 0};
+
+    /**
+     * Adds the valid counters of the given values
+     * @param values The values to add
+     */
+    void
+    add(const PerfCounterValues &values) {
+        for (std::size_t i = 0; i < PerfCounterValues::num_counters; ++i) {
+            if (values.valid[i]) {
+                this->sums[i] += values.values[i];
+                this->counts[i] += 1;
+            }
+        }
+    }
+
+    /**
+     * Merges other sums into these ones
+     * @param other The sums to merge
+     */
+    void
+    merge(const struct perf_counter_sums &other) {
+        for (std::size_t i = 0; i < PerfCounterValues::num_counters; ++i) {
+            this->sums[i] += other.sums[i];
+            this->counts[i] += other.counts[i];
+        }
+    }
+
+    /**
+     * Checks whether no value has been summed
+     */
+    bool
+    empty() const {
+        for (std::size_t i = 0; i < PerfCounterValues::num_counters; ++i) {
+            if (this->counts[i] > 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Writes on the output stream a json object with the average value of each counter collected
+     * @param os the output stream where to write
+     * @param sums the sums to write
+     * @return the output stream
+     */
+    friend std::ostream & operator<<(std::ostream &os, const struct perf_counter_sums &sums) {
+        os << "{";
+        bool first = true;
+        for (std::size_t i = 0; i < PerfCounterValues::num_counters; ++i) {
+            if (sums.counts[i] > 0) {
+                os << (first ? "" : ", ") << "\"" << PerfCounterValues::name(i) << "\": " << sums.sums[i] / sums.counts[i];
+                first = false;
+            }
+        }
+        os << "}";
+        return os;
+    }
+} PerfCounterSums;
+
+
+/**
+ * Group of hardware performance counters (cycles, instructions, L1 data cache read misses, last level cache misses,
+ * and branch misses) of the calling thread, collected by means of perf_event_open.
+ * The counters that cannot be opened (e.g., because of the perf_event_paranoid setting, of a virtual machine, or
+ * of a non-linux system) are simply not collected.
+ */
+class PerfCounterGroup {
+public:
+    /**
+     * Opens the counters for the calling thread, counting only the user space
+     */
+    PerfCounterGroup() {
+        for (std::size_t i = 0; i < PerfCounterValues::num_counters; ++i) {
+            this->fds[i] = -1;
+            this->positions[i] = -1;
+        }
+#ifdef __linux__
+        const std::uint32_t types[PerfCounterValues::num_counters] = {
+                PERF_TYPE_HARDWARE,
+                PERF_TYPE_HARDWARE,
+                PERF_TYPE_HW_CACHE,
+                PERF_TYPE_HARDWARE,
+                PERF_TYPE_HARDWARE
+        };
+        const std::uint64_t configs[PerfCounterValues::num_counters] = {
+                PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                PERF_COUNT_HW_CACHE_MISSES,
+                PERF_COUNT_HW_BRANCH_MISSES
+        };
+
+        int group_fd = -1;
+        int num_opened = 0;
+        for (std::size_t i = 0; i < PerfCounterValues::num_counters; ++i) {
+            struct perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = types[i];
+            attr.config = configs[i];
+            attr.disabled = (group_fd == -1) ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0));
+            if (fd < 0) {
+                // the counter is unavailable, the next one becomes the leader if the group is still empty
+                continue;
+            }
+            if (group_fd == -1) {
+                group_fd = fd;
+            }
+            this->fds[i] = fd;
+            this->positions[i] = num_opened++;
+        }
+        this->leader_fd = group_fd;
+
+        if (this->leader_fd != -1) {
+            ioctl(this->leader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(this->leader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    /**
+     * Destructor, which closes the counters
+     */
+    ~PerfCounterGroup() {
+#ifdef __linux__
+        for (std::size_t i = 0; i < PerfCounterValues::num_counters; ++i) {
+            if (this->fds[i] != -1) {
+                close(this->fds[i]);
+            }
+        }
+#endif
+    }
+
+    PerfCounterGroup(const PerfCounterGroup &) = delete;
+    PerfCounterGroup & operator=(const PerfCounterGroup &) = delete;
+
+    /**
+     * Checks whether at least one counter is available
+     */
+    bool
+    available() const {
+        return this->leader_fd != -1;
+    }
+
+    /**
+     * Reads the current raw values of the counters, with the times enabled and running, which are not scaled in case
+     * of multiplexing: the difference of two readings is scaled instead
+     * @return The values of the counters
+     */
+    PerfCounterValues
+    read() const {
+        PerfCounterValues result;
+#ifdef __linux__
+        if (this->leader_fd == -1) {
+            return result;
+        }
+        // format: number of counters, time enabled, time running, values
+        std::uint64_t buffer[3 + PerfCounterValues::num_counters];
+        ssize_t size = ::read(this->leader_fd, buffer, sizeof(buffer));
+        if (size < static_cast<ssize_t>(3 * sizeof(std::uint64_t))) {
+            return result;
+        }
+        const std::uint64_t num_values = buffer[0];
+        result.time_enabled = static_cast<double>(buffer[1]);
+        result.time_running = static_cast<double>(buffer[2]);
+        for (std::size_t i = 0; i < PerfCounterValues::num_counters; ++i) {
+            if (this->positions[i] >= 0 && static_cast<std::uint64_t>(this->positions[i]) < num_values) {
+                result.values[i] = static_cast<double>(buffer[3 + this->positions[i]]);
+                result.valid[i] = true;
+            }
+        }
+#endif
+        return result;
+    }
+
+    /**
+     * Gets the counters of the calling thread, opening them at the first call
+     * @return The counters of the calling thread
+     */
+    static PerfCounterGroup &
+    thread_instance() {
+        static thread_local PerfCounterGroup group;
+        return group;
+    }
+
+private:
+    int fds[PerfCounterValues::num_counters];
+    int positions[PerfCounterValues::num_counters];
+    int leader_fd = -1;
+};
+
+
+#endif //UTILS_PERF_COUNTERS_HPP
@@ -0,0 +1,501 @@
+#ifndef UTILS_PIPELINE_HPP
+#define UTILS_PIPELINE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "../data_structures/mpmc_queue.hpp"
+#include "../filtering/filter.hpp"
+#include "../filtering/pruner.hpp"
+#include "../filtering/types.hpp"
+#include "../filtering/workspace.hpp"
+#include "batch.hpp"
+#include "composition.hpp"
+#include "utils.hpp"
+
+
+/**
+ * Statistics of a stage of a pipelined filter, summed over the threads of the stage.
+ */
+typedef struct pipeline_stage_statistics {
+    /**
+     * Number of threads of the stage
+     */
+    std::size_t num_threads = 0;
+    /**
+     * Number of lists processed
+     */
+    std::uint64_t num_lists = 0;
+    /**
+     * Time spent processing the lists, in milliseconds
+     */
+    double busy_time = 0;
+    /**
+     * Time spent waiting for a list from the previous stage, in milliseconds
+     */
+    double starved_time = 0;
+    /**
+     * Time spent waiting for room in the next stage, in milliseconds
+     */
+    double blocked_time = 0;
+    /**
+     * Lifetime of the threads, in milliseconds
+     */
+    double total_time = 0;
+
+    /**
+     * Fraction of the lifetime of the threads spent processing the lists. A stage close to 1 is the bottleneck of
+     * the pipeline, and the one that benefits from more threads.
+     * @return The utilization, between 0 and 1
+     */
+    double
+    utilization() const {
+        return (this->total_time > 0) ? this->busy_time / this->total_time : 0.0;
+    }
+
+    /**
+     * Writes on the output stream a json representation of the statistics
+     * @param os the output stream where to write
+     * @param statistics the statistics to write
+     * @return the output stream
+     */
+    friend std::ostream & operator<<(std::ostream &os, const struct pipeline_stage_statistics &statistics) {
+        const double total_time = (statistics.total_time > 0) ? statistics.total_time : 1.0;
+        os << "{";
+        os << "\"threads\": " << statistics.num_threads;
+        os << ", \"lists\": " << statistics.num_lists;
+        os << ", \"utilization\": " << statistics.utilization();
+        os << ", \"starved\": " << statistics.starved_time / total_time;
+        os << ", \"blocked\": " << statistics.blocked_time / total_time;
+        os << ", \"avg_busy_time\": " << ((statistics.num_lists > 0) ? statistics.busy_time / statistics.num_lists : 0.0);
+        os << "}";
+        return os;
+    }
+} PipelineStageStatistics;
+
+
+/**
+ * Solution of a list filtered by a pipelined filter.
+ */
+typedef struct {
+    /**
+     * Id of the list, as given at its submission
+     */
+    std::size_t list_id = 0;
+    /**
+     * Time of the submission of the list, in nanoseconds
+     */
+    std::uint64_t submit_time = 0;
+    /**
+     * Solution of the list, whose indices refer to the elements of the list
+     */
+    FilterSolution solution;
+} PipelineResult;
+
+
+/**
+ * Filters a stream of lists with the pruner and the filter of a pipeline running on separate threads, so that the
+ * memory-bound scan of the pruner of a list overlaps the compute-bound dynamic programming of the filter on previous
+ * lists. The submitted lists are taken by the pruner threads from a lock-free queue; every pruner thread gathers the
+ * candidates of a list into a buffer taken from a lock-free queue of free buffers and hands it over to the filter
+ * threads through another lock-free queue, and the filter threads give the buffer back once the list is filtered.
+ * The number of buffers bounds the lists in flight between the stages, thus a slow filter stage blocks the pruners.
+ * The threads wait for a queue by spinning briefly and then blocking on a condition variable, notified by the threads
+ * pushing to or popping from the queue, and the time they spend processing and waiting is reported per stage.
+ * @tparam ScoreFun Score function type
+ */
+template <typename ScoreFun>
+class PipelinedFilter {
+public:
+    /**
+     * Type of the pipelines, i.e., the pruner and the filter of a composition test
+     */
+    typedef std::shared_ptr<PrunerFilterCompositionTest<ScoreFun>> pipeline_type;
+    /**
+     * Type of the function receiving the solutions. It is called by the filter threads concurrently, and in the order
+     * the lists are filtered
+     */
+    typedef std::function<void(PipelineResult &)> sink_type;
+
+    /**
+     * Constructor, which starts the threads
+     * @param config The pipeline
+     * @param num_pruner_threads Number of threads of the pruning stage
+     * @param num_filter_threads Number of threads of the filtering stage
+     * @param sink The function receiving the solutions
+     * @param capacity Maximum number of lists waiting in each queue, and number of buffers between the stages
+     */
+    PipelinedFilter(pipeline_type config, std::size_t num_pruner_threads, std::size_t num_filter_threads, sink_type sink,
+                    std::size_t capacity=1024) :
+            config(std::move(config)),
+            sink(std::move(sink)),
+            input_queue(capacity),
+            free_queue(capacity),
+            pruned_queue(capacity) {
+        if (this->config == nullptr) {
+            throw std::invalid_argument("The parameter config must not be null");
+        }
+        if (num_pruner_threads == 0 || num_filter_threads == 0) {
+            throw std::invalid_argument("The parameters num_pruner_threads and num_filter_threads must be strictly positive numbers");
+        }
+
+        this->buffers.resize(this->free_queue.capacity());
+        for (pruned_buffer &buffer: this->buffers) {
+            pruned_buffer *pointer = &buffer;
+            this->free_queue.try_push(pointer);
+        }
+        this->pruner_statistics.resize(num_pruner_threads);
+        this->filter_statistics.resize(num_filter_threads);
+        this->num_active_pruners = num_pruner_threads;
+        for (std::size_t i = 0; i < num_pruner_threads; ++i) {
+            this->threads.emplace_back(&PipelinedFilter::pruner_loop, this, i);
+        }
+        for (std::size_t i = 0; i < num_filter_threads; ++i) {
+            this->threads.emplace_back(&PipelinedFilter::filter_loop, this, i);
+        }
+    }
+
+    /**
+     * Destructor. It waits the completion of all submitted lists.
+     */
+    ~PipelinedFilter() {
+        try {
+            this->close();
+        } catch (...) {
+        }
+    }
+
+    PipelinedFilter(const PipelinedFilter &) = delete;
+    PipelinedFilter & operator=(const PipelinedFilter &) = delete;
+
+    /**
+     * Submits a list, waiting for room in the input queue. The relevances must stay valid until the list is filtered.
+     * It can be called by many threads, but not after close.
+     * @param list_id The id of the list, passed to the sink with its solution
+     * @param list The list
+     */
+    void
+    submit(std::size_t list_id, const BatchList &list) {
+        stream_item item;
+        item.list_id = list_id;
+        item.list = list;
+        item.submit_time = get_time_nanoseconds();
+        this->input_event.wait([&]() { return this->input_queue.try_push(item); });
+        this->input_event.notify();
+    }
+
+    /**
+     * Waits the completion of all submitted lists and stops the threads.
+     * If the processing of a list has thrown an exception, the first one is rethrown.
+     */
+    void
+    close() {
+        if (this->threads.empty()) {
+            return;
+        }
+        this->input_closed.store(true, std::memory_order_release);
+        this->input_event.notify();
+        for (std::thread &thread: this->threads) {
+            thread.join();
+        }
+        this->threads.clear();
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->exception) {
+            std::exception_ptr exception = this->exception;
+            this->exception = nullptr;
+            std::rethrow_exception(exception);
+        }
+    }
+
+    /**
+     * Statistics of the pruning stage, complete after close
+     * @return The statistics summed over the pruner threads
+     */
+    PipelineStageStatistics
+    pruning_statistics() const {
+        return PipelinedFilter::sum_statistics(this->pruner_statistics);
+    }
+
+    /**
+     * Statistics of the filtering stage, complete after close
+     * @return The statistics summed over the filter threads
+     */
+    PipelineStageStatistics
+    filtering_statistics() const {
+        return PipelinedFilter::sum_statistics(this->filter_statistics);
+    }
+
+private:
+    /**
+     * List waiting for the pruning stage
+     */
+    struct stream_item {
+        std::size_t list_id = 0;
+        std::uint64_t submit_time = 0;
+        BatchList list = {nullptr, 0};
+    };
+
+    /**
+     * Candidates of a list waiting for the filtering stage. When the pipeline has no pruner, the filter reads the list
+     * in place
+     */
+    struct pruned_buffer {
+        std::size_t list_id = 0;
+        std::uint64_t submit_time = 0;
+        BatchList list = {nullptr, 0};
+        std::vector<index_type> indices;
+        std::vector<relevance_type> relevances;
+    };
+
+    /**
+     * Event on which the threads wait for a queue to change. A waiting thread retries for a few iterations, then blocks
+     * on the condition variable, and the threads changing the queue notify it only if some thread is blocked, so that
+     * the event costs a fence when nobody waits. The wait has a timeout as a safeguard against lost notifications
+     */
+    class queue_event {
+    public:
+        /**
+         * Waits until the condition holds
+         * @param condition The function checking the condition, which may take an element from the queue
+         */
+        template <typename Condition>
+        void
+        wait(Condition condition) {
+            for (int i = 0; i < queue_event::spin_iterations; ++i) {
+                if (condition()) {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->num_waiters.fetch_add(1);
+            while (!condition()) {
+                this->condition.wait_for(lock, std::chrono::milliseconds(1));
+            }
+            this->num_waiters.fetch_sub(1);
+        }
+
+        /**
+         * Wakes up the threads blocked on the event, after a change of the queue
+         */
+        void
+        notify() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (this->num_waiters.load() > 0) {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->condition.notify_all();
+            }
+        }
+
+    private:
+        enum { spin_iterations = 64 };
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::atomic<std::size_t> num_waiters{0};
+    };
+
+    /**
+     * Main loop of a pruner thread
+     * @param thread_id The id of the thread within the stage
+     */
+    void
+    pruner_loop(std::size_t thread_id) {
+        PipelineStageStatistics &statistics = this->pruner_statistics[thread_id];
+        const Pruner<ScoreFun> *pruner = this->config->pruner.get();
+        const std::uint64_t thread_start = get_time_nanoseconds();
+        stream_item item;
+        while (true) {
+            // take a list
+            std::uint64_t start = get_time_nanoseconds();
+            bool found = false;
+            this->input_event.wait([&]() {
+                const bool closed = this->input_closed.load(std::memory_order_acquire);
+                found = this->input_queue.try_pop(item);
+                return found || closed;
+            });
+            if (!found) {
+                break;
+            }
+            this->input_event.notify();
+            std::uint64_t end = get_time_nanoseconds();
+            statistics.starved_time += get_elapsed_milliseconds(start, end);
+
+            // prune it
+            start = end;
+            const relevance_type *rel_list = item.list.relevances;
+            const index_type n = item.list.n;
+            PrunerSolution pruningSolution;
+            if (pruner != nullptr && n > 0) {
+                try {
+                    minmax_type minmax_element;
+                    minmax_element.min = minmax_element.max = rel_list[0];
+                    for (index_type j = 1; j < n; ++j) {
+                        if (rel_list[j] < minmax_element.min) {
+                            minmax_element.min = rel_list[j];
+                        } else if (rel_list[j] > minmax_element.max) {
+                            minmax_element.max = rel_list[j];
+                        }
+                    }
+                    pruningSolution = pruner->operator()(rel_list, n, minmax_element);
+                } catch (...) {
+                    this->record_exception();
+                }
+            }
+            end = get_time_nanoseconds();
+            statistics.busy_time += get_elapsed_milliseconds(start, end);
+
+            // take a free buffer
+            start = end;
+            pruned_buffer *buffer;
+            this->free_event.wait([&]() { return this->free_queue.try_pop(buffer); });
+            this->free_event.notify();
+            end = get_time_nanoseconds();
+            statistics.blocked_time += get_elapsed_milliseconds(start, end);
+
+            // gather the candidates into the buffer and hand it over
+            start = end;
+            buffer->list_id = item.list_id;
+            buffer->submit_time = item.submit_time;
+            buffer->list = item.list;
+            buffer->indices = std::move(pruningSolution.indices);
+            buffer->relevances.resize(buffer->indices.size());
+            for (index_type i = 0, i_end = buffer->indices.size(); i < i_end; ++i) {
+                buffer->relevances[i] = rel_list[buffer->indices[i]];
+            }
+            this->pruned_event.wait([&]() { return this->pruned_queue.try_push(buffer); });
+            this->pruned_event.notify();
+            statistics.busy_time += get_elapsed_milliseconds(start, get_time_nanoseconds());
+            ++statistics.num_lists;
+        }
+
+        statistics.total_time = get_elapsed_milliseconds(thread_start, get_time_nanoseconds());
+        if (this->num_active_pruners.fetch_sub(1) == 1) {
+            this->pruned_closed.store(true, std::memory_order_release);
+            this->pruned_event.notify();
+        }
+    }
+
+    /**
+     * Main loop of a filter thread
+     * @param thread_id The id of the thread within the stage
+     */
+    void
+    filter_loop(std::size_t thread_id) {
+        PipelineStageStatistics &statistics = this->filter_statistics[thread_id];
+        const Filter<ScoreFun> &filter = *(this->config->filter);
+        const bool pruned = (this->config->pruner != nullptr);
+        const std::uint64_t thread_start = get_time_nanoseconds();
+        Workspace workspace;
+        PipelineResult result;
+        while (true) {
+            // take the candidates of a list
+            std::uint64_t start = get_time_nanoseconds();
+            pruned_buffer *buffer;
+            bool found = false;
+            this->pruned_event.wait([&]() {
+                const bool closed = this->pruned_closed.load(std::memory_order_acquire);
+                found = this->pruned_queue.try_pop(buffer);
+                return found || closed;
+            });
+            if (!found) {
+                break;
+            }
+            this->pruned_event.notify();
+            std::uint64_t end = get_time_nanoseconds();
+            statistics.starved_time += get_elapsed_milliseconds(start, end);
+
+            // filter them, and update the indices according to the results of the first stage
+            start = end;
+            result.list_id = buffer->list_id;
+            result.submit_time = buffer->submit_time;
+            try {
+                if (pruned) {
+                    result.solution = filter(buffer->relevances.data(), buffer->relevances.size(), workspace);
+                    for (index_type i = 0, i_end = result.solution.size(); i < i_end; ++i) {
+                        result.solution.indices[i] = buffer->indices[result.solution.indices[i]];
+                    }
+                } else {
+                    result.solution = filter(buffer->list.relevances, buffer->list.n, workspace);
+                }
+            } catch (...) {
+                result.solution = FilterSolution();
+                this->record_exception();
+            }
+            this->free_event.wait([&]() { return this->free_queue.try_push(buffer); });
+            this->free_event.notify();
+            try {
+                this->sink(result);
+            } catch (...) {
+                this->record_exception();
+            }
+            statistics.busy_time += get_elapsed_milliseconds(start, get_time_nanoseconds());
+            ++statistics.num_lists;
+        }
+        statistics.total_time = get_elapsed_milliseconds(thread_start, get_time_nanoseconds());
+    }
+
+    /**
+     * Records the exception being handled, if it is the first one
+     */
+    void
+    record_exception() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (!this->exception) {
+            this->exception = std::current_exception();
+        }
+    }
+
+    /**
+     * Sums the statistics of the threads of a stage
+     * @param statistics The statistics of each thread
+     * @return The statistics of the stage
+     */
+    static PipelineStageStatistics
+    sum_statistics(const std::vector<PipelineStageStatistics> &statistics) {
+        PipelineStageStatistics sum;
+        sum.num_threads = statistics.size();
+        for (const PipelineStageStatistics &thread_statistics: statistics) {
+            sum.num_lists += thread_statistics.num_lists;
+            sum.busy_time += thread_statistics.busy_time;
+            sum.starved_time += thread_statistics.starved_time;
+            sum.blocked_time += thread_statistics.blocked_time;
+            sum.total_time += thread_statistics.total_time;
+        }
+        return sum;
+    }
+
+private:
+    const pipeline_type config;
+    const sink_type sink;
+    MPMCQueue<stream_item> input_queue;
+    MPMCQueue<pruned_buffer *> free_queue;
+    MPMCQueue<pruned_buffer *> pruned_queue;
+    queue_event input_event;
+    queue_event free_event;
+    queue_event pruned_event;
+    std::vector<pruned_buffer> buffers;
+    std::vector<PipelineStageStatistics> pruner_statistics;
+    std::vector<PipelineStageStatistics> filter_statistics;
+    std::vector<std::thread> threads;
+    std::atomic<bool> input_closed{false};
+    std::atomic<bool> pruned_closed{false};
+    std::atomic<std::size_t> num_active_pruners{0};
+
+    // the following members are protected by mutex
+    std::mutex mutex;
+    std::exception_ptr exception;
+};
+
+
+#endif //UTILS_PIPELINE_HPP
@@ -0,0 +1,391 @@
+#ifndef UTILS_PROTOCOL_HPP
+#define UTILS_PROTOCOL_HPP
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+#include "../filtering/types.hpp"
+
+
+/**
+ * Binary protocol of the filtering server. Every message is a frame made of its length in bytes (uint32) followed by
+ * its payload, and all numbers are in the native byte order, since the server accepts only local connections.
+ * A request contains its id (uint32), the strategy (uint8, see strategy_codes), a reserved byte, k (uint16), epsilon
+ * (float32), the number of elements n (uint32) and the n relevances (float32).
+ * A response contains the id of the request (uint32), the status (uint8, zero on success), three reserved bytes, the
+ * time spent by the server in filtering the list in nanoseconds (uint64), the score of the solution (float32), and
+ * the number of indices of the elements selected (uint32) followed by the indices (uint32), or, if the status is not
+ * zero, the length of an error message (uint32) followed by its characters.
+ */
+namespace protocol {
+
+/**
+ * Maximum size of the payload of a frame
+ */
+const std::uint32_t max_frame_size = 1u << 28;
+
+/**
+ * Size of the fixed part of the payload of a request
+ */
+const std::size_t request_header_size = 16;
+
+/**
+ * Size of the fixed part of the payload of a response
+ */
+const std::size_t response_header_size = 24;
+
+/**
+ * Names of the strategies, indexed by their codes
+ */
+const char * const strategy_codes[] = {"opt", "cutoff", "topk", "epsfiltering"};
+
+/**
+ * Number of strategies
+ */
+const std::size_t num_strategies = sizeof(strategy_codes) / sizeof(strategy_codes[0]);
+
+
+/**
+ * A request to filter a list.
+ */
+typedef struct {
+    /**
+     * Id of the request, copied into the response
+     */
+    std::uint32_t request_id = 0;
+    /**
+     * Code of the filtering strategy
+     */
+    std::uint8_t strategy = 0;
+    /**
+     * Number of elements to select
+     */
+    k_type k = 0;
+    /**
+     * Target approximation factor, used only by epsfiltering
+     */
+    score_type epsilon = 0;
+    /**
+     * Relevances of the elements of the list, ordered according to some attribute
+     */
+    std::vector<relevance_type> relevances;
+} Request;
+
+
+/**
+ * The response to a request.
+ */
+typedef struct {
+    /**
+     * Id of the request
+     */
+    std::uint32_t request_id = 0;
+    /**
+     * Status of the request, zero on success
+     */
+    std::uint8_t status = 0;
+    /**
+     * Time spent by the server in filtering the list, in nanoseconds
+     */
+    std::uint64_t service_time = 0;
+    /**
+     * Score of the solution
+     */
+    score_type score = 0;
+    /**
+     * Indices of the elements selected
+     */
+    std::vector<std::uint32_t> indices;
+    /**
+     * Error message, if the status is not zero
+     */
+    std::string error;
+} Response;
+
+
+/**
+ * Code of a strategy, given its name
+ * @param strategy The name of the strategy
+ * @return The code of the strategy
+ * @throws std::runtime_error if the strategy is unavailable
+ */
+inline std::uint8_t
+strategy_code(const std::string &strategy) {
+    for (std::size_t i = 0; i < num_strategies; ++i) {
+        if (strategy == strategy_codes[i]) {
+            return static_cast<std::uint8_t>(i);
+        }
+    }
+    throw std::runtime_error(std::string("The given strategy is unavailable: ") + strategy);
+}
+
+
+template <typename T>
+inline void
+append_value(std::string &buffer, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    buffer.append(bytes, sizeof(T));
+}
+
+template <typename T>
+inline T
+read_value(const char *data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+
+/**
+ * Appends the frame of a request to a buffer
+ * @param buffer Where to append the frame
+ * @param request The request
+ */
+inline void
+encode_request(std::string &buffer, const Request &request) {
+    append_value(buffer, static_cast<std::uint32_t>(request_header_size + request.relevances.size() * sizeof(relevance_type)));
+    append_value(buffer, request.request_id);
+    append_value(buffer, request.strategy);
+    append_value(buffer, static_cast<std::uint8_t>(0));
+    append_value(buffer, static_cast<std::uint16_t>(request.k));
+    append_value(buffer, static_cast<float>(request.epsilon));
+    append_value(buffer, static_cast<std::uint32_t>(request.relevances.size()));
+    buffer.append(reinterpret_cast<const char *>(request.relevances.data()), request.relevances.size() * sizeof(relevance_type));
+}
+
+
+/**
+ * Decodes the payload of a request frame
+ * @param data The payload
+ * @param size The size of the payload
+ * @param request Where to store the request
+ * @throws std::runtime_error if the payload is malformed
+ */
+inline void
+decode_request(const char *data, std::size_t size, Request &request) {
+    if (size < request_header_size) {
+        throw std::runtime_error("The request is truncated");
+    }
+    request.request_id = read_value<std::uint32_t>(data);
+    request.strategy = read_value<std::uint8_t>(data + 4);
+    request.k = read_value<std::uint16_t>(data + 6);
+    request.epsilon = read_value<float>(data + 8);
+    const std::uint32_t n = read_value<std::uint32_t>(data + 12);
+    if (size != request_header_size + static_cast<std::size_t>(n) * sizeof(relevance_type)) {
+        throw std::runtime_error("The size of the request does not match its number of elements");
+    }
+    request.relevances.resize(n);
+    std::memcpy(request.relevances.data(), data + request_header_size, n * sizeof(relevance_type));
+}
+
+
+/**
+ * Appends the frame of a response to a buffer
+ * @param buffer Where to append the frame
+ * @param response The response
+ */
+inline void
+encode_response(std::string &buffer, const Response &response) {
+    const std::size_t body_size = (response.status == 0) ? response.indices.size() * sizeof(std::uint32_t) : response.error.size();
+    append_value(buffer, static_cast<std::uint32_t>(response_header_size + body_size));
+    append_value(buffer, response.request_id);
+    append_value(buffer, response.status);
+    buffer.append(3, '\0');
+    append_value(buffer, response.service_time);
+    append_value(buffer, static_cast<float>(response.score));
+    if (response.status == 0) {
+        append_value(buffer, static_cast<std::uint32_t>(response.indices.size()));
+        buffer.append(reinterpret_cast<const char *>(response.indices.data()), body_size);
+    } else {
+        append_value(buffer, static_cast<std::uint32_t>(response.error.size()));
+        buffer.append(response.error);
+    }
+}
+
+
+/**
+ * Decodes the payload of a response frame
+ * @param data The payload
+ * @param size The size of the payload
+ * @param response Where to store the response
+ * @throws std::runtime_error if the payload is malformed
+ */
+inline void
+decode_response(const char *data, std::size_t size, Response &response) {
+    if (size < response_header_size) {
+        throw std::runtime_error("The response is truncated");
+    }
+    response.request_id = read_value<std::uint32_t>(data);
+    response.status = read_value<std::uint8_t>(data + 4);
+    response.service_time = read_value<std::uint64_t>(data + 8);
+    response.score = read_value<float>(data + 16);
+    const std::uint32_t count = read_value<std::uint32_t>(data + 20);
+    const std::size_t body_size = (response.status == 0) ? count * sizeof(std::uint32_t) : count;
+    if (size != response_header_size + body_size) {
+        throw std::runtime_error("The size of the response does not match its content");
+    }
+    if (response.status == 0) {
+        response.indices.resize(count);
+        std::memcpy(response.indices.data(), data + response_header_size, body_size);
+        response.error.clear();
+    } else {
+        response.indices.clear();
+        response.error.assign(data + response_header_size, count);
+    }
+}
+
+
+/**
+ * Opens a socket listening on a Unix domain socket, if the path is not empty, or on a TCP port of the loopback
+ * interface
+ * @param socket_path The path of the Unix domain socket, which is replaced if it exists, or an empty string
+ * @param port The TCP port, used if the path is empty
+ * @return The file descriptor of the socket
+ * @throws std::runtime_error if the socket cannot be opened
+ */
+inline int
+listen_socket(const std::string &socket_path, int port) {
+    int fd;
+    if (!socket_path.empty()) {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        if (socket_path.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error(std::string("The socket path is too long: ") + socket_path);
+        }
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        unlink(socket_path.c_str());
+        if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+            throw std::runtime_error(std::string("Unable to bind the socket ") + socket_path + ": " + std::strerror(errno));
+        }
+    } else {
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(static_cast<std::uint16_t>(port));
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        const int reuse = 1;
+        if (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+            bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+            throw std::runtime_error(std::string("Unable to bind the port ") + std::to_string(port) + ": " + std::strerror(errno));
+        }
+    }
+    if (listen(fd, SOMAXCONN) != 0) {
+        throw std::runtime_error(std::string("Unable to listen on the socket: ") + std::strerror(errno));
+    }
+    return fd;
+}
+
+
+/**
+ * Connects to the server, with a blocking socket
+ * @param socket_path The path of the Unix domain socket of the server, or an empty string
+ * @param port The TCP port of the server on the loopback interface, used if the path is empty
+ * @return The file descriptor of the socket
+ * @throws std::runtime_error if the connection fails
+ */
+inline int
+connect_socket(const std::string &socket_path, int port) {
+    int fd;
+    int result;
+    if (!socket_path.empty()) {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        result = (fd < 0) ? -1 : connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    } else {
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(static_cast<std::uint16_t>(port));
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        result = (fd < 0) ? -1 : connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+        const int no_delay = 1;
+        if (result == 0) {
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+        }
+    }
+    if (result != 0) {
+        const std::string error = std::strerror(errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        throw std::runtime_error(std::string("Unable to connect to the server: ") + error);
+    }
+    return fd;
+}
+
+
+/**
+ * Writes all the data on a blocking socket
+ * @param fd The socket
+ * @param data The data
+ * @throws std::runtime_error if the write fails
+ */
+inline void
+write_all(int fd, const std::string &data) {
+    std::size_t written = 0;
+    while (written < data.size()) {
+        const ssize_t result = send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            throw std::runtime_error(std::string("Unable to write on the socket: ") + std::strerror(errno));
+        }
+        written += static_cast<std::size_t>(result);
+    }
+}
+
+
+/**
+ * Reads a frame from a blocking socket
+ * @param fd The socket
+ * @param payload Where to store the payload of the frame
+ * @throws std::runtime_error if the read fails or the connection is closed
+ */
+inline void
+read_frame(int fd, std::string &payload) {
+    auto read_exact = [fd](char *data, std::size_t size) {
+        std::size_t read = 0;
+        while (read < size) {
+            const ssize_t result = recv(fd, data + read, size - read, 0);
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result <= 0) {
+                throw std::runtime_error((result == 0) ? std::string("The connection has been closed by the server") :
+                                         std::string("Unable to read from the socket: ") + std::strerror(errno));
+            }
+            read += static_cast<std::size_t>(result);
+        }
+    };
+    char length_bytes[sizeof(std::uint32_t)];
+    read_exact(length_bytes, sizeof(length_bytes));
+    const std::uint32_t length = read_value<std::uint32_t>(length_bytes);
+    if (length > max_frame_size) {
+        throw std::runtime_error("The frame is too large");
+    }
+    payload.resize(length);
+    read_exact(&payload[0], length);
+}
+
+}  // namespace protocol
+
+
+#endif //UTILS_PROTOCOL_HPP
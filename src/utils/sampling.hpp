@@ -0,0 +1,252 @@
+#ifndef UTILS_SAMPLING_HPP
+#define UTILS_SAMPLING_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "assessment_aggregation.hpp"
+#include "statistics.hpp"
+
+
+/**
+ * Targets of the confidence intervals of a sampled assessment: the sampling stops when the half widths of the
+ * intervals of all tests and pairs (n_cut, k) are within the targets.
+ */
+typedef struct {
+    /**
+     * Half width of the interval of the average score, relative to the estimate
+     */
+    double score = 0.01;
+    /**
+     * Half width of the interval of the average approximation error, in absolute terms
+     */
+    double approximation_error = 0.001;
+    /**
+     * Half width of the interval of the average total time, relative to the estimate
+     */
+    double total_time = 0.05;
+} SamplingTargets;
+
+
+/**
+ * Random sampler of the lists stratified by their size: the lists are split in strata of (almost) equal number of
+ * lists by increasing size, and each batch draws from every stratum a number of lists proportional to its size,
+ * without replacement.
+ */
+class StratifiedSampler {
+public:
+    /**
+     * Constructor
+     * @param sizes The size of each list, e.g., its length or the size of its file
+     * @param num_strata The number of strata
+     * @param seed The seed of the random order of the lists in each stratum
+     */
+    StratifiedSampler(const std::vector<double> &sizes, std::size_t num_strata, unsigned seed) :
+            list_stratum(sizes.size(), 0) {
+        if (num_strata == 0) {
+            throw std::invalid_argument("The number of strata must be strictly greater than 0");
+        }
+        num_strata = std::max<std::size_t>(1, std::min(num_strata, sizes.size()));
+
+        // split the lists sorted by size, keeping the lists of the same size in the same stratum
+        std::vector<std::size_t> order(sizes.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&sizes](std::size_t a, std::size_t b) { return sizes[a] < sizes[b]; });
+        std::mt19937 random_engine(seed);
+        std::size_t begin = 0;
+        for (std::size_t h = 0; h < num_strata && begin < order.size(); ++h) {
+            std::size_t end = (h + 1 == num_strata) ? order.size() : std::max(begin + 1, (h + 1) * order.size() / num_strata);
+            while (end < order.size() && sizes[order[end]] == sizes[order[end - 1]]) {
+                ++end;
+            }
+            this->strata.emplace_back(order.begin() + begin, order.begin() + end);
+            std::shuffle(this->strata.back().begin(), this->strata.back().end(), random_engine);
+            for (std::size_t i: this->strata.back()) {
+                this->list_stratum[i] = h;
+            }
+            begin = end;
+        }
+        this->num_sampled.assign(this->strata.size(), 0);
+    }
+
+    /**
+     * Number of strata
+     */
+    std::size_t
+    num_strata() const {
+        return this->strata.size();
+    }
+
+    /**
+     * Stratum of the given list
+     */
+    std::size_t
+    stratum(std::size_t list_id) const {
+        return this->list_stratum[list_id];
+    }
+
+    /**
+     * Number of lists in the given stratum
+     */
+    std::size_t
+    population(std::size_t h) const {
+        return this->strata[h].size();
+    }
+
+    /**
+     * Number of lists of the given stratum sampled so far
+     */
+    std::size_t
+    sampled(std::size_t h) const {
+        return this->num_sampled[h];
+    }
+
+    /**
+     * Number of lists sampled so far
+     */
+    std::size_t
+    sampled() const {
+        return std::accumulate(this->num_sampled.begin(), this->num_sampled.end(), static_cast<std::size_t>(0));
+    }
+
+    /**
+     * Checks whether all lists have been sampled
+     */
+    bool
+    exhausted() const {
+        return this->sampled() == this->list_stratum.size();
+    }
+
+    /**
+     * Draws the next batch of lists. Each stratum contributes at least two lists, if available, so that its variance
+     * can be estimated
+     * @param batch_size The number of lists to draw, approximately
+     * @return The ids of the lists drawn
+     */
+    std::vector<std::size_t>
+    next_batch(std::size_t batch_size) {
+        std::vector<std::size_t> batch;
+        const double total = static_cast<double>(this->list_stratum.size());
+        for (std::size_t h = 0; h < this->strata.size(); ++h) {
+            std::size_t quota = static_cast<std::size_t>(std::ceil(batch_size * this->strata[h].size() / total));
+            if (this->num_sampled[h] + quota < 2) {
+                quota = 2 - this->num_sampled[h];
+            }
+            quota = std::min(quota, this->strata[h].size() - this->num_sampled[h]);
+            batch.insert(batch.end(), this->strata[h].begin() + this->num_sampled[h], this->strata[h].begin() + this->num_sampled[h] + quota);
+            this->num_sampled[h] += quota;
+        }
+        return batch;
+    }
+
+private:
+    std::vector<std::vector<std::size_t>> strata;
+    std::vector<std::size_t> list_stratum;
+    std::vector<std::size_t> num_sampled;
+};
+
+
+/**
+ * Computes the stratified estimate of the mean of a measure and the half width of its confidence interval.
+ * The weight of each stratum is its number of lists, scaled by the fraction of its sampled lists that have been
+ * assessed (e.g., not skipped because shorter than n_cut), and the variance includes the finite population correction
+ * @param sampler The sampler
+ * @param outcomes The aggregation of the test in each stratum
+ * @param measure The moments of the measure in an aggregation
+ * @param confidence The confidence level
+ * @return The estimate
+ */
+inline IntervalEstimate
+stratified_estimate(const StratifiedSampler &sampler, const std::vector<const TestsAggregationOutcome *> &outcomes,
+                    RunningMoments TestsAggregationOutcome::*measure, double confidence) {
+    double population = 0;
+    std::vector<double> weights(outcomes.size(), 0.0);
+    std::size_t num_lists = 0;
+    for (std::size_t h = 0; h < outcomes.size(); ++h) {
+        // the lists aggregated with the measure, since the times of the lists found in the OPT cache are not
+        const std::size_t stratum_lists = ((*outcomes[h]).*measure).count();
+        if (stratum_lists > 0) {
+            weights[h] = static_cast<double>(sampler.population(h)) * stratum_lists / sampler.sampled(h);
+            population += weights[h];
+            num_lists += stratum_lists;
+        }
+    }
+
+    IntervalEstimate estimate;
+    if (population == 0) {
+        return estimate;
+    }
+    double variance = 0;
+    for (std::size_t h = 0; h < outcomes.size(); ++h) {
+        const TestsAggregationOutcome &outcome = *outcomes[h];
+        const std::size_t stratum_lists = (outcome.*measure).count();
+        if (stratum_lists == 0) {
+            continue;
+        }
+        const double weight = weights[h] / population;
+        estimate.estimate += weight * (outcome.*measure).mean();
+        const double finite_population_correction = 1.0 - static_cast<double>(sampler.sampled(h)) / sampler.population(h);
+        variance += weight * weight * (outcome.*measure).variance() / stratum_lists * finite_population_correction;
+    }
+    const double degrees_of_freedom = std::max(1.0, static_cast<double>(num_lists) - sampler.num_strata());
+    estimate.half_width = student_t_quantile(0.5 + confidence / 2, degrees_of_freedom) * std::sqrt(variance);
+    return estimate;
+}
+
+
+/**
+ * Computes the estimates of all tests with all pairs (n_cut, k) from the aggregations of the strata
+ * @param sampler The sampler
+ * @param strata_aggregations The aggregation of each stratum
+ * @param confidence The confidence level
+ * @return The estimates, in the order of the aggregations
+ */
+inline std::vector<TestEstimates>
+compute_stratified_estimates(const StratifiedSampler &sampler,
+                             const std::vector<std::unique_ptr<AssessmentAggregation>> &strata_aggregations,
+                             double confidence) {
+    const AssessmentAggregation &shape = *strata_aggregations[0];
+    std::vector<TestEstimates> estimates;
+    std::vector<const TestsAggregationOutcome *> outcomes(strata_aggregations.size());
+    for (std::size_t ni = 0; ni < shape.n_cut_list_size; ++ni) {
+        for (std::size_t ki = 0; ki < shape.k_list_size; ++ki) {
+            for (std::size_t t = 0; t <= shape.num_tests; ++t) {
+                for (std::size_t h = 0; h < strata_aggregations.size(); ++h) {
+                    outcomes[h] = (t == 0) ? &strata_aggregations[h]->outcome_opt(ni, ki) : &strata_aggregations[h]->outcome(ni, ki, t - 1);
+                }
+                TestEstimates test_estimates;
+                test_estimates.score = stratified_estimate(sampler, outcomes, &TestsAggregationOutcome::score, confidence);
+                test_estimates.approximation_error = stratified_estimate(sampler, outcomes, &TestsAggregationOutcome::approximation_error, confidence);
+                test_estimates.total_time = stratified_estimate(sampler, outcomes, &TestsAggregationOutcome::total_time, confidence);
+                estimates.push_back(test_estimates);
+            }
+        }
+    }
+    return estimates;
+}
+
+
+/**
+ * Checks whether the half widths of the confidence intervals of all estimates are within the targets
+ * @param estimates The estimates
+ * @param targets The targets
+ * @return True if all intervals are narrow enough
+ */
+inline bool
+within_sampling_targets(const std::vector<TestEstimates> &estimates, const SamplingTargets &targets) {
+    for (const TestEstimates &test_estimates: estimates) {
+        if (test_estimates.score.half_width > targets.score * std::abs(test_estimates.score.estimate) ||
+            test_estimates.approximation_error.half_width > targets.approximation_error ||
+            test_estimates.total_time.half_width > targets.total_time * std::abs(test_estimates.total_time.estimate)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+#endif //UTILS_SAMPLING_HPP
@@ -0,0 +1,218 @@
+#ifndef UTILS_STATISTICS_HPP
+#define UTILS_STATISTICS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+
+/**
+ * Summary of a sample: its size, mean and standard deviation.
+ */
+typedef struct {
+    /**
+     * Number of observations
+     */
+    std::size_t count = 0;
+    /**
+     * Mean of the observations
+     */
+    double mean = 0;
+    /**
+     * Sample standard deviation of the observations
+     */
+    double stddev = 0;
+} SampleSummary;
+
+
+/**
+ * Confidence interval of the difference between the means of two samples.
+ */
+typedef struct {
+    /**
+     * Difference between the mean of the second sample and the mean of the first one
+     */
+    double difference = 0;
+    /**
+     * Lower bound of the interval
+     */
+    double low = 0;
+    /**
+     * Upper bound of the interval
+     */
+    double high = 0;
+} DifferenceInterval;
+
+
+/**
+ * Computes the summary of a sample
+ * @param samples The observations
+ * @return The summary
+ */
+inline SampleSummary
+summarize_samples(const std::vector<double> &samples) {
+    SampleSummary summary;
+    summary.count = samples.size();
+    if (summary.count == 0) {
+        return summary;
+    }
+    for (double sample: samples) {
+        summary.mean += sample;
+    }
+    summary.mean /= summary.count;
+    if (summary.count > 1) {
+        double variance = 0;
+        for (double sample: samples) {
+            variance += (sample - summary.mean) * (sample - summary.mean);
+        }
+        summary.stddev = std::sqrt(variance / (summary.count - 1));
+    }
+    return summary;
+}
+
+
+/**
+ * Quantile function of the standard normal distribution, with the rational approximation by P. J. Acklam
+ * (relative error below 1.2e-9)
+ * @param p The probability, in the range (0, 1)
+ * @return The value z such that P(Z <= z) = p
+ */
+inline double
+normal_quantile(double p) {
+    if (p <= 0 || p >= 1) {
+        throw std::invalid_argument("The probability of the normal quantile must be in the range (0, 1)");
+    }
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    const double p_low = 0.02425;
+
+    if (p < p_low) {
+        const double q = std::sqrt(-2 * std::log(p));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+    }
+    if (p > 1 - p_low) {
+        return -normal_quantile(1 - p);
+    }
+    const double q = p - 0.5;
+    const double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
+
+/**
+ * Quantile function of the Student's t distribution, with the Cornish-Fisher expansion around the normal quantile
+ * (accurate to a few parts per thousand for at least 3 degrees of freedom). Below 3 degrees of freedom it is exact
+ * for the degrees of freedom rounded down to 1 or 2, which overestimates the quantiles of the fractional ones.
+ * @param p The probability, in the range (0, 1)
+ * @param df The degrees of freedom, at least 1, possibly infinite
+ * @return The value t such that P(T <= t) = p
+ */
+inline double
+student_t_quantile(double p, double df) {
+    if (df < 2) {
+        return std::tan(3.14159265358979323846 * (p - 0.5));
+    }
+    if (df < 3) {
+        return (2 * p - 1) / std::sqrt(2 * p * (1 - p));
+    }
+    const double z = normal_quantile(p);
+    if (!(df < std::numeric_limits<double>::infinity())) {
+        return z;
+    }
+    const double z2 = z * z;
+    return z
+           + z * (z2 + 1) / (4 * df)
+           + z * ((5 * z2 + 16) * z2 + 3) / (96 * df * df)
+           + z * (((3 * z2 + 19) * z2 + 17) * z2 - 15) / (384 * df * df * df)
+           + z * ((((79 * z2 + 776) * z2 + 1482) * z2 - 1920) * z2 - 945) / (92160 * df * df * df * df);
+}
+
+
+/**
+ * Computes the Welch confidence interval of the difference between the means of two independent samples, which
+ * does not assume that the samples have the same variance.
+ * A sample of a single observation does not estimate its variance, thus the interval is infinite; two samples of
+ * identical observations have a zero-width interval.
+ * @param first The summary of the first sample
+ * @param second The summary of the second sample
+ * @param confidence The confidence level, in the range (0, 1)
+ * @return The interval of the difference between the mean of the second sample and the mean of the first one
+ */
+inline DifferenceInterval
+welch_interval(const SampleSummary &first, const SampleSummary &second, double confidence) {
+    if (first.count == 0 || second.count == 0) {
+        throw std::invalid_argument("Unable to compare empty samples");
+    }
+    DifferenceInterval interval;
+    interval.difference = second.mean - first.mean;
+    if (first.count < 2 || second.count < 2) {
+        interval.low = -std::numeric_limits<double>::infinity();
+        interval.high = std::numeric_limits<double>::infinity();
+        return interval;
+    }
+
+    const double v1 = first.stddev * first.stddev / first.count;
+    const double v2 = second.stddev * second.stddev / second.count;
+    const double standard_error = std::sqrt(v1 + v2);
+    if (standard_error == 0) {
+        interval.low = interval.high = interval.difference;
+        return interval;
+    }
+
+    // Welch-Satterthwaite degrees of freedom
+    const double df = (v1 + v2) * (v1 + v2) / (v1 * v1 / (first.count - 1) + v2 * v2 / (second.count - 1));
+
+    const double t = student_t_quantile(0.5 + confidence / 2, std::max(1.0, df));
+    interval.low = interval.difference - t * standard_error;
+    interval.high = interval.difference + t * standard_error;
+    return interval;
+}
+
+
+/**
+ * Computes the confidence interval of the mean difference between paired observations, e.g., the times of the same
+ * lists measured with two builds, whose differences cancel the variability among the lists.
+ * Less than two pairs do not estimate the variance of the differences, thus the interval is infinite; identical
+ * differences have a zero-width interval.
+ * @param first The observations of the first sample
+ * @param second The observations of the second sample, paired with the ones of the first sample
+ * @param confidence The confidence level, in the range (0, 1)
+ * @return The interval of the mean difference between the second sample and the first one
+ */
+inline DifferenceInterval
+paired_interval(const std::vector<double> &first, const std::vector<double> &second, double confidence) {
+    if (first.size() != second.size() || first.empty()) {
+        throw std::invalid_argument("Unable to compare empty or unpaired samples");
+    }
+    std::vector<double> differences(first.size());
+    for (std::size_t i = 0; i < first.size(); ++i) {
+        differences[i] = second[i] - first[i];
+    }
+    const SampleSummary summary = summarize_samples(differences);
+
+    DifferenceInterval interval;
+    interval.difference = summary.mean;
+    if (summary.count < 2) {
+        interval.low = -std::numeric_limits<double>::infinity();
+        interval.high = std::numeric_limits<double>::infinity();
+        return interval;
+    }
+    const double standard_error = summary.stddev / std::sqrt(static_cast<double>(summary.count));
+    const double t = student_t_quantile(0.5 + confidence / 2, static_cast<double>(summary.count - 1));
+    interval.low = interval.difference - t * standard_error;
+    interval.high = interval.difference + t * standard_error;
+    return interval;
+}
+
+
+#endif //UTILS_STATISTICS_HPP
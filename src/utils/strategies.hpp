@@ -0,0 +1,92 @@
+#ifndef UTILS_STRATEGIES_HPP
+#define UTILS_STRATEGIES_HPP
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "../filters/filter_spirin.hpp"
+#include "../pruners/pruner_cutoff.hpp"
+#include "../pruners/pruner_epspruning.hpp"
+#include "../pruners/pruner_topk.hpp"
+#include "composition.hpp"
+
+
+/**
+ * Gets the name of the test of a filtering strategy, as reported by the tools
+ * @param strategy The strategy: opt, cutoff, topk, or epsfiltering
+ * @param epsilon The approximation factor, used only by epsfiltering
+ * @return The name of the test
+ */
+inline std::string
+strategy_test_name(const std::string &strategy, score_type epsilon) {
+    if (strategy == "opt") {
+        return "OPT";
+    } else if (strategy == "cutoff") {
+        return "Cutoff-OPT";
+    } else if (strategy == "topk") {
+        return "Topk-OPT";
+    } else if (strategy == "epsfiltering") {
+        std::ostringstream name; name << "EpsFiltering (epsilon=" << epsilon << ")";
+        return name.str();
+    }
+    throw std::runtime_error(std::string("Unknown filtering strategy ") + strategy);
+}
+
+
+/**
+ * Gets the filtering strategy of a test from its name
+ * @param name The name of the test, as returned by strategy_test_name
+ * @return The strategy: opt, cutoff, topk, or epsfiltering
+ */
+inline std::string
+strategy_of_test_name(const std::string &name) {
+    if (name == "OPT") {
+        return "opt";
+    } else if (name == "Cutoff-OPT") {
+        return "cutoff";
+    } else if (name == "Topk-OPT") {
+        return "topk";
+    } else if (name.compare(0, 12, "EpsFiltering") == 0) {
+        return "epsfiltering";
+    }
+    throw std::runtime_error(std::string("Unknown filtering strategy of the test ") + name);
+}
+
+
+/**
+ * Builds the composition test of a filtering strategy, i.e., the optimal filter preceded by the pruner of the strategy
+ * @tparam ScoreFun Score function type
+ * @param strategy The strategy: opt, cutoff, topk, or epsfiltering
+ * @param score_fun The score function
+ * @param filter The optimal filter@k
+ * @param epsilon The approximation factor, used only by epsfiltering
+ * @param num_runs The number of runs each test must be repeated
+ * @return The composition test
+ */
+template <typename ScoreFun>
+std::shared_ptr<PrunerFilterCompositionTest<ScoreFun>>
+make_strategy_test(
+        const std::string &strategy,
+        const std::shared_ptr<ScoreFun> &score_fun,
+        const std::shared_ptr<Filter<ScoreFun>> &filter,
+        score_type epsilon,
+        int num_runs
+) {
+    typedef PrunerFilterCompositionTest<ScoreFun> composition_test;
+    const std::string name = strategy_test_name(strategy, epsilon);
+    const k_type k = filter->k;
+
+    if (strategy == "opt") {
+        return std::make_shared<composition_test>(name, nullptr, filter, num_runs);
+    } else if (strategy == "cutoff") {
+        return std::make_shared<composition_test>(name, std::make_shared<PrunerCutoff<ScoreFun>>(score_fun), filter, num_runs, 1.0);
+    } else if (strategy == "topk") {
+        return std::make_shared<composition_test>(name, std::make_shared<PrunerTopk<ScoreFun>>(score_fun, k), filter, num_runs, 0.5);
+    }
+    // epsfiltering
+    return std::make_shared<composition_test>(name, std::make_shared<PrunerEpsPruning<ScoreFun>>(score_fun, k, epsilon), filter, num_runs, epsilon);
+}
+
+
+#endif //UTILS_STRATEGIES_HPP
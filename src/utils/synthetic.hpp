@@ -0,0 +1,161 @@
+#ifndef UTILS_SYNTHETIC_HPP
+#define UTILS_SYNTHETIC_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "utils.hpp"
+
+
+/**
+ * Configuration of the synthetic lists of relevances.
+ */
+typedef struct {
+    /**
+     * Distribution of the relevances: uniform, zipf, graded, or adversarial
+     */
+    std::string distribution = "uniform";
+    /**
+     * Number of elements of each list
+     */
+    index_type length = 1000;
+    /**
+     * Maximum relevance of the elements
+     */
+    double max_relevance = 4.0;
+    /**
+     * Exponent of the zipf distribution
+     */
+    double zipf_exponent = 1.0;
+    /**
+     * Number of relevance labels of the graded distribution
+     */
+    int grades = 5;
+    /**
+     * Fraction of the list, from its beginning, sorted by decreasing relevance, in the range [0, 1]
+     */
+    double sortedness = 0.0;
+} SyntheticListConfig;
+
+
+/**
+ * Checks the configuration of the synthetic lists
+ * @param config The configuration to check
+ */
+inline void
+check_synthetic_list_config(const SyntheticListConfig &config) {
+    if (config.distribution != "uniform" && config.distribution != "zipf" &&
+        config.distribution != "graded" && config.distribution != "adversarial") {
+        throw std::runtime_error(std::string("Unknown distribution of the synthetic lists ") + config.distribution);
+    }
+    if (config.length == 0) {
+        throw std::runtime_error("The length of the synthetic lists must be a number strictly greater than 0");
+    }
+    if (config.max_relevance <= 0) {
+        throw std::runtime_error("The maximum relevance of the synthetic lists must be a number strictly greater than 0");
+    }
+    if (config.zipf_exponent <= 0) {
+        throw std::runtime_error("The zipf exponent must be a number strictly greater than 0");
+    }
+    if (config.grades <= 0) {
+        throw std::runtime_error("The number of grades must be a number strictly greater than 0");
+    }
+    if (config.sortedness < 0 || config.sortedness > 1) {
+        throw std::runtime_error("The sortedness must be a number between zero and one");
+    }
+}
+
+
+/**
+ * Generates a synthetic list of strictly positive relevances, ordered by an implicit attribute (the position).
+ *
+ * - uniform: relevances uniformly distributed in (0, max_relevance]
+ * - zipf: max_relevance / X, where X follows a zipf distribution over [1, length]
+ * - graded: labels g * max_relevance / grades, where g in [1, grades] and each label is twice as frequent as the next
+ * - adversarial: relevances decreasing geometrically from max_relevance to max_relevance / length along the list, i.e.,
+ *   increasing in the order scanned by the pruners, so that the heap minimum rises slowly through all the intervals of
+ *   eps-pruning and the pruners keep as many elements as possible
+ *
+ * The sortedness is the fraction of the list, starting from its beginning, sorted by decreasing relevance: zero keeps the
+ * order of the distribution, one sorts the whole list. The adversarial lists are already sorted.
+ * @param config The configuration of the list
+ * @param random_engine The random engine
+ * @return The relevances
+ */
+template <typename RandomEngine>
+std::vector<relevance_type>
+generate_synthetic_list(const SyntheticListConfig &config, RandomEngine &random_engine) {
+    const index_type n = config.length;
+    std::vector<relevance_type> relevances(n);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    if (config.distribution == "uniform") {
+        for (index_type i = 0; i < n; ++i) {
+            relevances[i] = static_cast<relevance_type>(config.max_relevance * (1.0 - uniform(random_engine)));
+        }
+    } else if (config.distribution == "zipf") {
+        // inverse transform sampling of the continuous power law over [1, n + 1), truncated to integers
+        const double s = config.zipf_exponent;
+        const double upper = static_cast<double>(n) + 1;
+        for (index_type i = 0; i < n; ++i) {
+            const double u = uniform(random_engine);
+            double x;
+            if (std::abs(s - 1.0) < 1e-9) {
+                x = std::exp(u * std::log(upper));
+            } else {
+                x = std::pow(1.0 + u * (std::pow(upper, 1.0 - s) - 1.0), 1.0 / (1.0 - s));
+            }
+            relevances[i] = static_cast<relevance_type>(config.max_relevance / std::max(1.0, std::floor(x)));
+        }
+    } else if (config.distribution == "graded") {
+        // label g has probability proportional to 2^-(g-1)
+        const double norm = 1.0 - std::pow(0.5, config.grades);
+        for (index_type i = 0; i < n; ++i) {
+            const double u = uniform(random_engine) * norm;
+            int g = 1;
+            for (double cumulative = 0.5; g < config.grades && u >= cumulative; cumulative += std::pow(0.5, ++g)) {
+            }
+            relevances[i] = static_cast<relevance_type>(config.max_relevance * g / config.grades);
+        }
+    } else {
+        // adversarial
+        const double ratio = (n > 1) ? std::pow(1.0 / n, 1.0 / (n - 1)) : 1.0;
+        double relevance = config.max_relevance;
+        for (index_type i = 0; i < n; ++i) {
+            relevances[i] = static_cast<relevance_type>(relevance);
+            relevance *= ratio;
+        }
+    }
+
+    // sort the first part of the list
+    if (config.sortedness > 0) {
+        const index_type num_sorted = static_cast<index_type>(std::round(config.sortedness * n));
+        std::sort(relevances.begin(), relevances.begin() + num_sorted, std::greater<relevance_type>());
+    }
+
+    return relevances;
+}
+
+
+/**
+ * Writes a synthetic list in the tsv format read by read_results_list, using the position as id and attribute
+ * @param os The output stream where to write
+ * @param relevances The relevances
+ */
+inline void
+write_synthetic_list_tsv(std::ostream &os, const std::vector<relevance_type> &relevances) {
+    const std::streamsize precision = os.precision(std::numeric_limits<relevance_type>::max_digits10);
+    for (std::size_t i = 0; i < relevances.size(); ++i) {
+        os << "d" << i << "\t" << i << "\t" << relevances[i] << "\n";
+    }
+    os.precision(precision);
+}
+
+
+#endif //UTILS_SYNTHETIC_HPP
@@ -0,0 +1,248 @@
+#ifndef UTILS_THREAD_POOL_HPP
+#define UTILS_THREAD_POOL_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "utils.hpp"
+
+
+/**
+ * Pool of worker threads executing the submitted tasks by means of work stealing.
+ * Each worker owns a queue of tasks and, when its queue is empty, it steals the tasks from the queues of the other
+ * workers. Both the owner and the thieves take the oldest task of a queue, so that the tasks complete approximately
+ * in the same order they have been submitted.
+ */
+class WorkStealingPool {
+public:
+    /**
+     * Type of the tasks. Each task receives the id of the worker executing it, in the range [0, num_threads).
+     */
+    typedef std::function<void(std::size_t)> task_type;
+
+    /**
+     * Constructor
+     * @param num_threads Number of worker threads
+     * @param cpu_list List of cpus where to pin the workers, the i-th worker is pinned to cpu_list[i]. When empty, the
+     * workers are not pinned
+     */
+    WorkStealingPool(std::size_t num_threads, const std::vector<int> &cpu_list = std::vector<int>()) {
+        if (num_threads == 0) {
+            throw std::invalid_argument("The parameter num_threads must be a strictly positive number");
+        }
+        if (!cpu_list.empty() && cpu_list.size() < num_threads) {
+            throw std::invalid_argument("The parameter cpu_list must contain at least one cpu per thread");
+        }
+
+        for (std::size_t i = 0; i < num_threads; ++i) {
+            this->queues.emplace_back(new worker_queue());
+        }
+        for (std::size_t i = 0; i < num_threads; ++i) {
+            int cpu = cpu_list.empty() ? -1 : cpu_list[i];
+            this->threads.emplace_back(&WorkStealingPool::worker_loop, this, i, cpu);
+        }
+    }
+
+    /**
+     * Destructor. It waits the completion of all submitted tasks.
+     */
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stop = true;
+        }
+        this->cv_task.notify_all();
+        for (std::thread &thread: this->threads) {
+            thread.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool & operator=(const WorkStealingPool &) = delete;
+
+    /**
+     * Number of worker threads
+     * @return The number of worker threads
+     */
+    std::size_t
+    size() const {
+        return this->threads.size();
+    }
+
+    /**
+     * Submits a task to the pool, distributing the tasks among the workers in round robin
+     * @param task The task to execute
+     */
+    void
+    submit(task_type task) {
+        std::size_t worker_id = this->next_worker;
+        this->next_worker = (this->next_worker + 1) % this->size();
+        this->submit(worker_id, std::move(task));
+    }
+
+    /**
+     * Submits a task to the queue of the given worker
+     * @param worker_id The worker owning the task
+     * @param task The task to execute
+     */
+    void
+    submit(std::size_t worker_id, task_type task) {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            ++this->num_queued;
+            ++this->num_pending;
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->queues[worker_id]->mutex);
+            this->queues[worker_id]->tasks.push_back(std::move(task));
+        }
+        this->cv_task.notify_one();
+    }
+
+    /**
+     * Waits the completion of all submitted tasks.
+     * If a task has thrown an exception, the first one is rethrown.
+     */
+    void
+    wait() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->cv_done.wait(lock, [this]() { return this->num_pending == 0; });
+        this->rethrow_exception();
+    }
+
+    /**
+     * Waits the completion of all submitted tasks for at most the given amount of time.
+     * If a task has thrown an exception, the first one is rethrown.
+     * @param timeout Maximum time to wait
+     * @return True if all tasks are completed, false otherwise
+     */
+    template <typename Rep, typename Period>
+    bool
+    wait_for(const std::chrono::duration<Rep, Period> &timeout) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if (!this->cv_done.wait_for(lock, timeout, [this]() { return this->num_pending == 0; })) {
+            return false;
+        }
+        this->rethrow_exception();
+        return true;
+    }
+
+private:
+    /**
+     * Queue of tasks owned by a worker
+     */
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<task_type> tasks;
+    };
+
+    /**
+     * Takes the oldest task from the queue of the given worker
+     * @param worker_id The worker owning the queue
+     * @param task Where to move the task
+     * @return True if a task has been taken, false if the queue is empty
+     */
+    bool
+    try_take(std::size_t worker_id, task_type &task) {
+        worker_queue &queue = *(this->queues[worker_id]);
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    /**
+     * Main loop of a worker: it executes its own tasks first, then it steals the tasks from the other workers
+     * @param worker_id The id of the worker
+     * @param cpu The cpu where to pin the worker, if non-negative
+     */
+    void
+    worker_loop(std::size_t worker_id, int cpu) {
+        if (cpu >= 0) {
+            try {
+                set_cpu_affinity(cpu);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                if (!this->exception) {
+                    this->exception = std::current_exception();
+                }
+            }
+        }
+
+        const std::size_t num_workers = this->queues.size();
+        while (true) {
+            task_type task;
+            bool found = false;
+            for (std::size_t i = 0; i < num_workers && !found; ++i) {
+                found = this->try_take((worker_id + i) % num_workers, task);
+            }
+
+            if (found) {
+                {
+                    std::lock_guard<std::mutex> lock(this->mutex);
+                    --this->num_queued;
+                }
+                try {
+                    task(worker_id);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(this->mutex);
+                    if (!this->exception) {
+                        this->exception = std::current_exception();
+                    }
+                }
+                {
+                    std::lock_guard<std::mutex> lock(this->mutex);
+                    if (--this->num_pending == 0) {
+                        this->cv_done.notify_all();
+                    }
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->cv_task.wait(lock, [this]() { return this->stop || this->num_queued > 0; });
+            if (this->stop && this->num_queued == 0) {
+                return;
+            }
+        }
+    }
+
+    /**
+     * Rethrows the first exception thrown by a task, if any. The caller must own the lock on mutex.
+     */
+    void
+    rethrow_exception() {
+        if (this->exception) {
+            std::exception_ptr exception = this->exception;
+            this->exception = nullptr;
+            std::rethrow_exception(exception);
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<worker_queue>> queues;
+    std::vector<std::thread> threads;
+    std::size_t next_worker = 0;
+
+    // the following members are protected by mutex
+    std::mutex mutex;
+    std::condition_variable cv_task;
+    std::condition_variable cv_done;
+    std::size_t num_queued = 0;
+    std::size_t num_pending = 0;
+    bool stop = false;
+    std::exception_ptr exception;
+};
+
+
+#endif //UTILS_THREAD_POOL_HPP
@@ -0,0 +1,252 @@
+#ifndef UTILS_TRACE_HPP
+#define UTILS_TRACE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "utils.hpp"
+
+
+/**
+ * A span of time recorded by the tracer, with the attributes of the list and of the strategy it refers to.
+ */
+typedef struct {
+    /**
+     * Name of the span (e.g., read, minmax, prune, gather, filter, output)
+     */
+    const char *name;
+    /**
+     * Name of the strategy, or nullptr
+     */
+    const char *strategy;
+    /**
+     * Start time, in nanoseconds since the tracer has been enabled
+     */
+    std::uint64_t start;
+    /**
+     * Duration in nanoseconds
+     */
+    std::uint64_t duration;
+    /**
+     * Id of the list, or -1
+     */
+    std::int64_t list_id;
+    /**
+     * Number of elements, or -1
+     */
+    std::int64_t n;
+    /**
+     * Number of elements to select, or -1
+     */
+    std::int64_t k;
+    /**
+     * Approximation factor, or a negative number
+     */
+    double epsilon;
+} TraceEvent;
+
+
+/**
+ * Recorder of spans in the Chrome trace-event format, which can be opened by chrome://tracing and Perfetto.
+ * Each thread appends its spans to its own buffer without any synchronization, and the buffers are written at the end.
+ * When the tracer is disabled, recording a span costs a single branch.
+ */
+class TraceRecorder {
+public:
+    /**
+     * Enables the recording of the spans. It must be called before starting the threads to trace
+     */
+    static void
+    enable() {
+        TraceRecorder &recorder = TraceRecorder::instance();
+        recorder.origin = get_time_nanoseconds();
+        recorder.enabled_ = true;
+    }
+
+    /**
+     * Checks whether the recording is enabled
+     */
+    static bool
+    enabled() {
+        return TraceRecorder::instance().enabled_;
+    }
+
+    /**
+     * Gets the current time, relative to the moment the tracer has been enabled
+     * @return The time in nanoseconds
+     */
+    static std::uint64_t
+    now() {
+        return get_time_nanoseconds() - TraceRecorder::instance().origin;
+    }
+
+    /**
+     * Sets the list processed by the calling thread, used to tag the spans that do not specify it. The spans of the
+     * lists whose stages may run on other threads, e.g., on a pool, must specify it instead
+     * @param list_id The id of the list, or -1
+     */
+    static void
+    set_current_list(std::int64_t list_id) {
+        if (TraceRecorder::enabled()) {
+            TraceRecorder::thread_buffer().current_list_id = list_id;
+        }
+    }
+
+    /**
+     * Appends a span to the buffer of the calling thread
+     * @param event The span to append. If its list id is -1, the current list of the thread is used
+     */
+    static void
+    record(TraceEvent event) {
+        thread_buffer_type &buffer = TraceRecorder::thread_buffer();
+        if (event.list_id < 0) {
+            event.list_id = buffer.current_list_id;
+        }
+        buffer.events.push_back(event);
+    }
+
+    /**
+     * Writes all spans recorded so far as a json trace-event document
+     * @param os The output stream where to write
+     */
+    static void
+    write(std::ostream &os) {
+        TraceRecorder &recorder = TraceRecorder::instance();
+        std::lock_guard<std::mutex> lock(recorder.buffers_mutex);
+
+        // timestamps in microseconds with nanosecond resolution
+        const std::ios_base::fmtflags flags = os.flags();
+        const std::streamsize precision = os.precision(3);
+        os << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+        bool first = true;
+        for (std::size_t tid = 0; tid < recorder.buffers.size(); ++tid) {
+            os << (first ? "" : ",") << std::endl;
+            os << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << tid
+               << ", \"args\": {\"name\": \"thread " << tid << "\"}}";
+            first = false;
+
+            for (const TraceEvent &event: recorder.buffers[tid]->events) {
+                os << "," << std::endl;
+                os << "{\"name\": \"" << event.name << "\", \"cat\": \"filtering\", \"ph\": \"X\"";
+                os << std::fixed << ", \"ts\": " << event.start / 1000.0 << ", \"dur\": " << event.duration / 1000.0;
+                os.flags(flags);
+                os << ", \"pid\": 1, \"tid\": " << tid << ", \"args\": {";
+                os << "\"list\": " << event.list_id;
+                if (event.strategy != nullptr) {
+                    os << ", \"strategy\": "; write_json_string(os, event.strategy);
+                }
+                if (event.n >= 0) {
+                    os << ", \"n\": " << event.n;
+                }
+                if (event.k >= 0) {
+                    os << ", \"k\": " << event.k;
+                }
+                if (event.epsilon >= 0) {
+                    os << ", \"epsilon\": " << event.epsilon;
+                }
+                os << "}}";
+            }
+        }
+        os << std::endl << "]}" << std::endl;
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+private:
+    typedef struct {
+        std::vector<TraceEvent> events;
+        std::int64_t current_list_id;
+    } thread_buffer_type;
+
+    static TraceRecorder &
+    instance() {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    /**
+     * Gets the buffer of the calling thread, registering it at the first call.
+     * The buffers are owned by the recorder, so they survive the threads.
+     */
+    static thread_buffer_type &
+    thread_buffer() {
+        static thread_local thread_buffer_type *buffer = nullptr;
+        if (buffer == nullptr) {
+            TraceRecorder &recorder = TraceRecorder::instance();
+            std::lock_guard<std::mutex> lock(recorder.buffers_mutex);
+            recorder.buffers.emplace_back(new thread_buffer_type());
+            buffer = recorder.buffers.back().get();
+            buffer->events.reserve(1 << 16);
+            buffer->current_list_id = -1;
+        }
+        return *buffer;
+    }
+
+private:
+    bool enabled_ = false;
+    std::uint64_t origin = 0;
+    std::mutex buffers_mutex;
+    std::vector<std::unique_ptr<thread_buffer_type>> buffers;
+};
+
+
+/**
+ * Records a span from its construction to its destruction, if the tracer is enabled.
+ */
+class TraceSpan {
+public:
+    /**
+     * Starts a span
+     * @param name The name of the span, which must outlive the tracer
+     * @param n Number of elements, or -1
+     * @param k Number of elements to select, or -1
+     * @param epsilon Approximation factor, or a negative number
+     * @param strategy The name of the strategy, which must outlive the tracer, or nullptr
+     * @param list_id The id of the list, or -1 to use the current list of the thread
+     */
+    TraceSpan(const char *name, std::int64_t n=-1, std::int64_t k=-1, double epsilon=-1, const char *strategy=nullptr, std::int64_t list_id=-1) :
+            active(TraceRecorder::enabled()) {
+        if (this->active) {
+            this->event.name = name;
+            this->event.strategy = strategy;
+            this->event.list_id = list_id;
+            this->event.n = n;
+            this->event.k = k;
+            this->event.epsilon = epsilon;
+            this->event.start = TraceRecorder::now();
+        }
+    }
+
+    /**
+     * Ends the span, if not already ended
+     */
+    ~TraceSpan() {
+        this->end();
+    }
+
+    /**
+     * Ends the span before its destruction
+     */
+    void
+    end() {
+        if (this->active) {
+            this->event.duration = TraceRecorder::now() - this->event.start;
+            TraceRecorder::record(this->event);
+            this->active = false;
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan & operator=(const TraceSpan &) = delete;
+
+private:
+    bool active;
+    TraceEvent event;
+};
+
+
+#endif //UTILS_TRACE_HPP
@@ -3,24 +3,97 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cmath>
 #include <cfloat>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <sched.h>
 #include <sstream>
-#include <sys/time.h>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 #include <numeric>
 #include "../filtering/types.hpp"
 
 
 /**
- * Gets the distance in milliseconds since the Epoch, 1970-01-01 00:00:00 +0000 (UTC).
- * @return The distance in milliseconds since the Epoch
+ * Gets the time in nanoseconds elapsed since an arbitrary instant, using a monotonic clock.
+ * @return The time in nanoseconds
+ */
+inline std::uint64_t
+get_time_nanoseconds() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+
+/**
+ * Gets the time in milliseconds elapsed since an arbitrary instant, using a monotonic clock.
+ * @return The time in milliseconds
  */
 inline double
 get_time_milliseconds() {
-    timeval tv;
-    gettimeofday(&tv, nullptr);
-    return (double(tv.tv_sec) * 1000000 + double(tv.tv_usec)) / 1000.0;
+    return get_time_nanoseconds() / 1000000.0;
+}
+
+
+/**
+ * Gets the overhead in nanoseconds of a time measurement, i.e., the minimum time measured between two consecutive
+ * calls of get_time_nanoseconds. The overhead is measured only once.
+ * @return The overhead in nanoseconds
+ */
+inline std::uint64_t
+timer_overhead_nanoseconds() {
+    static const std::uint64_t overhead = []() {
+        std::uint64_t min_overhead = static_cast<std::uint64_t>(-1);
+        for (int i = 0; i < 10000; ++i) {
+            std::uint64_t start = get_time_nanoseconds();
+            std::uint64_t end = get_time_nanoseconds();
+            min_overhead = std::min(min_overhead, end - start);
+        }
+        return min_overhead;
+    }();
+    return overhead;
+}
+
+
+/**
+ * Gets the time in milliseconds elapsed between two instants measured with get_time_nanoseconds, net of the overhead
+ * of the time measurement.
+ * @param start The first instant, in nanoseconds
+ * @param end The second instant, in nanoseconds
+ * @return The elapsed time in milliseconds
+ */
+inline double
+get_elapsed_milliseconds(std::uint64_t start, std::uint64_t end) {
+    const std::uint64_t overhead = timer_overhead_nanoseconds();
+    return (end - start > overhead) ? (end - start - overhead) / 1000000.0 : 0.0;
+}
+
+
+/**
+ * Sets the cpu affinity of the calling thread.
+ * @param cpu The id of the cpu where the thread must run
+ */
+inline void
+set_cpu_affinity(int cpu) {
+#ifdef __linux__
+    cpu_set_t mask;
+    int status;
+
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    status = sched_setaffinity(0, sizeof(mask), &mask);
+    if (status != 0) {
+        throw std::runtime_error(std::string("Unable to set the cpu affinity: ") + std::strerror(errno));
+    }
+#else
+    (void)(cpu); // to suppress the unused parameter warning
+    throw std::runtime_error("The cpu affinity can be set only on linux");
+#endif
 }
 
 
@@ -183,14 +256,30 @@ void apply_permutation_in_place(
 class ResultsList {
 public:
     ResultsList(std::vector<std::string> && ids, std::vector<double> && attributes, std::vector<relevance_type > && relevances) :
-            ids(ids),
-            attributes(attributes),
-            relevances(relevances) {
-        if (ids.size() != attributes.size() or attributes.size() != relevances.size()) {
+            ids(std::move(ids)),
+            attributes(std::move(attributes)),
+            relevances(std::move(relevances)) {
+        if (this->ids.size() != this->attributes.size() or this->attributes.size() != this->relevances.size()) {
             throw std::runtime_error("The arguments ids, attributes and relevances must have the same size");
         }
     }
 
+    /**
+     * Constructor of a list without ids and attributes, e.g., a synthetic one, ordered by the position of the elements
+     * @param relevances The relevances of the elements
+     */
+    explicit ResultsList(std::vector<relevance_type> && relevances) :
+            relevances(std::move(relevances)) {
+    }
+
+    /**
+     * Checks whether the list has the ids and the attributes of its elements
+     */
+    bool
+    has_ids() const {
+        return !this->ids.empty() || this->relevances.empty();
+    }
+
     std::size_t
     size() const {
         return this->relevances.size();